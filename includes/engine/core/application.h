@@ -5,6 +5,7 @@
 #include <memory>
 #include <vector>
 
+#include <engine/core/asset_manager.h>
 #include <engine/graphic/shader.h>
 #include <engine/graphic/camera.h>
 #include <engine/ecs/component.h>
@@ -32,6 +33,7 @@ private:
 
     float deltaTime = 0.0f;
     float lastFrame = 0.0f;
+    float statsTimer = 0.0f;
 
     KeyboardManager keyboardManager;
     MouseManager mouseManager;
@@ -39,17 +41,25 @@ private:
     std::unique_ptr<PhysicsWorld> physicsWorld;
     Scene scene;
     PhysicsSystem physicsSystem;
+    BoundsSystem boundsSystem;
     RenderSystem renderSystem;
     AnimationSystem animationSystem;
     CameraSystem cameraSystem;
+    FrameConstantsSystem frameConstantsSystem;
     CameraControlSystem cameraControlSystem;
     UIInteractSystem uiInteractSystem;
     UIRenderSystem uiRenderSystem;
 
     // Resources (giữ shader để dùng trong loop)
-    std::unique_ptr<Shader> modelShader;
-    std::unique_ptr<Shader> uiShader;
+    ShaderHandle modelShader;
+    ShaderHandle uiShader;
+    ModelHandle playerModel;
+    AnimationHandle playerAnimation;
+    entt::entity playerEntity = entt::null;
 
     std::unique_ptr<UIModel> buttonModel;
     std::unique_ptr<UIModel> imageModel;
+
+    void ResolvePendingAssets();
+    void UpdateStatsTitle();
 };
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <engine/core/mapped_file.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Every cooked file starts with this; a file whose hashes do not match is simply cooked again
+struct CookedHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t sourceHash;
+    std::uint64_t settingsHash;
+};
+
+// Appends plain fields and bulk arrays. Arrays are padded to 16 bytes from the start of the
+// file, so once the file is mapped they can be handed to GL without copying.
+class CookedWriter
+{
+public:
+    static constexpr std::size_t ARRAY_ALIGNMENT = 16;
+
+    template <typename T>
+    void Write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "cooked fields must be trivially copyable");
+        WriteBytes(&value, sizeof(T));
+    }
+    void WriteBytes(const void *data, std::size_t size);
+    void WriteString(const std::string &value);
+    void WriteArray(const void *data, std::size_t size);
+
+    const std::vector<unsigned char> &GetData() const { return m_Data; }
+    // Writes next to the destination and renames, so a crash never leaves a half written asset
+    bool Save(const std::string &path) const;
+
+private:
+    std::vector<unsigned char> m_Data;
+};
+
+// Reads back what CookedWriter wrote. Reading past the end marks the reader failed and returns
+// zeroes instead, so loaders check IsValid() once before acting on anything they read.
+class CookedReader
+{
+public:
+    CookedReader() = default;
+    CookedReader(const unsigned char *data, std::size_t size) : m_Data(data), m_Size(size) {}
+
+    template <typename T>
+    T Read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "cooked fields must be trivially copyable");
+        T value{};
+        ReadBytes(&value, sizeof(T));
+        return value;
+    }
+    void ReadBytes(void *data, std::size_t size);
+    std::string ReadString();
+    // Points into the underlying data; null if the array runs past the end
+    const unsigned char *ReadArray(std::size_t size);
+
+    bool IsValid() const { return !m_Failed; }
+
+private:
+    const unsigned char *m_Data = nullptr;
+    std::size_t m_Size = 0;
+    std::size_t m_Position = 0;
+    bool m_Failed = false;
+
+    bool Reserve(std::size_t size);
+};
+
+class AssetCooker
+{
+public:
+    // Bump whenever a cooked layout changes
+    static constexpr std::uint32_t VERSION = 1;
+
+    static std::uint64_t HashBytes(const void *data, std::size_t size, std::uint64_t seed = 0);
+    // Hash of the file's contents, computed once per path and run; 0 if it cannot be read
+    static std::uint64_t HashFile(const std::string &path);
+
+    // Cooked files live under resources/cooked, named after what they were cooked from
+    static std::string GetCookedPath(std::uint64_t sourceHash, std::uint64_t settingsHash, const char *extension);
+
+    static void WriteHeader(CookedWriter &writer, std::uint32_t magic, std::uint64_t sourceHash, std::uint64_t settingsHash);
+    // Maps a cooked file and checks its header; on success the reader is positioned after it
+    static bool Open(const std::string &cookedPath, std::uint32_t magic, std::uint64_t sourceHash,
+                     std::uint64_t settingsHash, MappedFile &file, CookedReader &reader);
+
+private:
+    static std::mutex s_HashMutex;
+    static std::unordered_map<std::string, std::uint64_t> s_FileHashes;
+};
@@ -0,0 +1,368 @@
+#pragma once
+
+#include <entt/core/hashed_string.hpp>
+#include <entt/resource/cache.hpp>
+
+#include <engine/core/job_system.h>
+#include <engine/graphic/animation.h>
+#include <engine/graphic/model.h>
+#include <engine/graphic/shader.h>
+#include <engine/graphic/texture_2d.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Slot index plus the slot's generation when the handle was made. Once the asset is unloaded
+// the generation moves on, so a stale handle resolves to null instead of whatever reuses the slot.
+template <typename Type>
+struct AssetHandle
+{
+    static constexpr std::uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+    std::uint32_t index = INVALID_INDEX;
+    std::uint32_t generation = 0;
+
+    bool IsValid() const { return index != INVALID_INDEX; }
+    bool operator==(const AssetHandle &other) const = default;
+};
+
+using ModelHandle = AssetHandle<Model>;
+using AnimationHandle = AssetHandle<Animation>;
+using ShaderHandle = AssetHandle<Shader>;
+using TextureHandle = AssetHandle<Texture2D>;
+
+// Loaders for entt::resource_cache. Measure is what an asset counts against the memory budget.
+// Every loader also accepts an asset that was already built, which is how asynchronous loads
+// hand their result to the cache.
+template <typename Type>
+struct AssetLoader
+{
+    using result_type = std::shared_ptr<Type>;
+    result_type operator()(result_type asset) const { return asset; }
+};
+
+struct ModelLoader : AssetLoader<Model>
+{
+    using AssetLoader<Model>::operator();
+    result_type operator()(const std::string &path, bool gamma, const MeshLodSettings &lodSettings) const;
+    static std::size_t Measure(const Model &model) { return model.GetGpuBytes(); }
+};
+
+struct AnimationLoader : AssetLoader<Animation>
+{
+    using AssetLoader<Animation>::operator();
+    result_type operator()(const std::string &path, Model *model) const;
+    static std::size_t Measure(const Animation &) { return 0; }
+};
+
+struct ShaderLoader : AssetLoader<Shader>
+{
+    using AssetLoader<Shader>::operator();
+    result_type operator()(const std::string &vertexPath, const std::string &fragmentPath) const;
+    static std::size_t Measure(const Shader &) { return 0; }
+};
+
+struct TextureLoader : AssetLoader<Texture2D>
+{
+    using AssetLoader<Texture2D>::operator();
+    result_type operator()(const std::string &path, bool gamma) const;
+    // Texture memory is counted once by the TextureCache, however many handles share it
+    static std::size_t Measure(const Texture2D &) { return 0; }
+};
+
+// Assets of one type. The resource cache owns them; each slot tracks generation, reference
+// count and when the asset was last released. A slot can also be reserved for an asset that is
+// still loading: its handle counts references as usual but resolves to null until Complete().
+template <typename Type, typename Loader>
+class AssetPool
+{
+public:
+    template <typename... Args>
+    AssetHandle<Type> Load(entt::id_type key, Args &&...args)
+    {
+        if (auto found = m_Keys.find(key); found != m_Keys.end())
+        {
+            Slot &slot = m_Slots[found->second];
+            slot.references++;
+            return {found->second, slot.generation};
+        }
+
+        auto [it, inserted] = m_Cache.load(key, std::forward<Args>(args)...);
+        if (!it->second)
+        {
+            m_Cache.erase(key);
+            return {};
+        }
+
+        AssetHandle<Type> handle = Allocate(key);
+        Fill(m_Slots[handle.index], &*it->second);
+        return handle;
+    }
+
+    // Handle for key, with existing set when the asset is already loaded or loading
+    AssetHandle<Type> Reserve(entt::id_type key, bool &existing)
+    {
+        existing = false;
+        if (auto found = m_Keys.find(key); found != m_Keys.end())
+        {
+            Slot &slot = m_Slots[found->second];
+            slot.references++;
+            existing = true;
+            return {found->second, slot.generation};
+        }
+
+        AssetHandle<Type> handle = Allocate(key);
+        m_Slots[handle.index].loading = true;
+        return handle;
+    }
+
+    // Stores the result of a reserved load; a null asset frees the slot, leaving its handles stale
+    void Complete(AssetHandle<Type> handle, typename Loader::result_type asset)
+    {
+        Slot *slot = Resolve(handle);
+        if (!slot || !slot->loading)
+            return;
+
+        if (!asset)
+        {
+            Destroy(handle.index);
+            return;
+        }
+
+        auto [it, inserted] = m_Cache.force_load(slot->key, std::move(asset));
+        slot->loading = false;
+        Fill(*slot, &*it->second);
+    }
+
+    bool IsLoading(AssetHandle<Type> handle) const
+    {
+        const Slot *slot = Resolve(handle);
+        return slot && slot->loading;
+    }
+
+    Type *Get(AssetHandle<Type> handle) const
+    {
+        const Slot *slot = Resolve(handle);
+        return slot ? slot->object : nullptr;
+    }
+
+    void Acquire(AssetHandle<Type> handle)
+    {
+        if (Slot *slot = Resolve(handle))
+            slot->references++;
+    }
+
+    void Release(AssetHandle<Type> handle, std::uint64_t tick)
+    {
+        Slot *slot = Resolve(handle);
+        if (slot && slot->references > 0)
+        {
+            slot->references--;
+            slot->lastUsed = tick;
+        }
+    }
+
+    bool Unload(AssetHandle<Type> handle)
+    {
+        const Slot *slot = Resolve(handle);
+        if (!slot || slot->loading || slot->references > 0)
+            return false;
+
+        Destroy(handle.index);
+        return true;
+    }
+
+    // Unreferenced asset released longest ago, or INVALID_INDEX if every asset is in use
+    std::uint32_t FindEvictable(std::uint64_t &lastUsed) const
+    {
+        std::uint32_t result = AssetHandle<Type>::INVALID_INDEX;
+        for (std::uint32_t i = 0; i < m_Slots.size(); i++)
+        {
+            const Slot &slot = m_Slots[i];
+            if (slot.object && slot.references == 0 && slot.lastUsed < lastUsed)
+            {
+                lastUsed = slot.lastUsed;
+                result = i;
+            }
+        }
+        return result;
+    }
+
+    void Destroy(std::uint32_t index)
+    {
+        Slot &slot = m_Slots[index];
+        m_Bytes -= slot.bytes;
+        m_Keys.erase(slot.key);
+        m_Cache.erase(slot.key);
+
+        slot = Slot{slot.generation + 1};
+        m_FreeSlots.push_back(index);
+    }
+
+    void Clear()
+    {
+        for (std::uint32_t i = 0; i < m_Slots.size(); i++)
+        {
+            if (m_Slots[i].object || m_Slots[i].loading)
+                Destroy(i);
+        }
+    }
+
+    std::size_t GetBytes() const { return m_Bytes; }
+    std::size_t GetCount() const { return m_Keys.size(); }
+
+private:
+    struct Slot
+    {
+        std::uint32_t generation = 0;
+        entt::id_type key = 0;
+        Type *object = nullptr;
+        std::uint32_t references = 0;
+        std::uint64_t lastUsed = 0;
+        std::size_t bytes = 0;
+        bool loading = false;
+    };
+
+    entt::resource_cache<Type, Loader> m_Cache;
+    std::unordered_map<entt::id_type, std::uint32_t> m_Keys;
+    std::vector<Slot> m_Slots;
+    std::vector<std::uint32_t> m_FreeSlots;
+    std::size_t m_Bytes = 0;
+
+    AssetHandle<Type> Allocate(entt::id_type key)
+    {
+        std::uint32_t index;
+        if (!m_FreeSlots.empty())
+        {
+            index = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else
+        {
+            index = (std::uint32_t)m_Slots.size();
+            m_Slots.emplace_back();
+        }
+
+        Slot &slot = m_Slots[index];
+        slot.key = key;
+        slot.references = 1;
+        m_Keys.emplace(key, index);
+        return {index, slot.generation};
+    }
+
+    void Fill(Slot &slot, Type *object)
+    {
+        slot.object = object;
+        slot.bytes = Loader::Measure(*object);
+        m_Bytes += slot.bytes;
+    }
+
+    Slot *Resolve(AssetHandle<Type> handle) { return const_cast<Slot *>(std::as_const(*this).Resolve(handle)); }
+    const Slot *Resolve(AssetHandle<Type> handle) const
+    {
+        if (handle.index >= m_Slots.size())
+            return nullptr;
+
+        const Slot &slot = m_Slots[handle.index];
+        return (slot.object || slot.loading) && slot.generation == handle.generation ? &slot : nullptr;
+    }
+};
+
+// Central owner of models, animations, shaders and standalone textures. Loading the same
+// normalized path with the same settings returns the same asset with one more reference. An
+// asset whose last reference is released stays cached until it is unloaded, or evicted (least
+// recently released first) to keep GPU memory under the budget.
+class AssetManager
+{
+public:
+    static AssetManager &Get();
+
+    AssetManager(const AssetManager &) = delete;
+    AssetManager &operator=(const AssetManager &) = delete;
+
+    ModelHandle LoadModel(const std::string &path, bool gamma = false, const MeshLodSettings &lodSettings = MeshLodSettings{});
+    // Bone ids depend on the model, so a clip is cached per model it was loaded for
+    AnimationHandle LoadAnimation(const std::string &path, ModelHandle model);
+    ShaderHandle LoadShader(const std::string &vertexPath, const std::string &fragmentPath);
+    TextureHandle LoadTexture(const std::string &path, bool gamma = false);
+
+    // Same as above, but the work runs on the job system and the GL uploads go through the
+    // upload queue. The handle is returned at once and resolves to null until the asset is
+    // ready; a failed load leaves it stale. Call from the main thread only.
+    ModelHandle LoadModelAsync(const std::string &path, bool gamma = false, const MeshLodSettings &lodSettings = MeshLodSettings{});
+    // Starts once the model has finished loading
+    AnimationHandle LoadAnimationAsync(const std::string &path, ModelHandle model);
+    TextureHandle LoadTextureAsync(const std::string &path, bool gamma = false);
+
+    template <typename Type>
+    bool IsLoading(AssetHandle<Type> handle) { return GetPool<Type>().IsLoading(handle); }
+
+    template <typename Type>
+    Type *Get(AssetHandle<Type> handle) { return GetPool<Type>().Get(handle); }
+    template <typename Type>
+    void Acquire(AssetHandle<Type> handle) { GetPool<Type>().Acquire(handle); }
+    template <typename Type>
+    void Release(AssetHandle<Type> handle) { GetPool<Type>().Release(handle, ++m_Tick); }
+    // Frees the asset right away if nothing references it any more
+    template <typename Type>
+    bool Unload(AssetHandle<Type> handle) { return GetPool<Type>().Unload(handle); }
+
+    void SetMemoryBudget(std::size_t bytes) { m_Budget = bytes; }
+    std::size_t GetMemoryBudget() const { return m_Budget; }
+    std::size_t GetMemoryUsage() const;
+
+    // Once per frame: starts animation loads whose model is ready, then evicts
+    void Update();
+    // Unloads unreferenced assets until usage fits the budget; cheap when it already does
+    void Evict();
+    void UnloadUnused();
+    // Waits for loads in flight, then frees everything, referenced or not; must run while the GL
+    // context is still alive, followed by UploadQueue::Clear()
+    void Clear();
+
+private:
+    AssetPool<Model, ModelLoader> m_Models;
+    AssetPool<Animation, AnimationLoader> m_Animations;
+    AssetPool<Shader, ShaderLoader> m_Shaders;
+    AssetPool<Texture2D, TextureLoader> m_Textures;
+    std::size_t m_Budget = std::numeric_limits<std::size_t>::max();
+    std::uint64_t m_Tick = 0;
+
+    struct PendingAnimation
+    {
+        AnimationHandle handle;
+        std::string path;
+        ModelHandle model;
+    };
+    std::vector<PendingAnimation> m_WaitingAnimations;
+    JobCounter m_Loads;
+
+    AssetManager() = default;
+
+    template <typename Type>
+    auto &GetPool()
+    {
+        if constexpr (std::is_same_v<Type, Model>)
+            return m_Models;
+        else if constexpr (std::is_same_v<Type, Animation>)
+            return m_Animations;
+        else if constexpr (std::is_same_v<Type, Shader>)
+            return m_Shaders;
+        else
+        {
+            static_assert(std::is_same_v<Type, Texture2D>, "not a managed asset type");
+            return m_Textures;
+        }
+    }
+
+    bool EvictOne();
+    void StartAnimation(const PendingAnimation &pending);
+    static entt::id_type MakeKey(const std::string &path, std::uint64_t salt = 0);
+    static entt::id_type MakeModelKey(const std::string &path, bool gamma, const MeshLodSettings &lodSettings);
+};
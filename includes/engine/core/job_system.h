@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of jobs still outstanding in a group; Wait() returns once it reaches zero
+struct JobCounter
+{
+    std::atomic<std::uint32_t> pending{0};
+
+    bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Fixed pool of worker threads fed from two queues: frame work, and background work such as
+// asset loads that may take many frames. A thread waiting on a counter runs queued jobs in the
+// meantime, so jobs may schedule and wait on more work without deadlocking; the main thread and
+// frame jobs only ever help with frame work, so a wait inside the frame never picks up a load.
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+
+    static JobSystem &Get();
+
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // Jobs scheduled from a background job are background work too, including ParallelFor batches
+    void Schedule(Job job, JobCounter *counter = nullptr);
+    void ScheduleBackground(Job job, JobCounter *counter = nullptr);
+    void Wait(JobCounter &counter);
+
+    // Runs fn(begin, end) over [0, count) in ranges of at most batchSize and returns when all are done
+    void ParallelFor(std::size_t count, std::size_t batchSize, const std::function<void(std::size_t, std::size_t)> &fn);
+
+    std::size_t GetWorkerCount() const { return m_Workers.size(); }
+
+private:
+    struct Entry
+    {
+        Job job;
+        JobCounter *counter;
+        bool background;
+    };
+
+    std::vector<std::thread> m_Workers;
+    std::deque<Entry> m_Queue;
+    std::deque<Entry> m_BackgroundQueue;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    bool m_Quit = false;
+
+    JobSystem();
+
+    void push(Entry entry);
+    bool pop(bool background, Entry &entry);
+    bool RunOne();
+    void Run(Entry &entry);
+    void WorkerLoop();
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file mapped into memory; pages are faulted in on first touch
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    bool IsOpen() const { return m_Data != nullptr; }
+    const unsigned char *GetData() const { return m_Data; }
+    std::size_t GetSize() const { return m_Size; }
+
+private:
+    const unsigned char *m_Data = nullptr;
+    std::size_t m_Size = 0;
+#ifdef _WIN32
+    void *m_File = nullptr;
+    void *m_Mapping = nullptr;
+#endif
+};
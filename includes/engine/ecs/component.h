@@ -8,8 +8,10 @@
 #include <engine/graphic/model.h>
 #include <engine/graphic/ui_model.h>
 #include <engine/graphic/animator.h>
+#include <engine/ecs/spatial_index.h>
 
 #include <functional>
+#include <memory>
 
 struct TransformComponent
 {
@@ -24,9 +26,42 @@ struct MeshRendererComponent
 {
     Model *model = nullptr;
     Shader *shader = nullptr;
+    glm::vec4 color = glm::vec4(1.0f);
+    MaterialHandle material = INVALID_MATERIAL; // overrides the materials imported with the model
     bool castShadow = true;
 };
 
+struct WorldBoundsComponent
+{
+    AABB aabb;
+    BoundingSphere sphere;
+    std::uint32_t category = SPATIAL_RENDERABLE;
+};
+
+// Rasterized into the software occlusion buffer each frame. model may point at a cheaper stand-in
+// (e.g. a few boxes for a room's walls); without one the renderer's own model is used. Animated
+// entities are skipped since their CPU-side vertices are in bind pose.
+struct OccluderComponent
+{
+    Model *model = nullptr;
+};
+
+// Level of detail the renderer picked last frame, kept so a switch needs a margin either way
+struct LodComponent
+{
+    std::uint8_t level = 0;
+};
+
+// Set whenever something that feeds WorldBoundsComponent changes; cleared by BoundsSystem
+struct BoundsDirtyComponent
+{
+};
+
+// Set when a camera or its transform changes; cleared by CameraSystem once the matrices are rebuilt
+struct CameraDirtyComponent
+{
+};
+
 struct RigidBodyComponent
 {
     btRigidBody *body = nullptr;
@@ -34,7 +69,8 @@ struct RigidBodyComponent
 
 struct AnimationComponent
 {
-    Animator *animator = nullptr;
+    std::unique_ptr<Animator> animator;
+    int paletteOffset = -1;
 };
 
 struct CameraComponent
@@ -127,4 +163,6 @@ struct SpotLightComponent
     float constant = 1.0f;
     float linear = 0.09f;
     float quadratic = 0.032f;
+
+    float radius = 10.0f;
 };
\ No newline at end of file
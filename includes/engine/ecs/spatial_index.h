@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <BulletCollision/BroadphaseCollision/btDbvt.h>
+
+#include <engine/graphic/bounds.h>
+#include <engine/graphic/frustum.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+enum SpatialCategory : std::uint32_t
+{
+    SPATIAL_RENDERABLE = 1 << 0,
+    SPATIAL_LIGHT = 1 << 1,
+    SPATIAL_TRIGGER = 1 << 2,
+    SPATIAL_ALL = 0xFFFFFFFFu,
+};
+
+struct SpatialRayHit
+{
+    entt::entity entity;
+    float distance;
+};
+
+// Dynamic AABB tree over every entity with a WorldBoundsComponent. Leaves are
+// stored enlarged by MARGIN so small moves do not touch the tree at all.
+class SpatialIndex
+{
+public:
+    static constexpr float MARGIN = 0.1f;
+
+    SpatialIndex() = default;
+    ~SpatialIndex();
+
+    SpatialIndex(const SpatialIndex &) = delete;
+    SpatialIndex &operator=(const SpatialIndex &) = delete;
+
+    void Connect(entt::registry &registry);
+    void Disconnect(entt::registry &registry);
+
+    void Insert(entt::entity entity, const AABB &bounds, std::uint32_t category);
+    void Update(entt::entity entity, const AABB &bounds, std::uint32_t category);
+    void Remove(entt::entity entity);
+    void Clear();
+
+    void QueryFrustum(const Frustum &frustum, std::uint32_t categories, std::vector<entt::entity> &result) const;
+    void QuerySphere(const glm::vec3 &center, float radius, std::uint32_t categories, std::vector<entt::entity> &result) const;
+    void QueryBox(const AABB &box, std::uint32_t categories, std::vector<entt::entity> &result) const;
+    // Hits are sorted by the distance at which the ray enters each entity's world bounds
+    void QueryRay(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, std::uint32_t categories,
+                  std::vector<SpatialRayHit> &result) const;
+
+    std::size_t Size() const { return m_Leaves.size(); }
+    // Entries in any of the categories; kept up to date, so no walk over the leaves
+    std::size_t Count(std::uint32_t categories) const;
+
+private:
+    struct Leaf
+    {
+        btDbvtNode *node;
+        AABB bounds;
+        std::uint32_t category;
+    };
+
+    btDbvt m_Tree;
+    std::unordered_map<entt::entity, Leaf> m_Leaves;
+    std::unordered_map<std::uint32_t, std::size_t> m_CategoryCounts;
+
+    const Leaf *Find(const btDbvtNode *node) const;
+    void OnBoundsChanged(entt::registry &registry, entt::entity entity);
+    void OnBoundsDestroyed(entt::registry &, entt::entity entity);
+};
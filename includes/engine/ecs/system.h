@@ -7,12 +7,33 @@
 #include <engine/ecs/component.h>
 #include <engine/utils/bullet_glm_helpers.h>
 #include <engine/graphic/shader.h>
+#include <engine/graphic/frame_constants.h>
+#include <engine/graphic/uniform_buffer.h>
+#include <engine/graphic/bone_palette_buffer.h>
+#include <engine/graphic/instance_buffer.h>
+#include <engine/graphic/indirect_buffer.h>
+#include <engine/graphic/skinning_pass.h>
+#include <engine/graphic/shadow_map.h>
+#include <engine/graphic/light_clusters.h>
+#include <engine/graphic/render_queue.h>
+#include <engine/graphic/frustum.h>
+#include <engine/graphic/occlusion_culler.h>
+#include <engine/core/job_system.h>
+#include <engine/ecs/spatial_index.h>
 #include <engine/core/keyboard_manager.h>
 #include <engine/core/mouse_manager.h>
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 struct Scene
 {
     entt::registry registry;
+    SpatialIndex spatialIndex;
+
+    Scene();
+    ~Scene();
 
     entt::entity createEntity();
     entt::entity GetActiveCamera();
@@ -30,19 +51,181 @@ public:
     void Update(Scene &scene, float dt);
 };
 
+// Lives in the registry context; bumped whenever a static renderer (no rigid body or animation)
+// is added, changed, moved or destroyed, so caches of static geometry know to refresh
+struct StaticGeometryVersion
+{
+    std::uint32_t value = 0;
+};
+
+// Lives in the registry context; CameraSystem bumps `camera` whenever it rebuilds the matrices and
+// light signals bump `lights`, so FrameConstantsSystem only redoes and re-sends what changed
+struct FrameDataVersion
+{
+    std::uint32_t camera = 0;
+    std::uint32_t lights = 0;
+};
+
+// Transform, renderer and light changes must go through registry.patch/replace so the dirty flag is raised
+class BoundsSystem
+{
+public:
+    static void Connect(entt::registry &registry);
+
+    void Update(Scene &scene);
+};
+
 class RenderSystem
 {
 public:
     void Render(Scene &scene);
+    // Releases every GL object the system owns; must run while the context is still current
+    void Shutdown();
+
+    // Skins animated meshes once per frame in a compute pass when the context supports it
+    void SetComputeSkinning(bool enabled) { m_ComputeSkinning = enabled; }
+    // Culls renderers hidden behind OccluderComponent meshes with the CPU depth rasterizer
+    void SetOcclusionCulling(bool enabled) { m_OcclusionCulling = enabled; }
+    // Levels of detail are chosen so their error projects to at most this many pixels
+    void SetLodPixelError(float pixels) { m_LodPixelError = pixels; }
+    // Size of the default framebuffer, which passes into offscreen targets restore afterwards
+    void SetViewportSize(int width, int height)
+    {
+        m_ViewportWidth = width;
+        m_ViewportHeight = height;
+    }
 
 private:
-    void UploadLightData(Scene &scene, Shader *shader);
+    struct ShaderUniforms
+    {
+        UniformHandle model;
+        UniformHandle boneOffset;
+    };
+
+    struct DrawItem
+    {
+        Shader *shader;
+        Mesh *mesh;
+        const GeometryAllocation *geometry;
+        MaterialHandle material;
+        InstanceData instance;
+    };
+
+    struct DrawBatch
+    {
+        RenderPass pass;
+        Shader *shader;
+        Mesh *mesh;
+        const GeometryAllocation *geometry;
+        MaterialHandle material;
+        GLuint firstInstance;
+        GLsizei count;
+    };
+
+    std::unordered_map<const Shader *, ShaderUniforms> m_ShaderUniforms;
+    std::unique_ptr<BonePaletteBuffer> m_BonePalette;
+    std::unique_ptr<InstanceBuffer> m_Instances;
+    std::unique_ptr<IndirectBuffer> m_Indirect;
+    std::unique_ptr<SkinningPass> m_Skinning;
+    bool m_ComputeSkinning = true;
+
+    struct ShadowDraw
+    {
+        const GeometryAllocation *geometry;
+        InstanceData instance;
+        GLuint index;
+    };
+
+    std::unique_ptr<CascadedShadowMap> m_ShadowMap;
+    std::unique_ptr<Shader> m_ShadowShader;
+    UniformHandle m_ShadowViewProjection;
+    std::unique_ptr<InstanceBuffer> m_ShadowInstances;
+    std::vector<ShadowDraw> m_StaticShadowDraws[SHADOW_CASCADE_COUNT];
+    std::vector<ShadowDraw> m_DynamicShadowDraws[SHADOW_CASCADE_COUNT];
+    std::vector<entt::entity> m_ShadowCandidates;
+    std::uint32_t m_StaleCascades = 0;
+    std::uint32_t m_StaticVersion = 0;
+
+    FrustumCuller m_Culler;
+    std::vector<entt::entity> m_TreeResults;
+    std::vector<entt::entity> m_Candidates;
+    std::vector<std::uint32_t> m_VisibleIndices;
+
+    struct OccluderDraw
+    {
+        const Mesh *mesh;
+        glm::mat4 model;
+        float distance;
+    };
+
+    std::unique_ptr<OcclusionCuller> m_Occlusion;
+    bool m_OcclusionCulling = true;
+    bool m_OcclusionPending = false;
+    JobCounter m_OcclusionJob;
+    std::vector<OccluderDraw> m_OccluderDraws;
+    std::vector<AABB> m_OcclusionBoxes;
+    std::vector<std::uint8_t> m_OcclusionResults;
+
+    static constexpr float LOD_HYSTERESIS = 0.25f;
+    float m_LodPixelError = 1.0f;
+    int m_ViewportWidth = 1280;
+    int m_ViewportHeight = 720;
+
+    RenderQueue m_Queue;
+    std::vector<DrawItem> m_DrawItems;
+    std::vector<DrawBatch> m_Batches;
+
+    const ShaderUniforms &GetShaderUniforms(const Shader *shader);
+    void UploadBonePalettes(Scene &scene);
+    int GetBoneOffset(Scene &scene, entt::entity entity) const;
+    void CullRenderables(Scene &scene);
+    void BeginOcclusion(Scene &scene);
+    void CullOccluded(Scene &scene);
+    std::uint8_t SelectLod(Scene &scene, entt::entity entity, const Model &model, const TransformComponent &transform,
+                           const glm::vec3 &viewPos, float pixelsPerUnit);
+    void BuildQueue(Scene &scene);
+    void BuildBatches();
+    void DrawBatches(RenderPass pass);
+    bool CanMultiDraw(const DrawBatch &first, const DrawBatch &next) const;
+    void DrawMultiIndirect(std::size_t firstBatch, std::size_t batchCount);
+    void CollectShadowCasters(Scene &scene);
+    void RenderShadows();
+    void DrawShadowCasters(std::vector<ShadowDraw> &draws, const glm::mat4 &lightViewProjection);
+};
+
+// Light component and light transform changes must go through registry.patch/replace to be picked up
+class FrameConstantsSystem
+{
+public:
+    static void Connect(entt::registry &registry);
+
+    void Update(Scene &scene, float screenWidth, float screenHeight);
+    // Releases the frame constant and cluster buffers; must run while the context is still current
+    void Shutdown();
+
+private:
+    FrameConstants m_Constants{};
+    std::unique_ptr<UniformBuffer> m_Buffer;
+    std::unique_ptr<LightClusterGrid> m_Clusters;
+    std::vector<entt::entity> m_Lights;
+
+    bool m_Valid = false;
+    entt::entity m_Camera = entt::null;
+    glm::vec2 m_ScreenSize = glm::vec2(0.0f);
+    std::uint32_t m_CameraVersion = 0;
+    std::uint32_t m_LightVersion = 0;
 };
 
+// Camera and camera transform changes must go through registry.patch/replace to be picked up
 class CameraSystem
 {
 public:
+    static void Connect(entt::registry &registry);
+
     void Update(Scene &scene, float screenWidth, float screenHeight);
+
+private:
+    glm::vec2 m_ScreenSize = glm::vec2(0.0f);
 };
 
 class CameraControlSystem
@@ -59,5 +242,15 @@ public:
 
 class UIRenderSystem {
 public:
-    void Render(Scene& scene, float screenWidth, float screenHeight);
+    void Render(Scene& scene);
+
+private:
+    struct ShaderUniforms
+    {
+        UniformHandle model, image;
+    };
+
+    std::unordered_map<const Shader*, ShaderUniforms> m_ShaderUniforms;
+    RenderQueue m_Queue;
+    std::vector<entt::entity> m_Entities;
 };
\ No newline at end of file
@@ -2,9 +2,11 @@
 
 #include <vector>
 #include <map>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <assimp/scene.h>
 
+#include <engine/core/asset_cooker.h>
 #include <engine/graphic/bone.h>
 #include <engine/graphic/animdata.h>
 #include <engine/graphic/model.h>
@@ -21,11 +23,21 @@ class Animation
 {
 public:
 	Animation();
+	// Loads the cooked clip for the file's contents, importing and cooking it first if there is none
 	Animation(const std::string &animationPath, Model *model);
 	~Animation();
 
+	static constexpr std::uint32_t COOKED_MAGIC = 0x4D494E41; // "ANIM"
+
+	// Writes the first clip and node hierarchy of an imported scene; false if it has no animation
+	static bool Cook(const aiScene *scene, std::uint64_t sourceHash, CookedWriter &writer);
+	static std::string GetCookedPath(std::uint64_t sourceHash);
+
 	Bone *FindBone(const std::string &name);
 
+	// False when the file held no clip; such an animation must not be played
+	bool IsValid() const { return m_Duration > 0.0f; }
+
 	inline float GetTicksPerSecond() { return m_TicksPerSecond; }
 	inline float GetDuration() { return m_Duration; }
 	inline const AssimpNodeData &GetRootNode() { return m_RootNode; }
@@ -35,12 +47,13 @@ public:
 	}
 
 private:
-	float m_Duration;
-	int m_TicksPerSecond;
+	float m_Duration = 0.0f;
+	int m_TicksPerSecond = 0;
 	std::vector<Bone> m_Bones;
 	AssimpNodeData m_RootNode;
 	std::map<std::string, BoneInfo> m_BoneInfoMap;
 
-	void ReadMissingBones(const aiAnimation *animation, Model &model);
-	void ReadHierarchyData(AssimpNodeData &dest, const aiNode *src);
+	bool ReadCooked(CookedReader &reader, Model &model);
+	void ReadHierarchyData(AssimpNodeData &dest, CookedReader &reader);
+	static void CookHierarchyData(CookedWriter &writer, const aiNode *src);
 };
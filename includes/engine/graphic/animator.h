@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <span>
 #include <vector>
 #include <assimp/scene.h>
 #include <engine/graphic/animation.h>
@@ -13,9 +14,11 @@ public:
 	void UpdateAnimation(float dt);
 	void PlayAnimation(Animation *pAnimation);
 	void CalculateBoneTransform(const AssimpNodeData *node, glm::mat4 parentTransform);
-	std::vector<glm::mat4> GetFinalBoneMatrices();
+	std::span<const glm::mat4> GetFinalBoneMatrices() const;
 
 private:
+	void ResizeBoneMatrices();
+
 	std::vector<glm::mat4> m_FinalBoneMatrices;
 	Animation *m_CurrentAnimation;
 	float m_CurrentTime;
@@ -1,7 +1,7 @@
 #pragma once
 
+#include <string>
 #include <vector>
-#include <assimp/scene.h>
 #include <glm/glm.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
@@ -27,13 +27,15 @@ struct KeyScale
 class Bone
 {
 public:
-	Bone(const std::string &name, int ID, const aiNodeAnim *channel);
+	Bone(const std::string &name, int ID, std::vector<KeyPosition> positions, std::vector<KeyRotation> rotations,
+		 std::vector<KeyScale> scales);
 
 	void Update(float animationTime);
 	glm::mat4 GetLocalTransform();
 	std::string GetBoneName() const;
 	int GetBoneID();
 
+	// Key starting the segment that holds animationTime; amortized constant time while playing forward
 	int GetPositionIndex(float animationTime);
 	int GetRotationIndex(float animationTime);
 	int GetScaleIndex(float animationTime);
@@ -51,6 +53,11 @@ private:
 	int m_NumRotations;
 	int m_NumScalings;
 
+	// Last segment found per channel
+	int m_PositionCursor = 0;
+	int m_RotationCursor = 0;
+	int m_ScaleCursor = 0;
+
 	glm::mat4 m_LocalTransform;
 	std::string m_Name;
 	int m_ID;
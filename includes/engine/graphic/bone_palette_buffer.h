@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+class BonePaletteBuffer
+{
+public:
+    static constexpr int FRAMES_IN_FLIGHT = 3;
+    static constexpr GLuint TEXTURE_UNIT = 15;
+
+    BonePaletteBuffer(std::size_t initialCapacity = 1024);
+    ~BonePaletteBuffer();
+
+    BonePaletteBuffer(const BonePaletteBuffer &) = delete;
+    BonePaletteBuffer &operator=(const BonePaletteBuffer &) = delete;
+
+    void BeginFrame();
+    // Returns -1 when the matrices do not fit under the texture buffer size limit
+    int Allocate(std::span<const glm::mat4> matrices);
+    void Upload();
+    void EndFrame();
+    void Bind() const;
+
+    int GetFrameBase() const { return m_FrameBase; }
+    std::size_t GetUploadedBytes() const { return m_Staging.size() * sizeof(glm::mat4); }
+
+private:
+    GLuint m_Buffer = 0;
+    GLuint m_Texture = 0;
+    std::size_t m_Capacity;
+    std::size_t m_MaxCapacity;
+    bool m_LimitReported = false;
+    int m_Frame = 0;
+    int m_FrameBase = 0;
+    GLsync m_Fences[FRAMES_IN_FLIGHT] = {};
+    std::vector<glm::mat4> m_Staging;
+
+    void Reallocate(std::size_t capacity);
+};
@@ -3,6 +3,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <engine/graphic/uniform.h>
+
 #include <string>
 
 class ComputeShader
@@ -14,6 +16,9 @@ public:
 
     void use();
 
+    UniformHandle GetUniform(entt::id_type id) const;
+    UniformHandle GetUniform(const std::string &name) const;
+
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
     void setFloat(const std::string &name, float value) const;
@@ -27,6 +32,19 @@ public:
     void setMat3(const std::string &name, const glm::mat3 &mat) const;
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
 
+    void setBool(UniformHandle handle, bool value) const;
+    void setInt(UniformHandle handle, int value) const;
+    void setFloat(UniformHandle handle, float value) const;
+    void setVec2(UniformHandle handle, const glm::vec2 &value) const;
+    void setVec3(UniformHandle handle, const glm::vec3 &value) const;
+    void setVec4(UniformHandle handle, const glm::vec4 &value) const;
+    void setMat2(UniformHandle handle, const glm::mat2 &mat) const;
+    void setMat3(UniformHandle handle, const glm::mat3 &mat) const;
+    void setMat4(UniformHandle handle, const glm::mat4 &mat) const;
+    void setMat4Array(UniformHandle handle, const glm::mat4 *mats, int count) const;
+
 private:
+    UniformTable m_Uniforms;
+
     void checkCompileErrors(GLuint shader, std::string type);
 };
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Mirrors the std140 FrameConstants block in resources/shaders/frame_constants.glsl;
+// every member is vec4-sized so the C++ and GLSL layouts match byte for byte.
+struct GPUDirectionalLight
+{
+    glm::vec4 direction;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+};
+
+enum GPULightType : int
+{
+    GPU_LIGHT_POINT = 0,
+    GPU_LIGHT_SPOT = 1,
+};
+
+// Point and spot lights live in the clustered light buffer, five RGBA32F texels each
+struct GPULight
+{
+    glm::vec4 position;    // xyz, radius
+    glm::vec4 color;       // rgb scaled by intensity, type
+    glm::vec4 attenuation; // constant, linear, quadratic, intensity
+    glm::vec4 direction;   // spot direction, unused for point lights
+    glm::vec4 cone;        // cutOff, outerCutOff, unused, unused
+};
+
+struct FrameConstants
+{
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::mat4 viewProjection;
+    glm::mat4 screenProjection;
+    glm::vec4 viewPos;
+    glm::ivec4 lightCounts;   // directional, point, spot, total clustered
+    glm::ivec4 clusterDims;   // tiles x, tiles y, depth slices, unused
+    glm::vec4 clusterParams;  // slice scale, slice bias, tile width, tile height in pixels
+
+    GPUDirectionalLight dirLight;
+};
+
+static_assert(sizeof(FrameConstants) % 16 == 0, "FrameConstants must keep std140 alignment");
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <engine/graphic/bounds.h>
+
+#include <cstdint>
+#include <vector>
+
+struct Frustum
+{
+    // left, right, bottom, top, near, far; normals point inwards
+    glm::vec4 planes[6];
+
+    static Frustum FromMatrix(const glm::mat4 &viewProjection);
+
+    bool Intersects(const AABB &box) const;
+    bool Intersects(const BoundingSphere &sphere) const;
+};
+
+// Boxes are kept as separate center/extent streams so four can be tested per SSE instruction
+class FrustumCuller
+{
+public:
+    void Clear();
+    std::uint32_t Add(const AABB &box);
+    std::size_t Size() const { return m_CenterX.size(); }
+
+    // Appends the indices returned by Add() of every box that touches the frustum
+    void Cull(const Frustum &frustum, std::vector<std::uint32_t> &visible) const;
+
+private:
+    std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+    std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+
+    void CullScalar(const Frustum &frustum, std::size_t begin, std::vector<std::uint32_t> &visible) const;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <engine/graphic/vertex_format.h>
+
+#include <array>
+#include <cstddef>
+#include <map>
+
+struct GeometryAllocation
+{
+    VertexFormat format = VertexFormat::Static;
+    GLint baseVertex = 0;
+    GLuint vertexCount = 0;
+    GLuint indexOffset = 0; // in bytes
+    GLuint indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    bool IsValid() const { return indexCount > 0; }
+    GLuint GetFirstIndex() const { return indexOffset / (indexType == GL_UNSIGNED_SHORT ? 2 : 4); }
+};
+
+// First-fit free list over [0, capacity); neighbouring free ranges are merged on Free()
+class RangeAllocator
+{
+public:
+    bool Allocate(std::size_t size, std::size_t alignment, std::size_t &offset);
+    void Free(std::size_t offset, std::size_t size);
+    void Grow(std::size_t capacity);
+
+    std::size_t GetCapacity() const { return m_Capacity; }
+    std::size_t GetUsed() const { return m_Used; }
+
+private:
+    std::map<std::size_t, std::size_t> m_Free;
+    std::size_t m_Capacity = 0;
+    std::size_t m_Used = 0;
+};
+
+// All mesh data lives in one vertex buffer per format plus one shared index
+// buffer, so switching meshes of the same format never rebinds a VAO.
+class GeometryArena
+{
+public:
+    static constexpr std::size_t INITIAL_VERTEX_CAPACITY = 1 << 18;
+    static constexpr std::size_t INITIAL_INDEX_CAPACITY = 1 << 22;
+
+    static GeometryArena &Get();
+
+    // Deletes the pools while the context is still current, rather than at static destruction
+    void Shutdown();
+
+    GeometryArena(const GeometryArena &) = delete;
+    GeometryArena &operator=(const GeometryArena &) = delete;
+
+    GeometryAllocation Allocate(VertexFormat format, const void *vertices, std::size_t vertexCount,
+                                const void *indices, std::size_t indexCount, GLenum indexType);
+    void Free(const GeometryAllocation &allocation);
+
+    // Extra index range over an existing allocation's vertices, e.g. a simplified level of detail
+    GeometryAllocation AllocateIndices(const GeometryAllocation &vertices, const void *indices, std::size_t indexCount);
+    void FreeIndices(const GeometryAllocation &allocation);
+
+    // Vertex-only ranges for data produced on the GPU; returns the base vertex or -1
+    GLint AllocateVertices(VertexFormat format, std::size_t vertexCount);
+    void FreeVertices(VertexFormat format, GLint baseVertex, std::size_t vertexCount);
+    GLuint GetVertexBuffer(VertexFormat format) { return GetPool(format).vbo; }
+
+    void Bind(VertexFormat format);
+
+    std::size_t GetVertexBytes() const;
+    std::size_t GetIndexBytes() const { return m_Indices.GetUsed(); }
+
+private:
+    struct VertexPool
+    {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        RangeAllocator allocator;
+    };
+
+    std::array<VertexPool, VERTEX_FORMAT_COUNT> m_Pools;
+    GLuint m_IndexBuffer = 0;
+    RangeAllocator m_Indices;
+
+    GeometryArena() = default;
+
+    VertexPool &GetPool(VertexFormat format);
+    std::size_t UploadIndices(const void *indices, std::size_t bytes);
+    void GrowVertices(VertexFormat format, std::size_t minimumCapacity);
+    void GrowIndices(std::size_t minimumCapacity);
+    static GLuint Reallocate(GLuint buffer, std::size_t oldBytes, std::size_t newBytes);
+};
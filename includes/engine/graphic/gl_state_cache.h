@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Shadows the GL binding and fixed-function state the renderer touches so that
+// redundant calls are skipped; every request is counted in RenderStats as
+// either issued or elided. Objects must be forgotten before they are deleted,
+// otherwise a recycled name could be mistaken for an existing binding.
+class GLStateCache
+{
+public:
+    static constexpr GLuint MAX_TEXTURE_UNITS = 16;
+    static constexpr GLuint MAX_UNIFORM_BINDINGS = 8;
+
+    static GLStateCache &Get();
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vao);
+    void BindBuffer(GLenum target, GLuint buffer);
+    void BindUniformBufferRange(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    void BindBufferBase(GLenum target, GLuint binding, GLuint buffer);
+    void BindTexture(GLuint unit, GLenum target, GLuint texture);
+    // GL_FRAMEBUFFER sets both the read and the draw binding
+    void BindFramebuffer(GLenum target, GLuint framebuffer);
+
+    void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    void SetDepthTest(bool enabled);
+    void SetDepthWrite(bool enabled);
+    void SetBlend(bool enabled);
+    void SetBlendFunc(GLenum src, GLenum dst);
+    void SetCullFace(bool enabled);
+    void SetDepthClamp(bool enabled);
+
+    void ForgetProgram(GLuint program);
+    void ForgetVertexArray(GLuint vao);
+    void ForgetBuffer(GLuint buffer);
+    void ForgetTexture(GLuint texture);
+    void ForgetFramebuffer(GLuint framebuffer);
+    void Invalidate();
+
+private:
+    static constexpr GLuint UNKNOWN = 0xFFFFFFFFu;
+    static constexpr int BUFFER_TARGETS = 8;
+
+    enum class Toggle : signed char
+    {
+        Unknown = -1,
+        Off = 0,
+        On = 1,
+    };
+
+    GLuint m_Program = UNKNOWN;
+    GLuint m_VertexArray = UNKNOWN;
+    GLuint m_Buffers[BUFFER_TARGETS];
+    GLuint m_ActiveUnit = UNKNOWN;
+    GLuint m_Textures[MAX_TEXTURE_UNITS];
+    GLenum m_TextureTargets[MAX_TEXTURE_UNITS];
+    GLuint m_ReadFramebuffer = UNKNOWN;
+    GLuint m_DrawFramebuffer = UNKNOWN;
+    GLint m_Viewport[4];
+
+    struct BufferRange
+    {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+    BufferRange m_UniformRanges[MAX_UNIFORM_BINDINGS];
+
+    Toggle m_DepthTest = Toggle::Unknown;
+    Toggle m_DepthWrite = Toggle::Unknown;
+    Toggle m_Blend = Toggle::Unknown;
+    Toggle m_CullFace = Toggle::Unknown;
+    Toggle m_DepthClamp = Toggle::Unknown;
+    GLenum m_BlendSrc = UNKNOWN;
+    GLenum m_BlendDst = UNKNOWN;
+
+    GLStateCache();
+
+    static int BufferSlot(GLenum target);
+    void SetCapability(Toggle &state, GLenum capability, bool enabled);
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Layout fixed by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Multi-draw-indirect with baseInstance needs a 4.3 context; 3.3 falls back to per-batch draws
+bool IsMultiDrawIndirectSupported();
+
+class IndirectBuffer
+{
+public:
+    IndirectBuffer(std::size_t initialCapacity = 1024);
+    ~IndirectBuffer();
+
+    IndirectBuffer(const IndirectBuffer &) = delete;
+    IndirectBuffer &operator=(const IndirectBuffer &) = delete;
+
+    void BeginFrame();
+    GLuint Push(const DrawElementsIndirectCommand &command);
+    void Upload();
+    void Bind() const;
+
+    std::size_t GetCount() const { return m_Staging.size(); }
+    std::size_t GetUploadedBytes() const { return m_Staging.size() * sizeof(DrawElementsIndirectCommand); }
+
+private:
+    GLuint m_ID = 0;
+    std::size_t m_Capacity;
+    std::vector<DrawElementsIndirectCommand> m_Staging;
+};
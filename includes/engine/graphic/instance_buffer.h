@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+struct InstanceData
+{
+    glm::mat4 model;
+    glm::vec4 color;
+    int boneOffset;
+    int padding[3];
+};
+
+class InstanceBuffer
+{
+public:
+    // Instanced shaders read mat4 instanceModel at 7..10, instanceColor at 11
+    // and instanceBoneOffset at 12
+    static constexpr GLuint FIRST_ATTRIBUTE = 7;
+
+    InstanceBuffer(std::size_t initialCapacity = 1024);
+    ~InstanceBuffer();
+
+    InstanceBuffer(const InstanceBuffer &) = delete;
+    InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+
+    void BeginFrame();
+    GLuint Push(const InstanceData &instance);
+    void Upload();
+    void BindAttributes(GLuint firstInstance) const;
+
+    const InstanceData &Get(GLuint index) const { return m_Staging[index]; }
+    GLuint GetID() const { return m_ID; }
+    std::size_t GetCount() const { return m_Staging.size(); }
+    std::size_t GetUploadedBytes() const { return m_Staging.size() * sizeof(InstanceData); }
+
+private:
+    GLuint m_ID = 0;
+    std::size_t m_Capacity;
+    std::vector<InstanceData> m_Staging;
+};
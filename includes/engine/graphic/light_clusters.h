@@ -0,0 +1,88 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <engine/graphic/frame_constants.h>
+
+#include <cstdint>
+#include <vector>
+
+// Clustered forward lighting: the view frustum is split into screen tiles and
+// exponential depth slices, every light is assigned on the CPU to the clusters
+// its volume touches, and the fragment shader only walks its own cluster's list.
+// Lights, per-cluster (offset, count) pairs and the index list go to texture buffers.
+class LightClusterGrid
+{
+public:
+    static constexpr int TILES_X = 16;
+    static constexpr int TILES_Y = 9;
+    static constexpr int SLICES = 24;
+    static constexpr int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+
+    static constexpr GLuint LIGHTS_TEXTURE_UNIT = 11;
+    static constexpr GLuint GRID_TEXTURE_UNIT = 12;
+    static constexpr GLuint INDICES_TEXTURE_UNIT = 13;
+
+    LightClusterGrid();
+    ~LightClusterGrid();
+
+    LightClusterGrid(const LightClusterGrid &) = delete;
+    LightClusterGrid &operator=(const LightClusterGrid &) = delete;
+
+    // Rebuilds the view-space cluster boxes when the projection or screen size changed
+    void SetProjection(const glm::mat4 &projection, float nearPlane, float farPlane, float screenWidth, float screenHeight);
+
+    void Clear();
+    void AddLight(const GPULight &light, const glm::mat4 &view);
+    void Build();
+    void Bind() const;
+
+    glm::ivec4 GetGridSize() const { return glm::ivec4(TILES_X, TILES_Y, SLICES, 0); }
+    const glm::vec4 &GetParams() const { return m_Params; }
+    std::size_t GetLightCount() const { return m_Lights.size(); }
+    std::size_t GetIndexCount() const { return m_Indices.size(); }
+
+private:
+    struct ViewLight
+    {
+        glm::vec3 center; // view space
+        float radius;
+        glm::vec3 direction;
+        float cosOuter;
+        bool spot;
+    };
+
+    struct TextureBuffer
+    {
+        GLuint buffer = 0;
+        GLuint texture = 0;
+        GLenum format = 0;
+        std::size_t capacity = 0;
+        std::vector<unsigned char> uploaded; // what the GPU copy holds, for patching only changed spans
+    };
+
+    glm::mat4 m_Projection = glm::mat4(0.0f);
+    float m_Near = 0.0f;
+    float m_Far = 0.0f;
+    glm::vec2 m_Screen = glm::vec2(0.0f);
+    glm::vec4 m_Params = glm::vec4(0.0f);
+
+    // Cluster boxes in view space, split into streams for the SSE sphere test
+    std::vector<float> m_MinX, m_MinY, m_MinZ, m_MaxX, m_MaxY, m_MaxZ;
+
+    std::vector<GPULight> m_Lights;
+    std::vector<ViewLight> m_ViewLights;
+    std::vector<std::uint32_t> m_Counts;
+    std::vector<glm::uvec2> m_Grid;
+    std::vector<std::uint32_t> m_Indices;
+    std::vector<std::uint32_t> m_Hits; // cluster << 16 | light, sorted by a counting pass
+
+    TextureBuffer m_LightBuffer;
+    TextureBuffer m_GridBuffer;
+    TextureBuffer m_IndexBuffer;
+
+    int SliceFromDepth(float depth) const;
+    void AssignLight(std::uint32_t lightIndex);
+    void Upload(TextureBuffer &target, const void *data, std::size_t bytes);
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <engine/graphic/uniform_buffer.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class TextureSlot : std::uint8_t
+{
+    Diffuse = 0,
+    Specular,
+    Normal,
+    Height,
+    Count
+};
+
+constexpr std::size_t TEXTURE_SLOT_COUNT = (std::size_t)TextureSlot::Count;
+constexpr GLuint MATERIAL_TEXTURE_UNIT = 0;
+
+// Every slot samples from a fixed unit, so programs are configured once at link time
+GLint GetSamplerUnit(const std::string &samplerName);
+
+using MaterialHandle = std::uint32_t;
+constexpr MaterialHandle INVALID_MATERIAL = 0xFFFFFFFFu;
+constexpr MaterialHandle DEFAULT_MATERIAL = 0;
+
+// Mirrors the MaterialParams block in resources/shaders/material.glsl
+struct MaterialParams
+{
+    glm::vec4 baseColor = glm::vec4(1.0f);
+    glm::vec4 specular = glm::vec4(1.0f, 1.0f, 1.0f, 32.0f);
+};
+
+struct Material
+{
+    std::array<GLuint, TEXTURE_SLOT_COUNT> textures{};
+    MaterialParams params;
+
+    void SetTexture(TextureSlot slot, GLuint texture) { textures[(std::size_t)slot] = texture; }
+    GLuint GetTexture(TextureSlot slot) const { return textures[(std::size_t)slot]; }
+};
+
+class MaterialLibrary
+{
+public:
+    static MaterialLibrary &Get();
+
+    // Deletes the parameter buffer and fallback texture while the context is still current
+    void Shutdown();
+
+    MaterialHandle Create(const Material &material);
+    // Freed slots drop their texture names and are handed out again by Create()
+    void Release(MaterialHandle handle);
+    const Material &GetMaterial(MaterialHandle handle) const;
+    void SetParams(MaterialHandle handle, const MaterialParams &params);
+
+    void Bind(MaterialHandle handle);
+
+    std::size_t Size() const { return m_Materials.size(); }
+
+private:
+    std::vector<Material> m_Materials;
+    std::vector<MaterialHandle> m_FreeHandles;
+    std::vector<unsigned char> m_Staging;
+    std::unique_ptr<UniformBuffer> m_Params;
+    std::size_t m_Capacity = 0;
+    GLsizeiptr m_Stride = 0;
+    bool m_Dirty = true;
+    GLuint m_WhiteTexture = 0;
+
+    MaterialLibrary();
+
+    MaterialHandle Resolve(MaterialHandle handle) const;
+    void Upload();
+    void CreateWhiteTexture();
+};
@@ -3,23 +3,15 @@
 #include <glm/glm.hpp>
 
 #include <engine/graphic/shader.h>
+#include <engine/graphic/instance_buffer.h>
+#include <engine/graphic/material.h>
+#include <engine/graphic/bounds.h>
+#include <engine/graphic/geometry_arena.h>
+#include <engine/graphic/vertex_format.h>
 
 #include <string>
 #include <vector>
 
-#define MAX_BONE_INFLUENCE 4
-
-struct Vertex
-{
-    glm::vec3 Position;
-    glm::vec3 Normal;
-    glm::vec2 TexCoords;
-    glm::vec3 Tangent;
-    glm::vec3 Bitangent;
-    int m_BoneIDs[MAX_BONE_INFLUENCE];
-    float m_Weights[MAX_BONE_INFLUENCE];
-};
-
 struct Texture
 {
     unsigned int id;
@@ -27,18 +19,70 @@ struct Texture
     std::string path;
 };
 
+// A simplified level drawn with the full mesh's vertices and its own index range
+struct MeshLod
+{
+    std::vector<unsigned int> indices;
+    GeometryAllocation geometry;
+    float error; // largest deviation from the full mesh, in model units
+};
+
 class Mesh
 {
 public:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
-    unsigned int VAO;
 
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
-    void Draw(Shader &shader);
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+         MaterialHandle material = INVALID_MATERIAL);
+    // Cooked mesh: vertices and indices arrive already in their GPU layout and are uploaded as is.
+    // vertices, indices and textures stay empty; only positions and the indices in their packed
+    // type are kept for CPU passes such as occlusion, through GetPositions() and GetIndices().
+    Mesh(VertexFormat format, const void *packedVertices, std::size_t vertexCount, const void *packedIndices,
+         std::size_t indexCount, GLenum indexType, MaterialHandle material, const AABB &bounds,
+         const BoundingSphere &sphere);
+    // geometry replaces the mesh's own vertices, e.g. with the output of the skinning pass
+    void Draw(MaterialHandle material = INVALID_MATERIAL, const GeometryAllocation *geometry = nullptr);
+    void DrawInstanced(const InstanceBuffer &instances, GLuint firstInstance, GLsizei count,
+                       MaterialHandle material = INVALID_MATERIAL, const GeometryAllocation *geometry = nullptr);
+
+    unsigned int GetSortId() const { return m_SortId; }
+    MaterialHandle GetMaterial() const { return m_Material; }
+    const AABB &GetBounds() const { return m_Bounds; }
+    const BoundingSphere &GetBoundingSphere() const { return m_Sphere; }
+    // Level 0 is the full mesh; levels past the last one clamp to it
+    const GeometryAllocation &GetGeometry(std::size_t lod = 0) const;
+    float GetLodError(std::size_t lod) const;
+    std::size_t GetLodCount() const { return m_Lods.size() + 1; }
+    const std::vector<MeshLod> &GetLods() const { return m_Lods; }
+    // CPU passes walk positions with a stride, so either representation works
+    const void *GetPositions() const { return vertices.empty() ? (const void *)m_Positions.data() : vertices.data(); }
+    std::size_t GetPositionStride() const { return vertices.empty() ? sizeof(glm::vec3) : sizeof(Vertex); }
+    // Indices of the full mesh, in the type GetIndexType() names
+    const void *GetIndices() const { return indices.empty() ? (const void *)m_PackedIndices.data() : indices.data(); }
+    GLenum GetIndexType() const { return indices.empty() ? m_Geometry.indexType : GL_UNSIGNED_INT; }
+    std::size_t GetIndexCount() const { return indices.empty() ? m_Geometry.indexCount : indices.size(); }
+
+    // error is relative to the bounding radius, as returned by MeshSimplifier
+    void AddLod(std::vector<unsigned int> lodIndices, float error);
+    // Cooked level: indices already in the mesh's index type, error in model units
+    void AddPackedLod(const void *lodIndices, std::size_t indexCount, float error);
+
+    std::size_t GetGpuBytes() const;
+    // Returns the mesh's ranges to the geometry arena; only the owning model calls this, once
+    void Release();
 
 private:
-    unsigned int VBO, EBO;
+    GeometryAllocation m_Geometry;
+    std::vector<glm::vec3> m_Positions;
+    std::vector<unsigned char> m_PackedIndices;
+    std::vector<MeshLod> m_Lods;
+    unsigned int m_SortId;
+    MaterialHandle m_Material;
+    AABB m_Bounds;
+    BoundingSphere m_Sphere;
+
     void setupMesh();
+    void computeBounds();
 };
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <engine/graphic/vertex_format.h>
+
+#include <cstddef>
+#include <vector>
+
+// Post-transform cache statistics from a FIFO cache simulation.
+// ACMR = misses per triangle (0.5 is ideal), ATVR = misses per vertex (1.0 is ideal).
+struct VertexCacheStats
+{
+    std::size_t triangles = 0;
+    std::size_t vertices = 0;
+    std::size_t misses = 0;
+
+    float GetACMR() const { return triangles ? (float)misses / triangles : 0.0f; }
+    float GetATVR() const { return vertices ? (float)misses / vertices : 0.0f; }
+    void Merge(const VertexCacheStats &other);
+};
+
+struct MeshOptimizationReport
+{
+    VertexCacheStats before;
+    VertexCacheStats after;
+    std::size_t verticesBefore = 0;
+    std::size_t verticesAfter = 0;
+
+    void Merge(const MeshOptimizationReport &other);
+};
+
+class MeshOptimizer
+{
+public:
+    static constexpr unsigned int DEFAULT_CACHE_SIZE = 16;
+    static constexpr float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+    static VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int> &indices, std::size_t vertexCount,
+                                               unsigned int cacheSize = DEFAULT_CACHE_SIZE);
+
+    // Merges bitwise identical vertices and rewrites the index buffer
+    static void DeduplicateVertices(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+    // Forsyth's linear-speed triangle reordering for the post-transform cache
+    static void OptimizeVertexCache(std::vector<unsigned int> &indices, std::size_t vertexCount);
+
+    // Splits a cache-optimised index buffer into clusters and draws outward facing clusters first.
+    // Clusters are cut where the cache restarts anyway, or where the running ACMR stays under threshold.
+    static void OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                                 float threshold = DEFAULT_OVERDRAW_THRESHOLD);
+
+    // Renumbers vertices in first-use order and drops unreferenced ones
+    static void OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+    // Runs every pass above in order
+    static MeshOptimizationReport Optimize(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <engine/graphic/vertex_format.h>
+
+#include <cstddef>
+#include <vector>
+
+struct MeshLodSettings
+{
+    // Triangle count of each generated level relative to the full mesh, finest first
+    std::vector<float> ratios = {0.5f, 0.25f, 0.125f};
+    // Largest geometric error a level may introduce, relative to the mesh's bounding radius
+    float maxError = 0.05f;
+};
+
+struct MeshLodLevel
+{
+    std::vector<unsigned int> indices;
+    float error; // relative to the mesh's bounding radius
+};
+
+class MeshSimplifier
+{
+public:
+    // Quadric error edge collapse (Garland-Heckbert) that only moves vertices onto existing
+    // neighbours, so the result is a new index buffer over the same vertices. UV seams, open
+    // borders and non-manifold edges are locked. Stops at targetIndexCount or when the next
+    // collapse would exceed maxError; error receives the largest error introduced.
+    static std::vector<unsigned int> Simplify(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                              std::size_t targetIndexCount, float maxError, float *error = nullptr);
+
+    // Builds one level per ratio, each simplified from the previous one and reordered for the
+    // vertex cache. Stops early once a level no longer removes a meaningful share of triangles.
+    static std::vector<MeshLodLevel> GenerateLods(const std::vector<Vertex> &vertices,
+                                                  const std::vector<unsigned int> &indices,
+                                                  const MeshLodSettings &settings);
+};
@@ -3,23 +3,119 @@
 #include <glm/glm.hpp>
 #include <assimp/scene.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+#include <engine/core/asset_cooker.h>
 #include <engine/graphic/mesh.h>
+#include <engine/graphic/mesh_optimizer.h>
+#include <engine/graphic/mesh_simplifier.h>
 #include <engine/graphic/shader.h>
+#include <engine/graphic/texture_2d.h>
 #include <engine/graphic/animdata.h>
 
+// Everything a model needs before it touches GL. Model::Import fills it on any thread; the GL
+// objects are created from it afterwards on the main thread.
+struct ModelData
+{
+	struct Lod
+	{
+		const unsigned char *indices = nullptr;
+		std::uint32_t indexCount = 0;
+		float error = 0.0f; // model units
+	};
+
+	// Vertices and indices are already in their GPU layout and point either into storage or
+	// into the cooked file
+	struct MeshData
+	{
+		VertexFormat format = VertexFormat::Static;
+		GLenum indexType = GL_UNSIGNED_INT;
+		std::uint32_t vertexCount = 0;
+		std::uint32_t indexCount = 0;
+		std::uint32_t material = 0;
+		AABB bounds;
+		BoundingSphere sphere;
+		const unsigned char *vertices = nullptr;
+		const unsigned char *indices = nullptr;
+		std::vector<Lod> lods;
+		std::vector<unsigned char> storage;
+	};
+
+	struct MaterialData
+	{
+		MaterialParams params;
+		std::vector<Texture> textures; // ids are filled in once the images are uploaded
+	};
+
+	// data stays empty when the TextureCache already holds the texture
+	struct Image
+	{
+		std::string path;
+		std::string type;
+		ImageData data;
+		TextureKey key = 0;
+		GLuint id = 0;
+	};
+
+	std::string path;
+	std::string directory;
+	std::vector<MeshData> meshes;
+	std::vector<MaterialData> materials;
+	std::vector<Image> images;
+	std::map<std::string, BoneInfo> boneInfoMap;
+	int boneCounter = 0;
+	MappedFile cooked;
+};
+
 class Model
 {
 public:
-	std::vector<Texture> textures_loaded;
 	std::vector<Mesh> meshes;
 	std::string directory;
 	bool gammaCorrection;
 
-	Model(std::string const &path, bool gamma = false);
+	// Imports and uploads in one go. The model is cooked for the file's contents and LOD
+	// settings, together with the file's animation clip if it has one, and later loads map the
+	// cooked file instead of importing.
+	Model(std::string const &path, bool gamma = false, const MeshLodSettings &lodSettings = MeshLodSettings{});
+	// Empty model for data imported elsewhere; UploadStep() fills it in. Makes no GL calls.
+	Model(const ModelData &data, bool gamma = false);
+	~Model();
 
-	void Draw(Shader &shader);
+	Model(const Model &) = delete;
+	Model &operator=(const Model &) = delete;
+
+	static constexpr std::uint32_t COOKED_MAGIC = 0x4C444F4D; // "MODL"
+	// Bumped when cooked contents change meaning, so older cooks are rebuilt
+	static constexpr std::uint32_t COOKED_REVISION = 2;
+
+	// Reads the cooked file or imports through Assimp, converting meshes and decoding images in
+	// parallel on the job system. Makes no GL calls, so it may run on a worker thread.
+	static bool Import(std::string const &path, const MeshLodSettings &lodSettings, ModelData &data);
+	// Creates the GL objects for the next piece of data: one texture per call (or a reference to
+	// the cached one), then the materials with the first mesh, then one mesh per call. Adds what
+	// it uploaded to bytes and returns true once the model is complete.
+	bool UploadStep(ModelData &data, std::size_t &bytes);
+
+	void Draw();
+	void DrawInstanced(const InstanceBuffer &instances, GLuint firstInstance, GLsizei count);
+
+	const AABB &GetBounds() const { return m_Bounds; }
+	const BoundingSphere &GetBoundingSphere() const { return m_Sphere; }
+
+	// Largest error of any mesh at that level, in model units; meshes with fewer levels use their last
+	std::size_t GetLodCount() const { return m_LodErrors.size(); }
+	float GetLodError(std::size_t lod) const { return m_LodErrors[std::min(lod, m_LodErrors.size() - 1)]; }
+
+	// Geometry only; textures are shared and counted by the TextureCache
+	std::size_t GetGpuBytes() const;
+	// Streamed textures in the TextureCache; the renderer requests mips for them
+	const std::vector<TextureKey> &GetTextureKeys() const { return m_TextureKeys; }
 
 	std::map<std::string, BoneInfo> &GetBoneInfoMap();
 	int &GetBoneCount();
@@ -27,13 +123,31 @@ public:
 private:
 	std::map<std::string, BoneInfo> m_BoneInfoMap;
 	int m_BoneCounter = 0;
+	std::vector<MaterialHandle> m_Materials;
+	AABB m_Bounds;
+	BoundingSphere m_Sphere;
+	std::vector<float> m_LodErrors = {0.0f};
+	std::vector<TextureKey> m_TextureKeys;
+	std::size_t m_UploadCursor = 0;
+
+	void finishLoading(std::string const &path);
+	static std::uint64_t getCookSettingsHash(const MeshLodSettings &lodSettings);
+	static bool loadCooked(std::string const &cookedPath, std::uint64_t sourceHash, std::uint64_t settingsHash,
+						   ModelData &data);
+	static void cookModel(std::string const &cookedPath, std::uint64_t sourceHash, std::uint64_t settingsHash,
+						  const ModelData &data);
 
-	void loadModel(std::string const &path);
-	void processNode(aiNode *node, const aiScene *scene);
-	void SetVertexBoneDataToDefault(Vertex &vertex);
-	Mesh processMesh(aiMesh *mesh, const aiScene *scene);
-	void SetVertexBoneData(Vertex &vertex, int boneID, float weight);
-	void ExtractBoneWeightForVertices(std::vector<Vertex> &vertices, aiMesh *mesh, const aiScene *scene);
-	unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false);
-	std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
-};
\ No newline at end of file
+	static void processNode(const aiNode *node, const aiScene *scene, std::vector<const aiMesh *> &sceneMeshes);
+	static void SetVertexBoneDataToDefault(Vertex &vertex);
+	static void processMesh(const aiMesh *mesh, const std::map<std::string, BoneInfo> &boneInfoMap,
+							const MeshLodSettings &lodSettings, ModelData::MeshData &result,
+							MeshOptimizationReport &report);
+	static MaterialParams loadMaterialParams(const aiMaterial *material, const std::vector<Texture> &textures);
+	static Material materialFromTextures(const std::vector<Texture> &textures);
+	static void SetVertexBoneData(Vertex &vertex, int boneID, float weight);
+	static void ExtractBoneWeightForVertices(std::vector<Vertex> &vertices, const aiMesh *mesh,
+											 const std::map<std::string, BoneInfo> &boneInfoMap);
+	static void loadMaterialTextures(const aiMaterial *mat, aiTextureType type, std::string typeName,
+									 std::vector<Texture> &textures, std::unordered_map<std::string, std::string> &seen);
+	static void decodeImages(ModelData &data);
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <engine/graphic/bounds.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU masked occlusion culling. Occluder triangles are rasterized into a low resolution buffer of
+// 32x4 pixel tiles; each tile keeps a coverage bit per pixel and two conservative depths (the
+// farthest depth of the fully covered reference layer, and of the partially covered working
+// layer). The reference depths form the hierarchical buffer that boxes are tested against.
+// Runs on the job system and never touches GL.
+class OcclusionCuller
+{
+public:
+    static constexpr int WIDTH = 256;
+    static constexpr int HEIGHT = 144;
+    static constexpr int TILE_WIDTH = 32;
+    static constexpr int TILE_HEIGHT = 4;
+    static constexpr int TILES_X = WIDTH / TILE_WIDTH;
+    static constexpr int TILES_Y = HEIGHT / TILE_HEIGHT;
+
+    OcclusionCuller();
+
+    void Begin(const glm::mat4 &viewProjection);
+    // Positions are read with the given byte stride and, like the 16 or 32-bit indices, must stay
+    // alive until Rasterize() returns
+    void AddOccluder(const void *positions, std::size_t stride, const void *indices, bool shortIndices,
+                     std::size_t indexCount, const glm::mat4 &model);
+    // Transforms and clips the occluders, then fills the tiles band by band on the job system
+    void Rasterize();
+
+    // False only when the box lies entirely behind rasterized occluders; safe to call from several threads
+    bool IsVisible(const AABB &box) const;
+
+    std::size_t GetOccluderCount() const { return m_Occluders.size(); }
+
+private:
+    struct Occluder
+    {
+        const unsigned char *positions;
+        std::size_t stride;
+        const void *indices;
+        bool shortIndices;
+        std::size_t indexCount;
+        glm::mat4 modelViewProjection;
+    };
+
+    // Screen space triangle: edge functions a*x + b*y + c >= 0 inside, depth plane z = zRef + dzdx*x + dzdy*y
+    struct Triangle
+    {
+        float a[3], b[3], c[3];
+        float minX, maxX, minY, maxY;
+        float zRef, dzdx, dzdy, zMax;
+    };
+
+    glm::mat4 m_ViewProjection = glm::mat4(1.0f);
+    std::vector<Occluder> m_Occluders;
+    std::vector<std::vector<Triangle>> m_Triangles; // one list per occluder, filled in parallel
+
+    std::vector<std::uint32_t> m_Masks; // four rows of 32 coverage bits per tile
+    std::vector<float> m_ZMax0;         // reference layer, the hierarchical depth
+    std::vector<float> m_ZMax1;         // working layer
+
+    void SetupTriangles(const Occluder &occluder, std::vector<Triangle> &triangles) const;
+    void RasterizeBand(int tileRow);
+    void UpdateTile(int tile, const std::uint32_t coverage[4], float depth);
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+enum class RenderPass : std::uint8_t
+{
+    Opaque = 0,
+    Transparent = 1,
+};
+
+struct RenderItem
+{
+    std::uint64_t key;
+    std::uint32_t payload;
+};
+
+// Draws are submitted as packed 64-bit keys and radix sorted in a side buffer,
+// so the ECS storage order never changes:
+//   opaque:      pass:2 | shader:12 | material:14 | mesh:16 | depth:20 (front to back)
+//   transparent: pass:2 | depth:20 (back to front) | shader:12 | material:14 | mesh:16
+class RenderQueue
+{
+public:
+    static constexpr int SHADER_BITS = 12;
+    static constexpr int MATERIAL_BITS = 14;
+    static constexpr int MESH_BITS = 16;
+    static constexpr int DEPTH_BITS = 20;
+
+    void Clear();
+    void Push(std::uint64_t key, std::uint32_t payload);
+    void Sort();
+
+    const std::vector<RenderItem> &GetItems() const { return m_Items; }
+    std::size_t Size() const { return m_Items.size(); }
+
+    static std::uint64_t MakeKey(RenderPass pass, std::uint32_t shader, std::uint32_t material,
+                                 std::uint32_t mesh, float depth);
+
+private:
+    std::vector<RenderItem> m_Items;
+    std::vector<RenderItem> m_Scratch;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+struct RenderStats
+{
+    unsigned int uniformLookups = 0;
+
+    unsigned int drawCalls = 0;
+    unsigned int materialBinds = 0;
+    unsigned int objectsTested = 0;
+    unsigned int objectsVisible = 0;
+    unsigned int objectsOccluded = 0;
+    unsigned int glCallsIssued = 0;
+    unsigned int glCallsElided = 0;
+    unsigned int verticesSkinned = 0;
+    unsigned int bytesUploaded = 0;
+
+    void Reset();
+
+    static RenderStats &Get();
+};
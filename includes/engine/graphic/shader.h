@@ -3,6 +3,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <engine/graphic/uniform.h>
+
 #include <string>
 
 class Shader
@@ -12,9 +14,21 @@ public:
 
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
            const char* tessControlPath = nullptr, const char* tessEvalPath = nullptr);
+    ~Shader();
+
+    Shader(const Shader &) = delete;
+    Shader &operator=(const Shader &) = delete;
 
     void use();
 
+    static std::string ResolveIncludes(const std::string &code, const std::string &path, int depth = 0);
+
+    bool IsInstanced() const { return m_Instanced; }
+    unsigned int GetSortId() const { return m_SortId; }
+
+    UniformHandle GetUniform(entt::id_type id) const;
+    UniformHandle GetUniform(const std::string &name) const;
+
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
     void setFloat(const std::string &name, float value) const;
@@ -28,6 +42,21 @@ public:
     void setMat3(const std::string &name, const glm::mat3 &mat) const;
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
 
+    void setBool(UniformHandle handle, bool value) const;
+    void setInt(UniformHandle handle, int value) const;
+    void setFloat(UniformHandle handle, float value) const;
+    void setVec2(UniformHandle handle, const glm::vec2 &value) const;
+    void setVec3(UniformHandle handle, const glm::vec3 &value) const;
+    void setVec4(UniformHandle handle, const glm::vec4 &value) const;
+    void setMat2(UniformHandle handle, const glm::mat2 &mat) const;
+    void setMat3(UniformHandle handle, const glm::mat3 &mat) const;
+    void setMat4(UniformHandle handle, const glm::mat4 &mat) const;
+    void setMat4Array(UniformHandle handle, const glm::mat4 *mats, int count) const;
+
 private:
+    UniformTable m_Uniforms;
+    bool m_Instanced = false;
+    unsigned int m_SortId;
+
     void checkCompileErrors(GLuint shader, std::string type);
 };
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <engine/graphic/uniform_buffer.h>
+
+#include <cstdint>
+#include <memory>
+
+constexpr int SHADOW_CASCADE_COUNT = 4;
+
+// Mirrors the std140 ShadowData block in resources/shaders/shadow.glsl
+struct ShadowConstants
+{
+    glm::mat4 cascadeViewProjection[SHADOW_CASCADE_COUNT];
+    glm::vec4 cascadeSplits;     // view-space far distance of each cascade
+    glm::vec4 cascadeTexelSizes; // world size of one shadow texel per cascade
+    glm::vec4 params;            // depth bias, enabled, unused, unused
+};
+
+static_assert(sizeof(ShadowConstants) % 16 == 0, "ShadowConstants must keep std140 alignment");
+
+struct ShadowCascade
+{
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    glm::vec3 lightSpaceCenter = glm::vec3(0.0f); // snapped, see CascadedShadowMap::Update
+    float halfSize = 0.0f;
+    float splitFar = 0.0f;
+};
+
+// Directional cascades with two depth arrays: a cache holding static casters, and
+// the live array sampled by shaders. Each frame the cache is copied into the live
+// array and only dynamic casters are drawn on top. Cascade centres are snapped to
+// a coarse light-space grid, so the cache only goes stale when a cascade crosses a
+// grid cell, the light turns, or static geometry changes.
+class CascadedShadowMap
+{
+public:
+    static constexpr GLsizei DEFAULT_RESOLUTION = 2048;
+    static constexpr GLuint TEXTURE_UNIT = 14;
+    static constexpr float MAX_DISTANCE = 60.0f;
+    static constexpr float SPLIT_LAMBDA = 0.75f;
+    // Extra cascade size spent on snap slack; larger means fewer cache refreshes but blurrier shadows
+    static constexpr float SNAP_MARGIN = 0.125f;
+    // How far behind a cascade casters are still captured
+    static constexpr float CASTER_PULLBACK = 50.0f;
+
+    CascadedShadowMap(GLsizei resolution = DEFAULT_RESOLUTION);
+    ~CascadedShadowMap();
+
+    CascadedShadowMap(const CascadedShadowMap &) = delete;
+    CascadedShadowMap &operator=(const CascadedShadowMap &) = delete;
+
+    // Returns a bit per cascade whose static cache must be redrawn
+    std::uint32_t Update(const glm::mat4 &cameraView, float fov, float aspect, float nearPlane, float farPlane,
+                         const glm::vec3 &lightDirection);
+    void Disable();
+    void InvalidateStatic() { m_StaticValid = 0; }
+    void MarkStaticValid(int cascade) { m_StaticValid |= 1u << cascade; }
+
+    void BeginStaticCascade(int cascade);
+    void BeginDynamicCascade(int cascade);
+    void End();
+
+    // Binds the live array to TEXTURE_UNIT
+    void Bind() const;
+
+    const ShadowCascade &GetCascade(int cascade) const { return m_Cascades[cascade]; }
+    GLsizei GetResolution() const { return m_Resolution; }
+    bool IsEnabled() const { return m_Constants.params.y > 0.0f; }
+
+private:
+    GLsizei m_Resolution;
+    GLuint m_LiveTexture = 0;
+    GLuint m_CacheTexture = 0;
+    GLuint m_LiveFramebuffer = 0;
+    GLuint m_CacheFramebuffer = 0;
+
+    ShadowCascade m_Cascades[SHADOW_CASCADE_COUNT];
+    ShadowConstants m_Constants{};
+    std::unique_ptr<UniformBuffer> m_Buffer;
+    glm::vec3 m_LightDirection = glm::vec3(0.0f);
+    std::uint32_t m_StaticValid = 0;
+
+    GLuint CreateDepthArray() const;
+};
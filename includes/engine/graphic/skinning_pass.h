@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <engine/graphic/compute_shader.h>
+#include <engine/graphic/geometry_arena.h>
+#include <engine/graphic/mesh.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Compute shaders need a 4.3 context; 3.3 keeps skinning in the vertex shader
+bool IsComputeSkinningSupported();
+
+// Skins animated meshes once per frame into Static vertices inside the geometry
+// arena. The result reuses the source mesh's indices, so every pass draws a
+// skinned mesh exactly like a static one.
+class SkinningPass
+{
+public:
+    static constexpr std::uint64_t RELEASE_AFTER_FRAMES = 120;
+    static constexpr GLuint WORKGROUP_SIZE = 64;
+
+    SkinningPass();
+    ~SkinningPass();
+
+    SkinningPass(const SkinningPass &) = delete;
+    SkinningPass &operator=(const SkinningPass &) = delete;
+
+    void BeginFrame();
+
+    // boneOffset is the absolute first matrix in the bone palette. Repeated calls for the
+    // same owner and mesh within a frame return the already skinned geometry. Every level of
+    // detail shares the skinned vertices, so lod only picks the index range.
+    const GeometryAllocation *Skin(std::uint32_t owner, const Mesh &mesh, int boneOffset, std::size_t lod = 0);
+
+    // Makes this frame's output visible to vertex fetch and releases outputs unused for a while
+    void Flush();
+
+    std::size_t GetSkinnedVertices() const { return m_SkinnedVertices; }
+
+private:
+    struct Output
+    {
+        GeometryAllocation geometry;
+        std::vector<GeometryAllocation> lods;
+        std::uint64_t frame = 0;
+    };
+
+    struct Uniforms
+    {
+        UniformHandle sourceBase;
+        UniformHandle sourceStride;
+        UniformHandle wideBoneIds;
+        UniformHandle outputBase;
+        UniformHandle vertexCount;
+        UniformHandle boneOffset;
+    };
+
+    std::unique_ptr<ComputeShader> m_Shader;
+    Uniforms m_Uniforms;
+    std::unordered_map<std::uint64_t, Output> m_Outputs;
+    std::uint64_t m_Frame = 0;
+    std::size_t m_SkinnedVertices = 0;
+    bool m_Dispatched = false;
+};
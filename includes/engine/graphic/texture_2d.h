@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <engine/core/mapped_file.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Identifies a texture in the TextureCache
+using TextureKey = std::uint64_t;
+
+// Image waiting to be uploaded; safe to produce on any thread. Either decoded pixels, or a
+// cooked block-compressed mip chain pointing into its mapped file.
+struct ImageData
+{
+    struct Free
+    {
+        void operator()(unsigned char *pixels) const;
+    };
+
+    struct Level
+    {
+        const unsigned char *data;
+        std::size_t size;
+        int width;
+        int height;
+    };
+
+    std::unique_ptr<unsigned char, Free> pixels;
+    int width = 0;
+    int height = 0;
+    int components = 0;
+
+    GLenum compressedFormat = 0;
+    std::vector<Level> levels;
+    MappedFile cooked;
+
+    bool IsCompressed() const { return !levels.empty(); }
+    std::size_t GetSize() const;
+};
+
+// Holds one reference to a colour texture in the TextureCache. Textures are cooked by
+// TextureCooker and uploaded with their mip chain; images that could not be cooked are
+// uploaded as decoded and mipmapped by the driver.
+class Texture2D
+{
+public:
+    explicit Texture2D(const std::string &path, bool gamma = false);
+    // image is what a loader already read for path; it is only used if the cache misses
+    Texture2D(const std::string &path, ImageData &image, bool gamma = false);
+    ~Texture2D();
+
+    Texture2D(const Texture2D &) = delete;
+    Texture2D &operator=(const Texture2D &) = delete;
+
+    GLuint GetId() const { return m_Id; }
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+    std::size_t GetGpuBytes() const { return m_GpuBytes; }
+    bool IsValid() const { return m_Width > 0; }
+
+    // Plain stb_image decode. No GL calls, so loaders decode on worker threads.
+    static ImageData Decode(const std::string &path);
+    // Creates a texture from an image through the upload queue's pixel buffer; the caller owns
+    // it, which is normally the TextureCache. An empty image still yields a texture so it can always be bound. bytes receives
+    // the size of the mip chain. A compressed image is uploaded from firstLevel down, leaving
+    // the larger levels to be streamed in later.
+    static GLuint Create(const ImageData &image, bool gamma = false, std::size_t *bytes = nullptr,
+                         std::size_t firstLevel = 0);
+    // Uploads the compressed levels [first, last) of image to id and makes first its base level;
+    // returns the bytes uploaded
+    static std::size_t UploadLevels(GLuint id, const ImageData &image, std::size_t first, std::size_t last,
+                                    bool gamma);
+
+private:
+    TextureKey m_Key = 0;
+    GLuint m_Id = 0;
+    int m_Width = 0;
+    int m_Height = 0;
+    std::size_t m_GpuBytes = 0;
+
+    void acquire(const std::string &path, ImageData *image, bool gamma);
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <engine/core/job_system.h>
+#include <engine/graphic/texture_2d.h>
+#include <engine/graphic/texture_cooker.h>
+
+#include <cstddef>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct CachedTexture
+{
+    GLuint id = 0;
+    int width = 0;
+    int height = 0;
+    std::size_t bytes = 0;
+};
+
+// Every GL texture loaded from a file, shared process-wide. A texture is keyed by the hash of
+// its file's contents plus how it is uploaded, so the same image reached through different
+// paths or models is uploaded once. Textures are reference counted and freed with their last
+// reference.
+//
+// Cooked textures acquired as streamed start with only their small tail mips resident. The
+// renderer reports how many pixels each one covers on screen, and Update() reads the larger
+// levels that are needed on worker threads, then drops the top levels of the least recently
+// needed textures while resident textures exceed the budget.
+class TextureCache
+{
+public:
+    // Levels no larger than this are uploaded with a streamed texture and never dropped
+    static constexpr int STREAM_TAIL_SIZE = 64;
+    // A texture not requested for this many frames falls back to its tail
+    static constexpr std::uint32_t STREAM_IDLE_FRAMES = 120;
+    static constexpr std::size_t DEFAULT_BUDGET = 256u << 20;
+
+    static TextureCache &Get();
+
+    TextureCache(const TextureCache &) = delete;
+    TextureCache &operator=(const TextureCache &) = delete;
+
+    // Hashes the file on first use, so loaders compute keys on their worker threads
+    static TextureKey MakeKey(const std::string &path, TextureUsage usage, bool gamma);
+
+    // Safe to call from any thread, so loaders can skip decoding what is already uploaded
+    bool Contains(TextureKey key) const;
+    // Main thread. Adds a reference to the texture for key, uploading it first when it is not
+    // cached: from image if that holds data, otherwise loaded from path. A streamed texture
+    // keeps only the mips its requests need; acquiring one unstreamed pins its full chain.
+    CachedTexture Acquire(TextureKey key, const std::string &path, TextureUsage usage, bool gamma,
+                          ImageData *image = nullptr, bool streamed = false);
+    // Main thread; deletes the texture with its last reference
+    void Release(TextureKey key);
+    // Deletes every texture, referenced or not; must run while the GL context is still alive
+    void Clear();
+
+    // Main thread, during the frame: the texture covers about pixels across on screen
+    void Request(TextureKey key, float pixels);
+    // Main thread, once per frame after rendering
+    void Update();
+
+    void SetBudget(std::size_t bytes) { m_Budget = bytes; }
+    std::size_t GetBudget() const { return m_Budget; }
+    std::size_t GetBytes() const;
+    std::size_t GetCount() const;
+
+private:
+    struct Entry
+    {
+        CachedTexture texture;
+        std::uint32_t references = 0;
+
+        // Streaming state; levels only carry sizes, their data is read again from the cooked file
+        bool streamed = false;
+        std::size_t pendingBytes = 0; // levels being read; nonzero while a stream is in flight
+        std::string path;
+        TextureUsage usage = TextureUsage::Color;
+        bool gamma = false;
+        GLenum format = 0;
+        std::vector<ImageData::Level> levels;
+        std::size_t resident = 0; // base level; every level from here down is uploaded
+        std::size_t tail = 0;     // first level that is never dropped
+        std::size_t target = 0;   // level the recent requests need
+        std::size_t requested = 0;
+        std::uint32_t requestFrame = 0;
+    };
+
+    // Levels read on a worker thread, copied out of the cooked file
+    struct StreamedLevels
+    {
+        ImageData image;
+        std::vector<unsigned char> storage;
+    };
+
+    std::unordered_map<TextureKey, Entry> m_Entries;
+    std::size_t m_Bytes = 0;
+    std::size_t m_PendingBytes = 0;
+    std::size_t m_Budget = DEFAULT_BUDGET;
+    std::uint32_t m_Frame = 1;
+    JobCounter m_Streams;
+    mutable std::mutex m_Mutex;
+
+    TextureCache() = default;
+
+    static std::size_t getRangeBytes(const Entry &entry, std::size_t first, std::size_t last);
+    void stream(TextureKey key, Entry &entry, std::size_t first);
+    void finishStream(TextureKey key, std::size_t first, std::size_t last, const StreamedLevels &levels);
+    void dropLevels(Entry &entry, std::size_t base);
+};
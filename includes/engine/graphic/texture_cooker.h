@@ -0,0 +1,65 @@
+#pragma once
+
+#include <engine/graphic/texture_2d.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// S3TC is not core, so the loader does not define it; RGTC (BC4/BC5) is core since 3.0
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+// What a texture holds, which decides how its mips are filtered and which block format it gets
+enum class TextureUsage : std::uint8_t
+{
+    Color,  // sRGB encoded; mips are averaged in linear space
+    Data,   // linear values such as specular or height
+    Normal, // tangent-space normals; stored as BC5 (x, y), so shaders rebuild z
+};
+
+// Cooks images into block-compressed mip chains: BC1 for opaque colour, BC3 with alpha, BC4
+// for one channel and BC5 for two channels or normal maps. Mips are built on the CPU from the
+// full-resolution image, so the driver never runs glGenerateMipmap on them.
+class TextureCooker
+{
+public:
+    static constexpr std::uint32_t COOKED_MAGIC = 0x58455454; // "TTEX"
+    static constexpr std::uint32_t MAX_LEVELS = 16;
+
+    // Maps the cooked texture for the file's contents, cooking it on first use; an image that
+    // cannot be cooked comes back decoded instead. No GL calls.
+    static ImageData Load(const std::string &path, TextureUsage usage);
+    // Usage for a model texture type such as "texture_normal"
+    static TextureUsage GetUsage(const std::string &textureType);
+
+    static GLenum GetSrgbFormat(GLenum format);
+    static std::size_t GetBlockBytes(GLenum format);
+    static std::size_t GetLevelSize(GLenum format, int width, int height);
+
+private:
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<unsigned char> data;
+    };
+
+    static GLenum chooseFormat(const ImageData &image, TextureUsage usage);
+    static std::vector<Level> buildMips(const ImageData &image, TextureUsage usage);
+    static std::vector<unsigned char> compress(const Level &level, int components, GLenum format);
+    static bool cook(const ImageData &image, TextureUsage usage, const std::string &cookedPath,
+                     std::uint64_t sourceHash, std::uint64_t settingsHash);
+    static bool readCooked(const std::string &cookedPath, std::uint64_t sourceHash, std::uint64_t settingsHash,
+                           ImageData &image);
+};
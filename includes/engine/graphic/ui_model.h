@@ -27,5 +27,9 @@ private:
     UIType m_Type;
     unsigned int m_TextureID = 0;
 
+    unsigned int m_UniformProgram = 0;
+    UniformHandle m_SpriteColor;
+    UniformHandle m_HasTexture;
+
     void InitQuad();
 };
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <entt/core/hashed_string.hpp>
+
+#include <string>
+#include <unordered_map>
+
+struct UniformHandle
+{
+    GLint location = -1;
+
+    bool IsValid() const { return location >= 0; }
+};
+
+struct UniformInfo
+{
+    GLint location;
+    GLenum type;
+    GLint size;
+};
+
+class UniformTable
+{
+public:
+    void Reflect(GLuint program);
+
+    UniformHandle Find(entt::id_type id) const;
+    UniformHandle Find(const std::string &name) const;
+    const UniformInfo *GetInfo(entt::id_type id) const;
+    std::size_t Size() const { return m_Uniforms.size(); }
+
+private:
+    std::unordered_map<entt::id_type, UniformInfo> m_Uniforms;
+
+    void Add(const std::string &name, const UniformInfo &info);
+};
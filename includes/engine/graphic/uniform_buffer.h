@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+enum UniformBlockBinding : GLuint
+{
+    FRAME_CONSTANTS_BINDING = 0,
+    MATERIAL_PARAMS_BINDING = 1,
+    SHADOW_DATA_BINDING = 2,
+};
+
+GLint GetUniformBlockBinding(const std::string &blockName);
+
+class UniformBuffer
+{
+public:
+    UniformBuffer(GLsizeiptr size, GLuint binding);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer &) = delete;
+    UniformBuffer &operator=(const UniformBuffer &) = delete;
+
+    void Update(const void *data, GLsizeiptr size, GLintptr offset = 0);
+    // Compares the whole block against what was last sent and uploads only the vec4 rows that
+    // differ, coalesced into contiguous ranges; returns the number of bytes sent
+    GLsizeiptr Patch(const void *data);
+
+    GLuint GetID() const { return m_ID; }
+    GLuint GetBinding() const { return m_Binding; }
+    GLsizeiptr GetSize() const { return m_Size; }
+
+private:
+    GLuint m_ID = 0;
+    GLuint m_Binding;
+    GLsizeiptr m_Size;
+    std::vector<unsigned char> m_Shadow;
+    bool m_ShadowValid = false;
+};
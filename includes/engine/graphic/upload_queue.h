@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// GL work handed over from loader threads. Process() runs on the main thread once per frame
+// and stops when the frame's time or byte budget is spent, so a level load streams in over
+// several frames instead of stalling one.
+class UploadQueue
+{
+public:
+    static constexpr double DEFAULT_TIME_BUDGET_MS = 2.0;
+    static constexpr std::size_t DEFAULT_BYTE_BUDGET = 16u << 20;
+
+    // Does the next piece of work and adds what it uploaded to bytes. Returning false keeps the
+    // task at the front of the queue to continue later, so large assets can be split into steps.
+    using Task = std::function<bool(std::size_t &bytes)>;
+
+    static UploadQueue &Get();
+
+    UploadQueue(const UploadQueue &) = delete;
+    UploadQueue &operator=(const UploadQueue &) = delete;
+
+    // Safe to call from any thread
+    void Push(Task task);
+    void Process();
+    // Drops queued work without running it and frees the pixel buffer; main thread only
+    void Clear();
+
+    void SetBudget(double milliseconds, std::size_t bytes);
+    std::size_t GetPendingCount() const;
+
+    // Copies pixels into the pixel unpack buffer and leaves it bound; returns what to pass as the
+    // pixel pointer to glTexImage2D. EndStaging() unbinds it again.
+    const void *StagePixels(const void *pixels, std::size_t bytes);
+    void EndStaging();
+
+private:
+    std::deque<Task> m_Tasks;
+    mutable std::mutex m_Mutex;
+    double m_TimeBudget = DEFAULT_TIME_BUDGET_MS;
+    std::size_t m_ByteBudget = DEFAULT_BYTE_BUDGET;
+    GLuint m_PixelBuffer = 0;
+
+    UploadQueue() = default;
+};
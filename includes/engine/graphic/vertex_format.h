@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#define MAX_BONE_INFLUENCE 4
+
+// Full precision vertex used while importing and processing meshes on the CPU
+struct Vertex
+{
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+    glm::vec3 Tangent;
+    glm::vec3 Bitangent;
+    int m_BoneIDs[MAX_BONE_INFLUENCE];
+    float m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// GPU layouts. Normals are octahedral snorm16x2, tangents 2_10_10_10 with the
+// bitangent sign in w, UVs half floats, bone weights unorm8.
+enum class VertexFormat : std::uint8_t
+{
+    Static = 0,
+    Skinned,
+    Skinned16,
+    Count
+};
+
+constexpr std::size_t VERTEX_FORMAT_COUNT = (std::size_t)VertexFormat::Count;
+
+struct StaticVertex
+{
+    glm::vec3 position;
+    std::int16_t normal[2];
+    std::uint32_t tangent;
+    std::uint16_t texCoords[2];
+};
+
+struct SkinnedVertex
+{
+    StaticVertex base;
+    std::uint8_t boneIds[MAX_BONE_INFLUENCE];
+    std::uint8_t weights[MAX_BONE_INFLUENCE];
+};
+
+struct Skinned16Vertex
+{
+    StaticVertex base;
+    std::uint16_t boneIds[MAX_BONE_INFLUENCE];
+    std::uint8_t weights[MAX_BONE_INFLUENCE];
+};
+
+static_assert(sizeof(StaticVertex) == 24, "StaticVertex must stay tightly packed");
+static_assert(sizeof(SkinnedVertex) == 32, "SkinnedVertex must stay tightly packed");
+static_assert(sizeof(Skinned16Vertex) == 36, "Skinned16Vertex must stay tightly packed");
+
+struct VertexAttribute
+{
+    GLuint location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    bool integer;
+    GLuint offset;
+};
+
+struct VertexFormatDescriptor
+{
+    GLsizei stride;
+    std::uint32_t attributeCount;
+    std::array<VertexAttribute, 6> attributes;
+};
+
+const VertexFormatDescriptor &GetVertexFormatDescriptor(VertexFormat format);
+GLsizei GetVertexStride(VertexFormat format);
+
+// Smallest layout that can hold the mesh: no weights -> Static, bone ids < 256 -> Skinned
+VertexFormat ChooseVertexFormat(const std::vector<Vertex> &vertices);
+std::vector<unsigned char> PackVertices(VertexFormat format, const std::vector<Vertex> &vertices);
+
+// Points the attributes of the bound VAO at the bound GL_ARRAY_BUFFER
+void SetupVertexAttributes(VertexFormat format);
@@ -1,11 +1,33 @@
 #version 330 core
 out vec4 FragColor;
 
-in vec2 TexCoords;
+#include "frame_constants.glsl"
+#include "material.glsl"
+#include "lighting.glsl"
+#include "shadow.glsl"
 
-uniform sampler2D texture_diffuse1;
+in vec2 TexCoords;
+in vec3 FragPos;
+in vec3 Normal;
+in vec4 Color;
 
 void main()
 {    
-    FragColor = texture(texture_diffuse1, TexCoords);
+    vec4 albedo = texture(texture_diffuse1, TexCoords) * materialBaseColor * Color;
+    vec4 specular = vec4(texture(texture_specular1, TexCoords).rgb * materialSpecular.rgb, materialSpecular.a);
+    vec3 normal = normalize(Normal);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
+
+    vec3 result = vec3(0.0);
+    if (lightCounts.x > 0)
+    {
+        float shadow = CalcShadow(FragPos, normal, normalize(-dirLight.direction.xyz));
+        result += CalcDirLight(normal, viewDir, albedo.rgb, specular, shadow);
+    }
+    else
+        result += albedo.rgb;
+
+    result += CalcClusteredLights(normal, FragPos, viewDir, albedo.rgb, specular);
+
+    FragColor = vec4(result, albedo.a);
 }
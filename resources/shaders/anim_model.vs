@@ -1,41 +1,78 @@
 #version 330 core
 
+#include "frame_constants.glsl"
+
 layout(location = 0) in vec3 pos;
-layout(location = 1) in vec3 norm;
+layout(location = 1) in vec2 normOct;
 layout(location = 2) in vec2 tex;
-layout(location = 3) in vec3 tangent;
-layout(location = 4) in vec3 bitangent;
-layout(location = 5) in ivec4 boneIds; 
+layout(location = 3) in vec4 tangent;
+layout(location = 5) in ivec4 boneIds;
 layout(location = 6) in vec4 weights;
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
+layout(location = 7) in mat4 instanceModel;
+layout(location = 11) in vec4 instanceColor;
+layout(location = 12) in int instanceBoneOffset;
 
-const int MAX_BONES = 100;
+// Bone palettes of every animated entity live in one texture buffer;
+// instanceBoneOffset is the first matrix of the palette, or -1 when unskinned
 const int MAX_BONE_INFLUENCE = 4;
-uniform mat4 finalBonesMatrices[MAX_BONES];
+uniform samplerBuffer bonePalette;
 
 out vec2 TexCoords;
+out vec3 FragPos;
+out vec3 Normal;
+out vec4 Color;
+
+mat4 FetchBoneMatrix(int boneId)
+{
+    int texel = (instanceBoneOffset + boneId) * 4;
+    return mat4(texelFetch(bonePalette, texel),
+                texelFetch(bonePalette, texel + 1),
+                texelFetch(bonePalette, texel + 2),
+                texelFetch(bonePalette, texel + 3));
+}
+
+// Normals are stored octahedral-encoded in two snorm16 components
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
 
 void main()
 {
+    vec3 norm = OctDecode(normOct);
+
     vec4 totalPosition = vec4(0.0f);
-    for(int i = 0 ; i < MAX_BONE_INFLUENCE ; i++)
+    vec3 totalNormal = vec3(0.0f);
+    float totalWeight = 0.0f;
+
+    if (instanceBoneOffset >= 0)
     {
-        if(boneIds[i] == -1) 
-            continue;
-        if(boneIds[i] >=MAX_BONES) 
+        for(int i = 0 ; i < MAX_BONE_INFLUENCE ; i++)
         {
-            totalPosition = vec4(pos,1.0f);
-            break;
+            if(weights[i] <= 0.0f)
+                continue;
+            mat4 boneMatrix = FetchBoneMatrix(boneIds[i]);
+            totalPosition += boneMatrix * vec4(pos,1.0f) * weights[i];
+            totalNormal += mat3(boneMatrix) * norm * weights[i];
+            totalWeight += weights[i];
         }
-        vec4 localPosition = finalBonesMatrices[boneIds[i]] * vec4(pos,1.0f);
-        totalPosition += localPosition * weights[i];
-        vec3 localNormal = mat3(finalBonesMatrices[boneIds[i]]) * norm;
-   }
+    }
+
+    if (totalWeight <= 0.0f)
+    {
+        totalPosition = vec4(pos,1.0f);
+        totalNormal = norm;
+    }
 	
-    mat4 viewModel = view * model;
-    gl_Position =  projection * viewModel * totalPosition;
+    vec4 worldPosition = instanceModel * totalPosition;
+    FragPos = worldPosition.xyz;
+    // The inverse transpose keeps normals perpendicular under non-uniform scale
+    Normal = transpose(inverse(mat3(instanceModel))) * totalNormal;
+    gl_Position = viewProjection * worldPosition;
 	TexCoords = tex;
+    Color = instanceColor;
 }
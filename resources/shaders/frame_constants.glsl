@@ -0,0 +1,21 @@
+struct DirLight
+{
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+};
+
+layout(std140) uniform FrameConstants
+{
+    mat4 projection;
+    mat4 view;
+    mat4 viewProjection;
+    mat4 screenProjection;
+    vec4 viewPos;
+    ivec4 lightCounts;
+    ivec4 clusterDims;
+    vec4 clusterParams;
+
+    DirLight dirLight;
+};
@@ -0,0 +1,67 @@
+vec3 CalcDirLight(vec3 normal, vec3 viewDir, vec3 albedo, vec4 specular, float shadow)
+{
+    vec3 lightDir = normalize(-dirLight.direction.xyz);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), specular.a);
+
+    return dirLight.ambient.rgb * albedo
+         + (dirLight.diffuse.rgb * diff * albedo + dirLight.specular.rgb * spec * specular.rgb) * shadow;
+}
+
+// Point and spot lights come from the clustered light buffers, five texels per light
+uniform samplerBuffer clusterLights;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterIndices;
+
+int GetCluster(vec3 fragPos)
+{
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    int slice = clamp(int(floor(log(depth) * clusterParams.x + clusterParams.y)), 0, clusterDims.z - 1);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterParams.zw), ivec2(0), clusterDims.xy - 1);
+    return (slice * clusterDims.y + tile.y) * clusterDims.x + tile.x;
+}
+
+vec3 CalcClusterLight(int light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, vec4 specular)
+{
+    int texel = light * 5;
+    vec4 position = texelFetch(clusterLights, texel);
+    vec4 color = texelFetch(clusterLights, texel + 1);
+    vec4 attenuation = texelFetch(clusterLights, texel + 2);
+
+    vec3 toLight = position.xyz - fragPos;
+    float dist = length(toLight);
+    vec3 lightDir = toLight / max(dist, 0.0001);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), specular.a);
+
+    // Fade to zero at the radius, so cutting the light off at its cluster bounds is invisible
+    float window = clamp(1.0 - pow(dist / position.w, 4.0), 0.0, 1.0);
+    float falloff = window * window / (attenuation.x + attenuation.y * dist + attenuation.z * dist * dist);
+
+    float intensity = 1.0;
+    if (int(color.w) == 1)
+    {
+        vec3 direction = texelFetch(clusterLights, texel + 3).xyz;
+        vec4 cone = texelFetch(clusterLights, texel + 4);
+        float theta = dot(lightDir, normalize(-direction));
+        intensity = clamp((theta - cone.y) / (cone.x - cone.y), 0.0, 1.0);
+    }
+
+    return (color.rgb * 0.1 * albedo
+          + (color.rgb * diff * albedo + vec3(attenuation.w) * spec * specular.rgb) * intensity) * falloff;
+}
+
+vec3 CalcClusteredLights(vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, vec4 specular)
+{
+    uvec2 range = texelFetch(clusterGrid, GetCluster(fragPos)).xy;
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; i++)
+    {
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).x);
+        result += CalcClusterLight(light, normal, fragPos, viewDir, albedo, specular);
+    }
+    return result;
+}
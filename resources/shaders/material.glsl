@@ -0,0 +1,8 @@
+layout(std140) uniform MaterialParams
+{
+    vec4 materialBaseColor;
+    vec4 materialSpecular;
+};
+
+uniform sampler2D texture_diffuse1;
+uniform sampler2D texture_specular1;
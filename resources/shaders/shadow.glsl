@@ -0,0 +1,40 @@
+#define SHADOW_CASCADE_COUNT 4
+
+layout(std140) uniform ShadowData
+{
+    mat4 cascadeViewProjection[SHADOW_CASCADE_COUNT];
+    vec4 cascadeSplits;
+    vec4 cascadeTexelSizes;
+    vec4 shadowParams; // depth bias, enabled, unused, unused
+};
+
+uniform sampler2DArrayShadow shadowMap;
+
+// Returns 1 when lit, 0 when fully shadowed by the directional light
+float CalcShadow(vec3 fragPos, vec3 normal, vec3 lightDir)
+{
+    if (shadowParams.y <= 0.0)
+        return 1.0;
+
+    float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+    int cascade = 0;
+    while (cascade < SHADOW_CASCADE_COUNT && viewDepth > cascadeSplits[cascade])
+        cascade++;
+    if (cascade >= SHADOW_CASCADE_COUNT)
+        return 1.0;
+
+    // Offset along the normal by about a texel to keep acne away at grazing angles
+    float texelWorld = cascadeTexelSizes[cascade];
+    float slope = 1.0 - max(dot(normal, lightDir), 0.0);
+    vec4 lightPos = cascadeViewProjection[cascade] * vec4(fragPos + normal * texelWorld * (1.0 + slope), 1.0);
+    vec3 coords = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+    if (coords.z > 1.0)
+        return 1.0;
+
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int x = -1; x <= 1; x++)
+        for (int y = -1; y <= 1; y++)
+            lit += texture(shadowMap, vec4(coords.xy + vec2(x, y) * texelSize, float(cascade), coords.z - shadowParams.x));
+    return lit / 9.0;
+}
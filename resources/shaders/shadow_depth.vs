@@ -0,0 +1,44 @@
+#version 330 core
+
+layout(location = 0) in vec3 pos;
+layout(location = 5) in ivec4 boneIds;
+layout(location = 6) in vec4 weights;
+
+layout(location = 7) in mat4 instanceModel;
+layout(location = 12) in int instanceBoneOffset;
+
+const int MAX_BONE_INFLUENCE = 4;
+uniform samplerBuffer bonePalette;
+uniform mat4 lightViewProjection;
+
+mat4 FetchBoneMatrix(int boneId)
+{
+    int texel = (instanceBoneOffset + boneId) * 4;
+    return mat4(texelFetch(bonePalette, texel),
+                texelFetch(bonePalette, texel + 1),
+                texelFetch(bonePalette, texel + 2),
+                texelFetch(bonePalette, texel + 3));
+}
+
+void main()
+{
+    vec4 position = vec4(pos, 1.0);
+
+    // Meshes already skinned by the compute pass arrive with instanceBoneOffset = -1
+    if (instanceBoneOffset >= 0)
+    {
+        vec4 skinned = vec4(0.0);
+        float totalWeight = 0.0;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            if (weights[i] <= 0.0)
+                continue;
+            skinned += FetchBoneMatrix(boneIds[i]) * position * weights[i];
+            totalWeight += weights[i];
+        }
+        if (totalWeight > 0.0)
+            position = skinned;
+    }
+
+    gl_Position = lightViewProjection * instanceModel * position;
+}
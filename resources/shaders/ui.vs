@@ -1,13 +1,14 @@
 #version 330 core
 
+#include "frame_constants.glsl"
+
 layout (location = 0) in vec4 vertex; 
 
-uniform mat4 projection;
 uniform mat4 model;
 
 out vec2 TexCoords;
 
 void main() {
     TexCoords = vertex.zw;
-    gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
-}
\ No newline at end of file
+    gl_Position = screenProjection * model * vec4(vertex.xy, 0.0, 1.0);
+}
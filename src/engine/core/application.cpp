@@ -3,8 +3,15 @@
 #include <engine/utils/filesystem.h>
 #include <engine/utils/bullet_glm_helpers.h>
 #include <engine/graphic/model.h>
+#include <engine/graphic/geometry_arena.h>
+#include <engine/graphic/material.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+#include <engine/graphic/texture_cache.h>
+#include <engine/graphic/upload_queue.h>
 
 #include <iostream>
+#include <sstream>
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 {
@@ -38,17 +45,37 @@ Application::Application() {}
 
 Application::~Application()
 {
+    // Everything that owns GL objects goes before the context does; systems first, as they
+    // can still be reading meshes, and the shared pools last, once nothing allocates from them
+    renderSystem.Shutdown();
+    frameConstantsSystem.Shutdown();
+    buttonModel.reset();
+    imageModel.reset();
+
+    AssetManager::Get().Clear();
+    UploadQueue::Get().Clear();
+    MaterialLibrary::Get().Shutdown();
+    GeometryArena::Get().Shutdown();
     glfwTerminate();
 }
 
 bool Application::Init()
 {
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Game Engine", NULL, NULL);
+    // Prefer a 4.3+ context for multi-draw-indirect, but 3.3 is enough to run
+    const int versions[][2] = {{4, 6}, {4, 5}, {4, 3}, {3, 3}};
+    for (const auto &version : versions)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Game Engine", NULL, NULL);
+        if (window)
+            break;
+    }
+
     if (window == NULL)
     {
         std::cout << "Failed to create GLFW window" << std::endl;
@@ -69,36 +96,42 @@ bool Application::Init()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return false;
     }
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::Get().SetDepthTest(true);
 
     keyboardManager.Init(window);
     mouseManager.SetLastPosition(SCR_WIDTH / 2.0, SCR_HEIGHT / 2.0);
 
     physicsWorld = std::make_unique<PhysicsWorld>();
 
-    modelShader = std::make_unique<Shader>(
-        FileSystem::getPath("resources/shaders/anim_model.vs").c_str(),
-        FileSystem::getPath("resources/shaders/anim_model.fs").c_str());
+    // The framebuffer can be larger than the window on high-DPI displays
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    OnResize(framebufferWidth, framebufferHeight);
+
+    AssetManager &assets = AssetManager::Get();
+
+    modelShader = assets.LoadShader(
+        FileSystem::getPath("resources/shaders/anim_model.vs"),
+        FileSystem::getPath("resources/shaders/anim_model.fs"));
 
-    uiShader = std::make_unique<Shader>(
-        FileSystem::getPath("resources/shaders/ui.vs").c_str(),
-        FileSystem::getPath("resources/shaders/ui.fs").c_str());
+    uiShader = assets.LoadShader(
+        FileSystem::getPath("resources/shaders/ui.vs"),
+        FileSystem::getPath("resources/shaders/ui.fs"));
 
-    static Model playerModel(FileSystem::getPath("resources/objects/player/Dying.fbx"));
-    static Animation danceAnim(FileSystem::getPath("resources/objects/player/Dying.fbx"), &playerModel);
+    // Streams in over the first frames; ResolvePendingAssets() hooks it up once it is ready
+    playerModel = assets.LoadModelAsync(FileSystem::getPath("resources/objects/player/Dying.fbx"));
+    playerAnimation = assets.LoadAnimationAsync(FileSystem::getPath("resources/objects/player/Dying.fbx"), playerModel);
 
-    auto playerEntity = scene.createEntity();
+    playerEntity = scene.createEntity();
 
     auto &pTrans = scene.registry.emplace<TransformComponent>(playerEntity);
     pTrans.position = glm::vec3(0.0f, 5.0f, 0.0f);
     pTrans.scale = glm::vec3(0.01f);
 
     auto &pRender = scene.registry.emplace<MeshRendererComponent>(playerEntity);
-    pRender.model = &playerModel;
-    pRender.shader = modelShader.get();
+    pRender.shader = assets.Get(modelShader);
 
-    auto &pAnim = scene.registry.emplace<AnimationComponent>(playerEntity);
-    pAnim.animator = new Animator(&danceAnim);
+    scene.registry.emplace<AnimationComponent>(playerEntity);
 
     auto &pRb = scene.registry.emplace<RigidBodyComponent>(playerEntity);
     btCollisionShape *colShape = new btCapsuleShape(0.5f, 2.0f);
@@ -152,7 +185,7 @@ bool Application::Init()
 
     auto &uiRenderer = scene.registry.emplace<UIRendererComponent>(btnEntity);
     uiRenderer.model = buttonModel.get();
-    uiRenderer.shader = uiShader.get();
+    uiRenderer.shader = assets.Get(uiShader);
     uiRenderer.color = glm::vec4(1, 0, 0, 1);
 
     auto &uiInteract = scene.registry.emplace<UIInteractiveComponent>(btnEntity);
@@ -180,8 +213,13 @@ void Application::Run()
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        RenderStats::Get().Reset();
+
         glfwPollEvents();
 
+        UploadQueue::Get().Process();
+        ResolvePendingAssets();
+
         ProcessInput();
 
         cameraControlSystem.Update(scene, deltaTime, keyboardManager, mouseManager);
@@ -191,17 +229,67 @@ void Application::Run()
         physicsWorld->Update(deltaTime);
         physicsSystem.Update(scene);
         animationSystem.Update(scene, deltaTime);
+        boundsSystem.Update(scene);
 
         cameraSystem.Update(scene, (float)SCR_WIDTH, (float)SCR_HEIGHT);
+        frameConstantsSystem.Update(scene, (float)SCR_WIDTH, (float)SCR_HEIGHT);
 
+        // glClear honours the depth mask, which the transparent pass leaves off
+        GLStateCache::Get().SetDepthWrite(true);
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         renderSystem.Render(scene);
-        uiRenderSystem.Render(scene, (float)SCR_WIDTH, (float)SCR_HEIGHT);
+        uiRenderSystem.Render(scene);
+
+        statsTimer += deltaTime;
+        if (statsTimer >= 1.0f)
+        {
+            UpdateStatsTitle();
+            statsTimer = 0.0f;
+        }
 
         glfwSwapBuffers(window);
+
+        AssetManager::Get().Update();
+        TextureCache::Get().Update();
+    }
+}
+
+void Application::ResolvePendingAssets()
+{
+    AssetManager &assets = AssetManager::Get();
+
+    auto &renderer = scene.registry.get<MeshRendererComponent>(playerEntity);
+    if (!renderer.model)
+    {
+        if (Model *model = assets.Get(playerModel))
+            scene.registry.patch<MeshRendererComponent>(playerEntity, [model](MeshRendererComponent &component)
+                                                        { component.model = model; });
     }
+
+    auto &animation = scene.registry.get<AnimationComponent>(playerEntity);
+    if (!animation.animator)
+    {
+        if (Animation *clip = assets.Get(playerAnimation))
+            animation.animator = std::make_unique<Animator>(clip);
+    }
+}
+
+void Application::UpdateStatsTitle()
+{
+    const RenderStats &stats = RenderStats::Get();
+
+    std::ostringstream title;
+    title << "Game Engine | " << (deltaTime > 0.0f ? (int)(1.0f / deltaTime) : 0) << " fps"
+          << " | visible: " << stats.objectsVisible << "/" << stats.objectsTested << " (" << stats.objectsOccluded << " occluded)"
+          << " | draws: " << stats.drawCalls << " | material binds: " << stats.materialBinds
+          << " | gl calls: " << stats.glCallsIssued << " issued, " << stats.glCallsElided << " elided"
+          << " | uniform lookups: " << stats.uniformLookups << " | uploaded: " << stats.bytesUploaded / 1024 << " KiB"
+          << " | assets: " << AssetManager::Get().GetMemoryUsage() / (1024 * 1024) << " MiB"
+          << " | textures: " << TextureCache::Get().GetCount() << " (" << TextureCache::Get().GetBytes() / (1024 * 1024) << " MiB)";
+
+    glfwSetWindowTitle(window, title.str().c_str());
 }
 
 void Application::ProcessInput()
@@ -212,7 +300,8 @@ void Application::ProcessInput()
 
 void Application::OnResize(int width, int height)
 {
-    glViewport(0, 0, width, height);
+    GLStateCache::Get().SetViewport(0, 0, width, height);
+    renderSystem.SetViewportSize(width, height);
 }
 
 void Application::OnMouseMove(double xpos, double ypos)
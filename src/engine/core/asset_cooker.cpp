@@ -0,0 +1,213 @@
+#include <engine/core/asset_cooker.h>
+#include <engine/utils/filesystem.h>
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+std::mutex AssetCooker::s_HashMutex;
+std::unordered_map<std::string, std::uint64_t> AssetCooker::s_FileHashes;
+
+void CookedWriter::WriteBytes(const void *data, std::size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    m_Data.insert(m_Data.end(), bytes, bytes + size);
+}
+
+void CookedWriter::WriteString(const std::string &value)
+{
+    Write((std::uint32_t)value.size());
+    WriteBytes(value.data(), value.size());
+}
+
+void CookedWriter::WriteArray(const void *data, std::size_t size)
+{
+    m_Data.resize((m_Data.size() + ARRAY_ALIGNMENT - 1) & ~(ARRAY_ALIGNMENT - 1), 0);
+    WriteBytes(data, size);
+}
+
+// Whether path already holds a file of this size starting with this header. Cooked paths are
+// derived from the header's hashes, so such a file is the same cook from another job or process.
+static bool MatchesCooked(const std::string &path, const std::vector<unsigned char> &data)
+{
+    std::error_code error;
+    if (data.size() < sizeof(CookedHeader) || std::filesystem::file_size(path, error) != data.size() || error)
+        return false;
+
+    CookedHeader header;
+    std::ifstream file(path, std::ios::binary);
+    return file.read(reinterpret_cast<char *>(&header), sizeof(header)) &&
+           std::memcmp(&header, data.data(), sizeof(header)) == 0;
+}
+
+bool CookedWriter::Save(const std::string &path) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    // Workers may cook the same asset at once, so each write gets its own temporary file
+    static std::atomic<std::uint64_t> s_Counter{0};
+    std::string temporary = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+                            "." + std::to_string(s_Counter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char *>(m_Data.data()), (std::streamsize)m_Data.size()))
+        {
+            std::cout << "[AssetCooker] Failed to write " << temporary << std::endl;
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        // Losing the race to another writer is fine, and on Windows the winner's file may be
+        // mapped and so cannot be replaced
+        std::error_code removeError;
+        std::filesystem::remove(temporary, removeError);
+        if (MatchesCooked(path, m_Data))
+            return true;
+
+        std::cout << "[AssetCooker] Failed to replace " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CookedReader::Reserve(std::size_t size)
+{
+    if (m_Failed || size > m_Size - m_Position)
+    {
+        m_Failed = true;
+        return false;
+    }
+    return true;
+}
+
+void CookedReader::ReadBytes(void *data, std::size_t size)
+{
+    if (!Reserve(size))
+    {
+        std::memset(data, 0, size);
+        return;
+    }
+
+    std::memcpy(data, m_Data + m_Position, size);
+    m_Position += size;
+}
+
+std::string CookedReader::ReadString()
+{
+    std::uint32_t size = Read<std::uint32_t>();
+    if (!Reserve(size))
+        return std::string();
+
+    std::string value(reinterpret_cast<const char *>(m_Data + m_Position), size);
+    m_Position += size;
+    return value;
+}
+
+const unsigned char *CookedReader::ReadArray(std::size_t size)
+{
+    std::size_t aligned = (m_Position + CookedWriter::ARRAY_ALIGNMENT - 1) & ~(CookedWriter::ARRAY_ALIGNMENT - 1);
+    if (m_Failed || aligned > m_Size)
+    {
+        m_Failed = true;
+        return nullptr;
+    }
+
+    m_Position = aligned;
+    if (!Reserve(size))
+        return nullptr;
+
+    const unsigned char *data = m_Data + m_Position;
+    m_Position += size;
+    return data;
+}
+
+std::uint64_t AssetCooker::HashBytes(const void *data, std::size_t size, std::uint64_t seed)
+{
+    constexpr std::uint64_t c1 = 0x87c37b91114253d5ull;
+    constexpr std::uint64_t c2 = 0x4cf5ad432745937full;
+
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    std::uint64_t hash = seed ^ (size * c1);
+
+    // Eight bytes per step keeps hashing a large source file well ahead of the disk
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        word *= c1;
+        word = (word << 31) | (word >> 33);
+        hash ^= word * c2;
+        hash = ((hash << 27) | (hash >> 37)) * 5 + 0x52dce729;
+    }
+
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, bytes + i, size - i);
+    hash ^= tail * c2;
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+std::uint64_t AssetCooker::HashFile(const std::string &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_HashMutex);
+        auto it = s_FileHashes.find(path);
+        if (it != s_FileHashes.end())
+            return it->second;
+    }
+
+    MappedFile file;
+    if (!file.Open(path))
+        return 0;
+
+    std::uint64_t hash = HashBytes(file.GetData(), file.GetSize());
+
+    std::lock_guard<std::mutex> lock(s_HashMutex);
+    s_FileHashes[path] = hash;
+    return hash;
+}
+
+std::string AssetCooker::GetCookedPath(std::uint64_t sourceHash, std::uint64_t settingsHash, const char *extension)
+{
+    char name[40];
+    std::snprintf(name, sizeof(name), "%016llx%016llx", (unsigned long long)sourceHash, (unsigned long long)settingsHash);
+    return FileSystem::getPath("resources/cooked/" + std::string(name) + extension);
+}
+
+void AssetCooker::WriteHeader(CookedWriter &writer, std::uint32_t magic, std::uint64_t sourceHash, std::uint64_t settingsHash)
+{
+    writer.Write(CookedHeader{magic, VERSION, sourceHash, settingsHash});
+}
+
+bool AssetCooker::Open(const std::string &cookedPath, std::uint32_t magic, std::uint64_t sourceHash,
+                       std::uint64_t settingsHash, MappedFile &file, CookedReader &reader)
+{
+    if (!file.Open(cookedPath))
+        return false;
+
+    reader = CookedReader(file.GetData(), file.GetSize());
+    CookedHeader header = reader.Read<CookedHeader>();
+    if (!reader.IsValid() || header.magic != magic || header.version != VERSION || header.sourceHash != sourceHash ||
+        header.settingsHash != settingsHash)
+    {
+        file.Close();
+        return false;
+    }
+    return true;
+}
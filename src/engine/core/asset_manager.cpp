@@ -0,0 +1,261 @@
+#include <engine/core/asset_manager.h>
+#include <engine/core/asset_cooker.h>
+#include <engine/graphic/texture_cache.h>
+#include <engine/graphic/texture_cooker.h>
+#include <engine/graphic/upload_queue.h>
+
+#include <filesystem>
+#include <iostream>
+
+ModelLoader::result_type ModelLoader::operator()(const std::string &path, bool gamma, const MeshLodSettings &lodSettings) const
+{
+    return std::make_shared<Model>(path, gamma, lodSettings);
+}
+
+AnimationLoader::result_type AnimationLoader::operator()(const std::string &path, Model *model) const
+{
+    auto animation = std::make_shared<Animation>(path, model);
+    return animation->IsValid() ? animation : nullptr;
+}
+
+ShaderLoader::result_type ShaderLoader::operator()(const std::string &vertexPath, const std::string &fragmentPath) const
+{
+    return std::make_shared<Shader>(vertexPath.c_str(), fragmentPath.c_str());
+}
+
+TextureLoader::result_type TextureLoader::operator()(const std::string &path, bool gamma) const
+{
+    return std::make_shared<Texture2D>(path, gamma);
+}
+
+AssetManager &AssetManager::Get()
+{
+    static AssetManager manager;
+    return manager;
+}
+
+entt::id_type AssetManager::MakeKey(const std::string &path, std::uint64_t salt)
+{
+    // "a/./b.fbx" and "a/c/../b.fbx" name the same file
+    std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+    std::uint64_t hash = AssetCooker::HashBytes(normalized.data(), normalized.size(), salt);
+    return (entt::id_type)(hash ^ (hash >> 32));
+}
+
+entt::id_type AssetManager::MakeModelKey(const std::string &path, bool gamma, const MeshLodSettings &lodSettings)
+{
+    std::uint64_t salt = AssetCooker::HashBytes(lodSettings.ratios.data(), lodSettings.ratios.size() * sizeof(float));
+    salt = AssetCooker::HashBytes(&lodSettings.maxError, sizeof(float), salt) ^ (gamma ? 1 : 0);
+    return MakeKey(path, salt);
+}
+
+ModelHandle AssetManager::LoadModel(const std::string &path, bool gamma, const MeshLodSettings &lodSettings)
+{
+    return m_Models.Load(MakeModelKey(path, gamma, lodSettings), path, gamma, lodSettings);
+}
+
+AnimationHandle AssetManager::LoadAnimation(const std::string &path, ModelHandle model)
+{
+    Model *target = m_Models.Get(model);
+    if (!target)
+    {
+        std::cout << "[AssetManager] Animation " << path << " needs a loaded model" << std::endl;
+        return {};
+    }
+
+    std::uint64_t salt = ((std::uint64_t)model.generation << 32) | model.index;
+    return m_Animations.Load(MakeKey(path, salt), path, target);
+}
+
+ShaderHandle AssetManager::LoadShader(const std::string &vertexPath, const std::string &fragmentPath)
+{
+    return m_Shaders.Load(MakeKey(fragmentPath, MakeKey(vertexPath)), vertexPath, fragmentPath);
+}
+
+TextureHandle AssetManager::LoadTexture(const std::string &path, bool gamma)
+{
+    return m_Textures.Load(MakeKey(path, gamma ? 1 : 0), path, gamma);
+}
+
+// Import, mesh processing and image decoding run on a worker; the model then uploads one
+// texture or mesh per step from the upload queue, so a big model spreads over several frames
+ModelHandle AssetManager::LoadModelAsync(const std::string &path, bool gamma, const MeshLodSettings &lodSettings)
+{
+    bool existing = false;
+    ModelHandle handle = m_Models.Reserve(MakeModelKey(path, gamma, lodSettings), existing);
+    if (existing)
+        return handle;
+
+    JobSystem::Get().ScheduleBackground([this, handle, path, gamma, lodSettings]()
+                                        {
+        auto data = std::make_shared<ModelData>();
+        if (!Model::Import(path, lodSettings, *data))
+        {
+            UploadQueue::Get().Push([this, handle](std::size_t &)
+                                    {
+                m_Models.Complete(handle, nullptr);
+                return true; });
+            return;
+        }
+
+        auto model = std::make_shared<Model>(*data, gamma);
+        UploadQueue::Get().Push([this, handle, data, model](std::size_t &bytes)
+                                {
+            if (!model->UploadStep(*data, bytes))
+                return false;
+            m_Models.Complete(handle, model);
+            return true; }); }, &m_Loads);
+    return handle;
+}
+
+AnimationHandle AssetManager::LoadAnimationAsync(const std::string &path, ModelHandle model)
+{
+    if (!m_Models.Get(model) && !m_Models.IsLoading(model))
+    {
+        std::cout << "[AssetManager] Animation " << path << " needs a loaded model" << std::endl;
+        return {};
+    }
+
+    std::uint64_t salt = ((std::uint64_t)model.generation << 32) | model.index;
+    bool existing = false;
+    AnimationHandle handle = m_Animations.Reserve(MakeKey(path, salt), existing);
+    if (existing)
+        return handle;
+
+    // The model stays referenced until the clip is built from it
+    m_Models.Acquire(model);
+    m_WaitingAnimations.push_back({handle, path, model});
+    return handle;
+}
+
+void AssetManager::StartAnimation(const PendingAnimation &pending)
+{
+    Model *target = m_Models.Get(pending.model);
+    if (!target)
+    {
+        std::cout << "[AssetManager] Animation " << pending.path << ": model failed to load" << std::endl;
+        m_Animations.Complete(pending.handle, nullptr);
+        return;
+    }
+
+    JobSystem::Get().ScheduleBackground([this, pending, target]()
+                                        {
+        auto animation = std::make_shared<Animation>(pending.path, target);
+        if (!animation->IsValid())
+            animation = nullptr;
+        UploadQueue::Get().Push([this, pending, animation](std::size_t &)
+                                {
+            m_Animations.Complete(pending.handle, animation);
+            Release(pending.model);
+            return true; }); }, &m_Loads);
+}
+
+TextureHandle AssetManager::LoadTextureAsync(const std::string &path, bool gamma)
+{
+    bool existing = false;
+    TextureHandle handle = m_Textures.Reserve(MakeKey(path, gamma ? 1 : 0), existing);
+    if (existing)
+        return handle;
+
+    JobSystem::Get().ScheduleBackground([this, handle, path, gamma]()
+                                        {
+        auto image = std::make_shared<ImageData>();
+        if (!TextureCache::Get().Contains(TextureCache::MakeKey(path, TextureUsage::Color, gamma)))
+            *image = TextureCooker::Load(path, TextureUsage::Color);
+
+        UploadQueue::Get().Push([this, handle, path, image, gamma](std::size_t &bytes)
+                                {
+            auto texture = std::make_shared<Texture2D>(path, *image, gamma);
+            bytes += image->GetSize();
+            m_Textures.Complete(handle, texture);
+            return true; }); }, &m_Loads);
+    return handle;
+}
+
+void AssetManager::Update()
+{
+    for (std::size_t i = 0; i < m_WaitingAnimations.size();)
+    {
+        if (m_Models.IsLoading(m_WaitingAnimations[i].model))
+        {
+            i++;
+            continue;
+        }
+
+        PendingAnimation pending = std::move(m_WaitingAnimations[i]);
+        m_WaitingAnimations.erase(m_WaitingAnimations.begin() + i);
+        StartAnimation(pending);
+    }
+
+    Evict();
+}
+
+std::size_t AssetManager::GetMemoryUsage() const
+{
+    return m_Models.GetBytes() + m_Animations.GetBytes() + m_Shaders.GetBytes() + m_Textures.GetBytes() +
+           TextureCache::Get().GetBytes();
+}
+
+bool AssetManager::EvictOne()
+{
+    std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+    std::uint32_t model = m_Models.FindEvictable(oldest);
+    std::uint32_t animation = m_Animations.FindEvictable(oldest);
+    std::uint32_t shader = m_Shaders.FindEvictable(oldest);
+    std::uint32_t texture = m_Textures.FindEvictable(oldest);
+
+    // Each search only returns an index when it beat the ones before it, so the last hit is the oldest
+    if (texture != TextureHandle::INVALID_INDEX)
+        m_Textures.Destroy(texture);
+    else if (shader != ShaderHandle::INVALID_INDEX)
+        m_Shaders.Destroy(shader);
+    else if (animation != AnimationHandle::INVALID_INDEX)
+        m_Animations.Destroy(animation);
+    else if (model != ModelHandle::INVALID_INDEX)
+        m_Models.Destroy(model);
+    else
+        return false;
+    return true;
+}
+
+void AssetManager::Evict()
+{
+    std::size_t before = GetMemoryUsage();
+    if (before <= m_Budget)
+        return;
+
+    while (GetMemoryUsage() > m_Budget)
+    {
+        if (!EvictOne())
+            break;
+    }
+
+    // Runs every frame, so staying over budget with nothing evictable must stay quiet
+    std::size_t after = GetMemoryUsage();
+    if (after == before)
+        return;
+
+    std::cout << "[AssetManager] Evicted " << (before - after) << " bytes, " << after << " of " << m_Budget
+              << " in use" << std::endl;
+}
+
+void AssetManager::UnloadUnused()
+{
+    while (EvictOne())
+        ;
+}
+
+void AssetManager::Clear()
+{
+    JobSystem::Get().Wait(m_Loads);
+    for (const PendingAnimation &pending : m_WaitingAnimations)
+        m_Animations.Complete(pending.handle, nullptr);
+    m_WaitingAnimations.clear();
+
+    // Animations and textures never point into models, so the order only matters for the GL context
+    m_Animations.Clear();
+    m_Models.Clear();
+    m_Shaders.Clear();
+    m_Textures.Clear();
+    TextureCache::Get().Clear();
+}
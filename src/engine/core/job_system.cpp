@@ -0,0 +1,148 @@
+#include <engine/core/job_system.h>
+
+#include <algorithm>
+
+// Whether the job this thread is running is background work; worker threads idle in between
+static thread_local bool s_InBackgroundJob = false;
+
+JobSystem &JobSystem::Get()
+{
+    static JobSystem jobs;
+    return jobs;
+}
+
+JobSystem::JobSystem()
+{
+    // The main thread helps while it waits, so one core is left to it
+    unsigned int hardware = std::thread::hardware_concurrency();
+    std::size_t workers = hardware > 1 ? hardware - 1 : 1;
+
+    for (std::size_t i = 0; i < workers; i++)
+        m_Workers.emplace_back([this]
+                               { WorkerLoop(); });
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_Wake.notify_all();
+
+    for (std::thread &worker : m_Workers)
+        worker.join();
+}
+
+void JobSystem::Schedule(Job job, JobCounter *counter)
+{
+    if (counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    push({std::move(job), counter, s_InBackgroundJob});
+}
+
+void JobSystem::ScheduleBackground(Job job, JobCounter *counter)
+{
+    if (counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    push({std::move(job), counter, true});
+}
+
+void JobSystem::push(Entry entry)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        (entry.background ? m_BackgroundQueue : m_Queue).push_back(std::move(entry));
+    }
+    m_Wake.notify_one();
+}
+
+// Frame work first; background work only when the caller may take it. Called with m_Mutex held.
+bool JobSystem::pop(bool background, Entry &entry)
+{
+    std::deque<Entry> *queue = !m_Queue.empty() ? &m_Queue : nullptr;
+    if (!queue && background && !m_BackgroundQueue.empty())
+        queue = &m_BackgroundQueue;
+    if (!queue)
+        return false;
+
+    entry = std::move(queue->front());
+    queue->pop_front();
+    return true;
+}
+
+void JobSystem::Wait(JobCounter &counter)
+{
+    while (!counter.IsDone())
+    {
+        if (!RunOne())
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::ParallelFor(std::size_t count, std::size_t batchSize,
+                            const std::function<void(std::size_t, std::size_t)> &fn)
+{
+    if (count == 0)
+        return;
+
+    batchSize = std::max<std::size_t>(batchSize, 1);
+    if (count <= batchSize)
+    {
+        fn(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    for (std::size_t begin = 0; begin < count; begin += batchSize)
+    {
+        std::size_t end = std::min(begin + batchSize, count);
+        Schedule([&fn, begin, end]
+                 { fn(begin, end); },
+                 &counter);
+    }
+
+    Wait(counter);
+}
+
+bool JobSystem::RunOne()
+{
+    Entry entry;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!pop(s_InBackgroundJob, entry))
+            return false;
+    }
+
+    Run(entry);
+    return true;
+}
+
+void JobSystem::Run(Entry &entry)
+{
+    bool wasBackground = s_InBackgroundJob;
+    s_InBackgroundJob = entry.background;
+    entry.job();
+    s_InBackgroundJob = wasBackground;
+
+    if (entry.counter)
+        entry.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::WorkerLoop()
+{
+    for (;;)
+    {
+        Entry entry;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [this]
+                        { return m_Quit || !m_Queue.empty() || !m_BackgroundQueue.empty(); });
+
+            if (!pop(true, entry))
+                return;
+        }
+
+        Run(entry);
+    }
+}
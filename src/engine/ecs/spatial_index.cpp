@@ -0,0 +1,252 @@
+#include <engine/ecs/spatial_index.h>
+#include <engine/ecs/component.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+    btDbvtVolume ToVolume(const AABB &bounds)
+    {
+        return btDbvtVolume::FromMM(btVector3(bounds.min.x, bounds.min.y, bounds.min.z),
+                                    btVector3(bounds.max.x, bounds.max.y, bounds.max.z));
+    }
+
+    entt::entity ToEntity(const btDbvtNode *node)
+    {
+        return (entt::entity)(std::uintptr_t)node->data;
+    }
+
+    bool Overlaps(const AABB &a, const AABB &b)
+    {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+               a.min.y <= b.max.y && a.max.y >= b.min.y &&
+               a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+
+    bool RayIntersects(const AABB &box, const glm::vec3 &origin, const glm::vec3 &inverseDirection,
+                       float maxDistance, float &distance)
+    {
+        float tMin = 0.0f;
+        float tMax = maxDistance;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float t0 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+            float t1 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+            if (t0 > t1)
+                std::swap(t0, t1);
+            tMin = std::max(tMin, t0);
+            tMax = std::min(tMax, t1);
+            if (tMin > tMax)
+                return false;
+        }
+        distance = tMin;
+        return true;
+    }
+
+    // Collects leaves from btDbvt traversals; the exact test runs on the caller's side
+    struct LeafCollector : btDbvt::ICollide
+    {
+        std::vector<const btDbvtNode *> &leaves;
+
+        explicit LeafCollector(std::vector<const btDbvtNode *> &output) : leaves(output) {}
+
+        void Process(const btDbvtNode *leaf) { leaves.push_back(leaf); }
+    };
+}
+
+SpatialIndex::~SpatialIndex()
+{
+    Clear();
+}
+
+void SpatialIndex::Connect(entt::registry &registry)
+{
+    registry.on_construct<WorldBoundsComponent>().connect<&SpatialIndex::OnBoundsChanged>(*this);
+    registry.on_update<WorldBoundsComponent>().connect<&SpatialIndex::OnBoundsChanged>(*this);
+    registry.on_destroy<WorldBoundsComponent>().connect<&SpatialIndex::OnBoundsDestroyed>(*this);
+}
+
+void SpatialIndex::Disconnect(entt::registry &registry)
+{
+    registry.on_construct<WorldBoundsComponent>().disconnect<&SpatialIndex::OnBoundsChanged>(*this);
+    registry.on_update<WorldBoundsComponent>().disconnect<&SpatialIndex::OnBoundsChanged>(*this);
+    registry.on_destroy<WorldBoundsComponent>().disconnect<&SpatialIndex::OnBoundsDestroyed>(*this);
+}
+
+void SpatialIndex::Insert(entt::entity entity, const AABB &bounds, std::uint32_t category)
+{
+    if (m_Leaves.count(entity))
+    {
+        Update(entity, bounds, category);
+        return;
+    }
+
+    AABB fat = bounds;
+    fat.min -= glm::vec3(MARGIN);
+    fat.max += glm::vec3(MARGIN);
+
+    btDbvtNode *node = m_Tree.insert(ToVolume(fat), (void *)(std::uintptr_t)entity);
+    m_Leaves.emplace(entity, Leaf{node, bounds, category});
+    m_CategoryCounts[category]++;
+}
+
+void SpatialIndex::Update(entt::entity entity, const AABB &bounds, std::uint32_t category)
+{
+    auto it = m_Leaves.find(entity);
+    if (it == m_Leaves.end())
+    {
+        Insert(entity, bounds, category);
+        return;
+    }
+
+    Leaf &leaf = it->second;
+    if (leaf.category != category)
+    {
+        m_CategoryCounts[leaf.category]--;
+        m_CategoryCounts[category]++;
+    }
+    leaf.bounds = bounds;
+    leaf.category = category;
+
+    // Only reinserts when the tight box has left the enlarged leaf volume
+    btDbvtVolume volume = ToVolume(bounds);
+    m_Tree.update(leaf.node, volume, MARGIN);
+}
+
+void SpatialIndex::Remove(entt::entity entity)
+{
+    auto it = m_Leaves.find(entity);
+    if (it == m_Leaves.end())
+        return;
+
+    m_Tree.remove(it->second.node);
+    m_CategoryCounts[it->second.category]--;
+    m_Leaves.erase(it);
+}
+
+void SpatialIndex::Clear()
+{
+    m_Tree.clear();
+    m_Leaves.clear();
+    m_CategoryCounts.clear();
+}
+
+std::size_t SpatialIndex::Count(std::uint32_t categories) const
+{
+    // Entities mix only a few category combinations, so this map stays tiny
+    std::size_t count = 0;
+    for (const auto &[category, entries] : m_CategoryCounts)
+    {
+        if (category & categories)
+            count += entries;
+    }
+    return count;
+}
+
+void SpatialIndex::QueryFrustum(const Frustum &frustum, std::uint32_t categories, std::vector<entt::entity> &result) const
+{
+    btVector3 normals[6];
+    btScalar offsets[6];
+    for (int i = 0; i < 6; i++)
+    {
+        normals[i] = btVector3(frustum.planes[i].x, frustum.planes[i].y, frustum.planes[i].z);
+        offsets[i] = frustum.planes[i].w;
+    }
+
+    std::vector<const btDbvtNode *> leaves;
+    LeafCollector collector(leaves);
+    btDbvt::collideKDOP(m_Tree.m_root, normals, offsets, 6, collector);
+
+    for (const btDbvtNode *node : leaves)
+    {
+        const Leaf *leaf = Find(node);
+        if (leaf && (leaf->category & categories) && frustum.Intersects(leaf->bounds))
+            result.push_back(ToEntity(node));
+    }
+}
+
+void SpatialIndex::QuerySphere(const glm::vec3 &center, float radius, std::uint32_t categories,
+                               std::vector<entt::entity> &result) const
+{
+    AABB box;
+    box.min = center - glm::vec3(radius);
+    box.max = center + glm::vec3(radius);
+
+    std::vector<const btDbvtNode *> leaves;
+    LeafCollector collector(leaves);
+    m_Tree.collideTV(m_Tree.m_root, ToVolume(box), collector);
+
+    for (const btDbvtNode *node : leaves)
+    {
+        const Leaf *leaf = Find(node);
+        if (!leaf || !(leaf->category & categories))
+            continue;
+
+        glm::vec3 closest = glm::clamp(center, leaf->bounds.min, leaf->bounds.max);
+        glm::vec3 offset = closest - center;
+        if (glm::dot(offset, offset) <= radius * radius)
+            result.push_back(ToEntity(node));
+    }
+}
+
+void SpatialIndex::QueryBox(const AABB &box, std::uint32_t categories, std::vector<entt::entity> &result) const
+{
+    std::vector<const btDbvtNode *> leaves;
+    LeafCollector collector(leaves);
+    m_Tree.collideTV(m_Tree.m_root, ToVolume(box), collector);
+
+    for (const btDbvtNode *node : leaves)
+    {
+        const Leaf *leaf = Find(node);
+        if (leaf && (leaf->category & categories) && Overlaps(leaf->bounds, box))
+            result.push_back(ToEntity(node));
+    }
+}
+
+void SpatialIndex::QueryRay(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                            std::uint32_t categories, std::vector<SpatialRayHit> &result) const
+{
+    glm::vec3 dir = glm::normalize(direction);
+    glm::vec3 end = origin + dir * maxDistance;
+
+    std::vector<const btDbvtNode *> leaves;
+    LeafCollector collector(leaves);
+    btDbvt::rayTest(m_Tree.m_root, btVector3(origin.x, origin.y, origin.z), btVector3(end.x, end.y, end.z), collector);
+
+    glm::vec3 inverseDirection;
+    for (int axis = 0; axis < 3; axis++)
+        inverseDirection[axis] = dir[axis] != 0.0f ? 1.0f / dir[axis] : std::numeric_limits<float>::max();
+
+    std::size_t first = result.size();
+    for (const btDbvtNode *node : leaves)
+    {
+        const Leaf *leaf = Find(node);
+        float distance = 0.0f;
+        if (leaf && (leaf->category & categories) &&
+            RayIntersects(leaf->bounds, origin, inverseDirection, maxDistance, distance))
+            result.push_back({ToEntity(node), distance});
+    }
+
+    std::sort(result.begin() + first, result.end(),
+              [](const SpatialRayHit &a, const SpatialRayHit &b)
+              { return a.distance < b.distance; });
+}
+
+const SpatialIndex::Leaf *SpatialIndex::Find(const btDbvtNode *node) const
+{
+    auto it = m_Leaves.find(ToEntity(node));
+    return it != m_Leaves.end() ? &it->second : nullptr;
+}
+
+void SpatialIndex::OnBoundsChanged(entt::registry &registry, entt::entity entity)
+{
+    const auto &bounds = registry.get<WorldBoundsComponent>(entity);
+    Update(entity, bounds.aabb, bounds.category);
+}
+
+void SpatialIndex::OnBoundsDestroyed(entt::registry &, entt::entity entity)
+{
+    Remove(entity);
+}
@@ -1,4 +1,25 @@
 #include <engine/ecs/system.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+#include <engine/graphic/texture_cache.h>
+#include <engine/utils/filesystem.h>
+
+#include <algorithm>
+
+using namespace entt::literals;
+
+Scene::Scene()
+{
+    spatialIndex.Connect(registry);
+    BoundsSystem::Connect(registry);
+    CameraSystem::Connect(registry);
+    FrameConstantsSystem::Connect(registry);
+}
+
+Scene::~Scene()
+{
+    spatialIndex.Disconnect(registry);
+}
 
 entt::entity Scene::createEntity()
 {
@@ -26,9 +47,9 @@ void PhysicsSystem::Update(Scene &scene)
     for (auto entity : view)
     {
         auto &rb = view.get<RigidBodyComponent>(entity);
-        auto &transform = view.get<TransformComponent>(entity);
 
-        if (rb.body)
+        // Sleeping bodies have not moved, so their transforms are left untouched
+        if (rb.body && rb.body->isActive())
         {
             btTransform trans;
             if (rb.body->getMotionState())
@@ -36,8 +57,10 @@ void PhysicsSystem::Update(Scene &scene)
             else
                 trans = rb.body->getWorldTransform();
 
-            transform.position = BulletGLMHelpers::convert(trans.getOrigin());
-            transform.rotation = BulletGLMHelpers::convert(trans.getRotation());
+            scene.registry.patch<TransformComponent>(entity, [&](TransformComponent &transform)
+                                                     {
+                transform.position = BulletGLMHelpers::convert(trans.getOrigin());
+                transform.rotation = BulletGLMHelpers::convert(trans.getRotation()); });
         }
     }
 }
@@ -56,133 +79,924 @@ void AnimationSystem::Update(Scene &scene, float dt)
     }
 }
 
-void RenderSystem::UploadLightData(Scene &scene, Shader *shader)
+static void MarkBoundsDirty(entt::registry &registry, entt::entity entity)
+{
+    registry.emplace_or_replace<BoundsDirtyComponent>(entity);
+}
+
+static bool IsDynamic(const entt::registry &registry, entt::entity entity)
+{
+    return registry.any_of<RigidBodyComponent, AnimationComponent>(entity);
+}
+
+static void BumpStaticGeometry(entt::registry &registry, entt::entity entity)
+{
+    if (!IsDynamic(registry, entity))
+        registry.ctx().get<StaticGeometryVersion>().value++;
+}
+
+void BoundsSystem::Connect(entt::registry &registry)
+{
+    registry.ctx().emplace<StaticGeometryVersion>();
+    registry.on_destroy<MeshRendererComponent>().connect<&BumpStaticGeometry>();
+
+    registry.on_construct<TransformComponent>().connect<&MarkBoundsDirty>();
+    registry.on_update<TransformComponent>().connect<&MarkBoundsDirty>();
+    registry.on_construct<MeshRendererComponent>().connect<&MarkBoundsDirty>();
+    registry.on_update<MeshRendererComponent>().connect<&MarkBoundsDirty>();
+    registry.on_construct<PointLightComponent>().connect<&MarkBoundsDirty>();
+    registry.on_update<PointLightComponent>().connect<&MarkBoundsDirty>();
+    registry.on_construct<SpotLightComponent>().connect<&MarkBoundsDirty>();
+    registry.on_update<SpotLightComponent>().connect<&MarkBoundsDirty>();
+}
+
+void BoundsSystem::Update(Scene &scene)
+{
+    auto view = scene.registry.view<BoundsDirtyComponent, TransformComponent>();
+    for (auto entity : view)
+    {
+        const auto &transform = view.get<TransformComponent>(entity);
+        glm::mat4 world = transform.GetTransformMatrix();
+
+        WorldBoundsComponent bounds;
+        bounds.category = 0;
+
+        auto *renderer = scene.registry.try_get<MeshRendererComponent>(entity);
+        if (renderer)
+            BumpStaticGeometry(scene.registry, entity);
+
+        if (renderer && renderer->model)
+        {
+            bounds.aabb = renderer->model->GetBounds().Transform(world);
+            bounds.sphere = renderer->model->GetBoundingSphere().Transform(world);
+            bounds.category |= SPATIAL_RENDERABLE;
+        }
+
+        float lightRadius = 0.0f;
+        if (auto *point = scene.registry.try_get<PointLightComponent>(entity))
+            lightRadius = glm::max(lightRadius, point->radius);
+        if (auto *spot = scene.registry.try_get<SpotLightComponent>(entity))
+            lightRadius = glm::max(lightRadius, spot->radius);
+
+        if (lightRadius > 0.0f)
+        {
+            AABB lightBounds;
+            lightBounds.min = transform.position - glm::vec3(lightRadius);
+            lightBounds.max = transform.position + glm::vec3(lightRadius);
+            bounds.aabb.Merge(lightBounds);
+            bounds.sphere.center = bounds.aabb.GetCenter();
+            bounds.sphere.radius = glm::length(bounds.aabb.GetExtents());
+            bounds.category |= SPATIAL_LIGHT;
+        }
+
+        if (bounds.category && bounds.aabb.IsValid())
+            scene.registry.emplace_or_replace<WorldBoundsComponent>(entity, bounds);
+        else
+            scene.registry.remove<WorldBoundsComponent>(entity);
+    }
+
+    scene.registry.clear<BoundsDirtyComponent>();
+}
+
+const RenderSystem::ShaderUniforms &RenderSystem::GetShaderUniforms(const Shader *shader)
+{
+    auto it = m_ShaderUniforms.find(shader);
+    if (it != m_ShaderUniforms.end())
+        return it->second;
+
+    ShaderUniforms uniforms;
+    uniforms.model = shader->GetUniform("model"_hs);
+    uniforms.boneOffset = shader->GetUniform("boneOffset"_hs);
+
+    // Sampler units are program state, so they only need to be assigned once
+    shader->setInt(shader->GetUniform("bonePalette"_hs), BonePaletteBuffer::TEXTURE_UNIT);
+    shader->setInt(shader->GetUniform("shadowMap"_hs), CascadedShadowMap::TEXTURE_UNIT);
+    shader->setInt(shader->GetUniform("clusterLights"_hs), LightClusterGrid::LIGHTS_TEXTURE_UNIT);
+    shader->setInt(shader->GetUniform("clusterGrid"_hs), LightClusterGrid::GRID_TEXTURE_UNIT);
+    shader->setInt(shader->GetUniform("clusterIndices"_hs), LightClusterGrid::INDICES_TEXTURE_UNIT);
+
+    return m_ShaderUniforms.emplace(shader, uniforms).first->second;
+}
+
+void RenderSystem::UploadBonePalettes(Scene &scene)
 {
-    auto dirLightView = scene.registry.view<DirectionalLightComponent>();
-    for (auto entity : dirLightView)
+    if (!m_BonePalette)
+        m_BonePalette = std::make_unique<BonePaletteBuffer>();
+
+    m_BonePalette->BeginFrame();
+
+    auto view = scene.registry.view<AnimationComponent>();
+    for (auto entity : view)
     {
-        auto &light = dirLightView.get<DirectionalLightComponent>(entity);
-        shader->setVec3("dirLight.direction", light.direction);
-        shader->setVec3("dirLight.ambient", light.ambient * light.intensity);
-        shader->setVec3("dirLight.diffuse", light.diffuse * light.intensity);
-        shader->setVec3("dirLight.specular", light.specular * light.intensity);
-        break;
+        auto &anim = view.get<AnimationComponent>(entity);
+        anim.paletteOffset = anim.animator ? m_BonePalette->Allocate(anim.animator->GetFinalBoneMatrices()) : -1;
     }
 
-    int i = 0;
-    auto pointLightView = scene.registry.view<PointLightComponent, TransformComponent>();
-    for (auto entity : pointLightView)
+    m_BonePalette->Upload();
+    m_BonePalette->Bind();
+}
+
+int RenderSystem::GetBoneOffset(Scene &scene, entt::entity entity) const
+{
+    auto *anim = scene.registry.try_get<AnimationComponent>(entity);
+    if (!anim || anim->paletteOffset < 0)
+        return -1;
+    return m_BonePalette->GetFrameBase() + anim->paletteOffset;
+}
+
+void RenderSystem::CullRenderables(Scene &scene)
+{
+    m_Culler.Clear();
+    m_Candidates.clear();
+    m_VisibleIndices.clear();
+
+    auto isDrawable = [&](entt::entity entity)
     {
-        if (i >= 4)
-            break;
+        auto *renderer = scene.registry.try_get<MeshRendererComponent>(entity);
+        return renderer && renderer->model && renderer->shader && scene.registry.all_of<TransformComponent>(entity);
+    };
 
-        auto [light, trans] = pointLightView.get<PointLightComponent, TransformComponent>(entity);
-        std::string number = std::to_string(i);
+    entt::entity camEntity = scene.GetActiveCamera();
+    if (camEntity == entt::null)
+    {
+        auto view = scene.registry.view<TransformComponent, MeshRendererComponent>();
+        for (auto entity : view)
+        {
+            if (isDrawable(entity))
+                m_Candidates.push_back(entity);
+        }
 
-        shader->setVec3("pointLights[" + number + "].position", trans.position);
-        shader->setVec3("pointLights[" + number + "].ambient", light.color * 0.1f * light.intensity);
-        shader->setVec3("pointLights[" + number + "].diffuse", light.color * light.intensity);
-        shader->setVec3("pointLights[" + number + "].specular", glm::vec3(1.0f) * light.intensity);
-        shader->setFloat("pointLights[" + number + "].constant", light.constant);
-        shader->setFloat("pointLights[" + number + "].linear", light.linear);
-        shader->setFloat("pointLights[" + number + "].quadratic", light.quadratic);
-        i++;
+        for (std::uint32_t i = 0; i < m_Candidates.size(); i++)
+            m_VisibleIndices.push_back(i);
+        return;
     }
-    shader->setInt("nrPointLights", i);
 
-    i = 0;
-    auto spotLightView = scene.registry.view<SpotLightComponent, TransformComponent>();
-    for (auto entity : spotLightView)
+    const auto &camera = scene.registry.get<CameraComponent>(camEntity);
+    Frustum frustum = Frustum::FromMatrix(camera.projectionMatrix * camera.viewMatrix);
+
+    // The tree only returns entities near the frustum; the SIMD pass then tests their exact boxes
+    m_TreeResults.clear();
+    scene.spatialIndex.QueryFrustum(frustum, SPATIAL_RENDERABLE, m_TreeResults);
+
+    for (entt::entity entity : m_TreeResults)
     {
-        if (i >= 4)
-            break;
+        if (!isDrawable(entity) || scene.registry.all_of<AnimationComponent>(entity))
+            continue;
 
-        auto [light, trans] = spotLightView.get<SpotLightComponent, TransformComponent>(entity);
+        m_Culler.Add(scene.registry.get<WorldBoundsComponent>(entity).aabb);
+        m_Candidates.push_back(entity);
+    }
 
-        std::string number = std::to_string(i);
-        shader->setVec3("spotLights[" + number + "].position", trans.position);
-        shader->setVec3("spotLights[" + number + "].ambient", light.color * 0.1f * light.intensity);
-        shader->setVec3("spotLights[" + number + "].diffuse", light.color * light.intensity);
-        shader->setVec3("spotLights[" + number + "].specular", glm::vec3(1.0f) * light.intensity);
-        shader->setFloat("spotLights[" + number + "].constant", light.constant);
-        shader->setFloat("spotLights[" + number + "].linear", light.linear);
-        shader->setFloat("spotLights[" + number + "].quadratic", light.quadratic);
+    m_Culler.Cull(frustum, m_VisibleIndices);
 
-        i++;
+    // Skinned entities only have bind pose bounds, which animated limbs leave, so they are never culled
+    auto animated = scene.registry.view<AnimationComponent, MeshRendererComponent, WorldBoundsComponent>();
+    for (auto entity : animated)
+    {
+        if (!isDrawable(entity))
+            continue;
+
+        m_VisibleIndices.push_back((std::uint32_t)m_Candidates.size());
+        m_Candidates.push_back(entity);
     }
-    shader->setInt("nrSpotLights", i);
+
+    RenderStats &stats = RenderStats::Get();
+    stats.objectsTested += (unsigned int)scene.spatialIndex.Count(SPATIAL_RENDERABLE);
+    stats.objectsVisible += (unsigned int)m_VisibleIndices.size();
 }
 
-void RenderSystem::Render(Scene &scene)
+void RenderSystem::BeginOcclusion(Scene &scene)
 {
+    m_OcclusionPending = false;
+
     entt::entity camEntity = scene.GetActiveCamera();
-    CameraComponent *cam = nullptr;
-    TransformComponent *camTrans = nullptr;
+    if (!m_OcclusionCulling || camEntity == entt::null)
+        return;
 
-    if (camEntity != entt::null)
+    const auto &camera = scene.registry.get<CameraComponent>(camEntity);
+    glm::vec3 viewPos = scene.registry.get<TransformComponent>(camEntity).position;
+    glm::mat4 viewProjection = camera.projectionMatrix * camera.viewMatrix;
+    Frustum frustum = Frustum::FromMatrix(viewProjection);
+
+    m_OccluderDraws.clear();
+
+    auto view = scene.registry.view<OccluderComponent, TransformComponent>();
+    for (auto entity : view)
     {
-        cam = &scene.registry.get<CameraComponent>(camEntity);
-        camTrans = &scene.registry.get<TransformComponent>(camEntity);
+        if (scene.registry.all_of<AnimationComponent>(entity))
+            continue;
+
+        const Model *model = view.get<OccluderComponent>(entity).model;
+        if (!model)
+        {
+            auto *renderer = scene.registry.try_get<MeshRendererComponent>(entity);
+            model = renderer ? renderer->model : nullptr;
+        }
+        if (!model)
+            continue;
+
+        glm::mat4 world = view.get<TransformComponent>(entity).GetTransformMatrix();
+        AABB bounds = model->GetBounds().Transform(world);
+        if (!frustum.Intersects(bounds))
+            continue;
+
+        float distance = glm::distance(viewPos, bounds.GetCenter());
+        for (const Mesh &mesh : model->meshes)
+            m_OccluderDraws.push_back({&mesh, world, distance});
     }
 
-    scene.registry.sort<MeshRendererComponent>([](const auto &lhs, const auto &rhs)
-                                               { return lhs.shader < rhs.shader; });
+    if (m_OccluderDraws.empty())
+        return;
 
-    Shader *currentShader = nullptr;
-    auto view = scene.registry.view<TransformComponent, MeshRendererComponent>();
-    view.use<MeshRendererComponent>();
+    // Near occluders first fill the reference depth sooner, so more of the far ones are rejected early
+    std::sort(m_OccluderDraws.begin(), m_OccluderDraws.end(), [](const OccluderDraw &a, const OccluderDraw &b)
+              { return a.distance < b.distance; });
 
-    for (auto entity : view)
+    if (!m_Occlusion)
+        m_Occlusion = std::make_unique<OcclusionCuller>();
+
+    m_Occlusion->Begin(viewProjection);
+    for (const OccluderDraw &draw : m_OccluderDraws)
+        m_Occlusion->AddOccluder(draw.mesh->GetPositions(), draw.mesh->GetPositionStride(), draw.mesh->GetIndices(),
+                                 draw.mesh->GetIndexType() == GL_UNSIGNED_SHORT, draw.mesh->GetIndexCount(), draw.model);
+
+    // Rasterizes on the workers while this thread uploads palettes and runs the frustum cull
+    JobSystem::Get().Schedule([this]
+                              { m_Occlusion->Rasterize(); },
+                              &m_OcclusionJob);
+    m_OcclusionPending = true;
+}
+
+void RenderSystem::CullOccluded(Scene &scene)
+{
+    if (!m_OcclusionPending)
+        return;
+
+    JobSystem &jobs = JobSystem::Get();
+    jobs.Wait(m_OcclusionJob);
+    m_OcclusionPending = false;
+
+    // Boxes are gathered here so the workers never touch the registry; occluders and skinned entities are never tested
+    const std::uint8_t untested = 2;
+    m_OcclusionBoxes.resize(m_VisibleIndices.size());
+    m_OcclusionResults.resize(m_VisibleIndices.size());
+    for (std::size_t i = 0; i < m_VisibleIndices.size(); i++)
     {
-        auto [transform, renderer] = view.get<TransformComponent, MeshRendererComponent>(entity);
+        entt::entity entity = m_Candidates[m_VisibleIndices[i]];
+        bool skipped = scene.registry.any_of<OccluderComponent, AnimationComponent>(entity);
+        m_OcclusionResults[i] = skipped ? 1 : untested;
+        m_OcclusionBoxes[i] = scene.registry.get<WorldBoundsComponent>(entity).aabb;
+    }
 
-        if (!renderer.model || !renderer.shader)
-            continue;
+    jobs.ParallelFor(m_VisibleIndices.size(), 64, [this, untested](std::size_t begin, std::size_t end)
+                     {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            if (m_OcclusionResults[i] == untested)
+                m_OcclusionResults[i] = m_Occlusion->IsVisible(m_OcclusionBoxes[i]) ? 1 : 0;
+        } });
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < m_VisibleIndices.size(); i++)
+    {
+        if (m_OcclusionResults[i])
+            m_VisibleIndices[kept++] = m_VisibleIndices[i];
+    }
+
+    RenderStats &stats = RenderStats::Get();
+    stats.objectsOccluded += (unsigned int)(m_VisibleIndices.size() - kept);
+    stats.objectsVisible -= (unsigned int)(m_VisibleIndices.size() - kept);
+    m_VisibleIndices.resize(kept);
+}
+
+std::uint8_t RenderSystem::SelectLod(Scene &scene, entt::entity entity, const Model &model,
+                                     const TransformComponent &transform, const glm::vec3 &viewPos, float pixelsPerUnit)
+{
+    auto &state = scene.registry.get_or_emplace<LodComponent>(entity);
+
+    const BoundingSphere &bounds = scene.registry.get<WorldBoundsComponent>(entity).sphere;
+    float distance = glm::max(glm::length(bounds.center - viewPos) - bounds.radius, 1e-3f);
+    float scale = glm::max(transform.scale.x, glm::max(transform.scale.y, transform.scale.z));
+
+    // Projected size in pixels of a level's error at this distance
+    auto pixelError = [&](std::size_t lod)
+    { return model.GetLodError(lod) * scale * pixelsPerUnit / distance; };
+
+    // Coarsen only well under the threshold and refine only well over it, so a level holds inside the band
+    std::size_t lod = glm::min<std::size_t>(state.level, model.GetLodCount() - 1);
+    while (lod + 1 < model.GetLodCount() && pixelError(lod + 1) <= m_LodPixelError * (1.0f - LOD_HYSTERESIS))
+        lod++;
+    while (lod > 0 && pixelError(lod) > m_LodPixelError * (1.0f + LOD_HYSTERESIS))
+        lod--;
+
+    state.level = (std::uint8_t)lod;
+    return state.level;
+}
+
+void RenderSystem::BuildQueue(Scene &scene)
+{
+    m_Queue.Clear();
+    m_DrawItems.clear();
+
+    glm::vec3 viewPos(0.0f);
+    float farPlane = 1.0f;
+    float pixelsPerUnit = 0.0f;
+
+    entt::entity camEntity = scene.GetActiveCamera();
+    if (camEntity != entt::null)
+    {
+        const auto &camera = scene.registry.get<CameraComponent>(camEntity);
+        viewPos = scene.registry.get<TransformComponent>(camEntity).position;
+        farPlane = camera.farPlane;
+
+        // Pixels covered by one unit at distance one
+        pixelsPerUnit = 0.5f * (float)m_ViewportHeight / glm::tan(glm::radians(camera.fov) * 0.5f);
+    }
+
+    const MaterialLibrary &materials = MaterialLibrary::Get();
+    TextureCache &textures = TextureCache::Get();
+
+    for (std::uint32_t index : m_VisibleIndices)
+    {
+        entt::entity entity = m_Candidates[index];
+        const auto &transform = scene.registry.get<TransformComponent>(entity);
+        const auto &renderer = scene.registry.get<MeshRendererComponent>(entity);
+
+        InstanceData instance;
+        instance.model = transform.GetTransformMatrix();
+        instance.color = renderer.color;
+        instance.boneOffset = GetBoneOffset(scene, entity);
+
+        float depth = glm::length(transform.position - viewPos) / farPlane;
 
-        if (currentShader != renderer.shader)
+        std::size_t lod = 0;
+        if (pixelsPerUnit > 0.0f && renderer.model->GetLodCount() > 1)
+            lod = SelectLod(scene, entity, *renderer.model, transform, viewPos, pixelsPerUnit);
+
+        // Textures are taken to span the model once, so they need about a texel per pixel it covers
+        if (pixelsPerUnit > 0.0f && !renderer.model->GetTextureKeys().empty())
         {
-            currentShader = renderer.shader;
-            currentShader->use();
+            const BoundingSphere &bounds = scene.registry.get<WorldBoundsComponent>(entity).sphere;
+            float distance = glm::max(glm::length(bounds.center - viewPos) - bounds.radius, 1e-3f);
+            float pixels = 2.0f * bounds.radius * pixelsPerUnit / distance;
+            for (TextureKey texture : renderer.model->GetTextureKeys())
+                textures.Request(texture, pixels);
+        }
+
+        for (auto &mesh : renderer.model->meshes)
+        {
+            MaterialHandle material = renderer.material != INVALID_MATERIAL ? renderer.material : mesh.GetMaterial();
+            float alpha = renderer.color.a * materials.GetMaterial(material).params.baseColor.a;
+            RenderPass pass = alpha < 1.0f ? RenderPass::Transparent : RenderPass::Opaque;
 
-            if (cam && camTrans)
+            // Pre-skinned meshes are drawn as static geometry, so the vertex shader must not skin them again
+            const GeometryAllocation *geometry = &mesh.GetGeometry(lod);
+            InstanceData meshInstance = instance;
+            if (m_Skinning)
             {
-                currentShader->setMat4("projection", cam->projectionMatrix);
-                currentShader->setMat4("view", cam->viewMatrix);
-                currentShader->setVec3("viewPos", camTrans->position);
+                if (const GeometryAllocation *skinned = m_Skinning->Skin(entt::to_integral(entity), mesh, instance.boneOffset, lod))
+                {
+                    geometry = skinned;
+                    meshInstance.boneOffset = -1;
+                }
             }
 
-            UploadLightData(scene, currentShader);
+            std::uint64_t key = RenderQueue::MakeKey(pass, renderer.shader->GetSortId(), material, mesh.GetSortId(), depth);
+            m_Queue.Push(key, (std::uint32_t)m_DrawItems.size());
+            m_DrawItems.push_back({renderer.shader, &mesh, geometry, material, meshInstance});
         }
+    }
 
-        glm::mat4 modelMatrix = transform.GetTransformMatrix();
-        currentShader->setMat4("model", modelMatrix);
+    m_Queue.Sort();
+}
 
-        if (scene.registry.all_of<AnimationComponent>(entity))
+void RenderSystem::BuildBatches()
+{
+    m_Batches.clear();
+    m_Instances->BeginFrame();
+    if (m_Indirect)
+        m_Indirect->BeginFrame();
+
+    for (const RenderItem &item : m_Queue.GetItems())
+    {
+        const DrawItem &draw = m_DrawItems[item.payload];
+        RenderPass pass = (RenderPass)(item.key >> 62);
+        GLuint instance = m_Instances->Push(draw.instance);
+
+        if (!m_Batches.empty())
+        {
+            DrawBatch &last = m_Batches.back();
+            if (last.pass == pass && last.shader == draw.shader && last.geometry == draw.geometry &&
+                last.material == draw.material)
+            {
+                last.count++;
+                continue;
+            }
+        }
+
+        m_Batches.push_back({pass, draw.shader, draw.mesh, draw.geometry, draw.material, instance, 1});
+    }
+
+    m_Instances->Upload();
+
+    // One command per batch, so a batch index doubles as its command offset
+    if (m_Indirect)
+    {
+        for (const DrawBatch &batch : m_Batches)
+        {
+            const GeometryAllocation &geometry = *batch.geometry;
+            m_Indirect->Push({geometry.indexCount, (GLuint)batch.count, geometry.GetFirstIndex(),
+                              geometry.baseVertex, batch.firstInstance});
+        }
+        m_Indirect->Upload();
+    }
+}
+
+bool RenderSystem::CanMultiDraw(const DrawBatch &first, const DrawBatch &next) const
+{
+    const GeometryAllocation &a = *first.geometry;
+    const GeometryAllocation &b = *next.geometry;
+    return first.pass == next.pass && first.shader == next.shader && first.material == next.material &&
+           a.format == b.format && a.indexType == b.indexType;
+}
+
+void RenderSystem::DrawMultiIndirect(std::size_t firstBatch, std::size_t batchCount)
+{
+    const DrawBatch &batch = m_Batches[firstBatch];
+    const GeometryAllocation &geometry = *batch.geometry;
+
+    MaterialLibrary::Get().Bind(batch.material);
+    GeometryArena::Get().Bind(geometry.format);
+
+    // baseInstance in each command offsets the instance attributes, so they point at the start once
+    m_Instances->BindAttributes(0);
+    m_Indirect->Bind();
+
+    glMultiDrawElementsIndirect(GL_TRIANGLES, geometry.indexType,
+                                (void *)(firstBatch * sizeof(DrawElementsIndirectCommand)),
+                                (GLsizei)batchCount, 0);
+    RenderStats::Get().drawCalls++;
+}
+
+void RenderSystem::CollectShadowCasters(Scene &scene)
+{
+    for (int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+    {
+        m_StaticShadowDraws[cascade].clear();
+        m_DynamicShadowDraws[cascade].clear();
+    }
+    m_StaleCascades = 0;
+
+    entt::entity camEntity = scene.GetActiveCamera();
+    auto lights = scene.registry.view<DirectionalLightComponent>();
+    if (camEntity == entt::null || lights.begin() == lights.end())
+    {
+        m_ShadowMap->Disable();
+        return;
+    }
+
+    std::uint32_t version = scene.registry.ctx().get<StaticGeometryVersion>().value;
+    if (version != m_StaticVersion)
+    {
+        m_StaticVersion = version;
+        m_ShadowMap->InvalidateStatic();
+    }
+
+    const auto &camera = scene.registry.get<CameraComponent>(camEntity);
+    const auto &light = lights.get<DirectionalLightComponent>(*lights.begin());
+    m_StaleCascades = m_ShadowMap->Update(camera.viewMatrix, camera.fov, camera.aspectRatio, camera.nearPlane,
+                                          camera.farPlane, light.direction);
+
+    // Static casters are only gathered for cascades whose cache is being redrawn
+    for (int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+    {
+        bool refreshStatic = m_StaleCascades & (1u << cascade);
+
+        m_ShadowCandidates.clear();
+        Frustum frustum = Frustum::FromMatrix(m_ShadowMap->GetCascade(cascade).viewProjection);
+        scene.spatialIndex.QueryFrustum(frustum, SPATIAL_RENDERABLE, m_ShadowCandidates);
+
+        // Skinned entities only have bind pose bounds, so like in the view cull they always cast
+        std::erase_if(m_ShadowCandidates, [&](entt::entity entity)
+                      { return scene.registry.all_of<AnimationComponent>(entity); });
+        auto animated = scene.registry.view<AnimationComponent, MeshRendererComponent>();
+        m_ShadowCandidates.insert(m_ShadowCandidates.end(), animated.begin(), animated.end());
+
+        for (entt::entity entity : m_ShadowCandidates)
         {
-            auto &anim = scene.registry.get<AnimationComponent>(entity);
-            if (anim.animator)
+            auto *renderer = scene.registry.try_get<MeshRendererComponent>(entity);
+            auto *transform = scene.registry.try_get<TransformComponent>(entity);
+            if (!renderer || !renderer->model || !renderer->castShadow || !transform)
+                continue;
+
+            bool dynamic = IsDynamic(scene.registry, entity);
+            if (!dynamic && !refreshStatic)
+                continue;
+
+            InstanceData instance;
+            instance.model = transform->GetTransformMatrix();
+            instance.color = renderer->color;
+            instance.boneOffset = GetBoneOffset(scene, entity);
+
+            // Dynamic casters follow the level picked for the view; cached static ones keep full detail
+            std::size_t lod = 0;
+            if (dynamic)
             {
-                auto transforms = anim.animator->GetFinalBoneMatrices();
-                for (int j = 0; j < transforms.size(); ++j)
+                if (auto *state = scene.registry.try_get<LodComponent>(entity))
+                    lod = state->level;
+            }
+
+            auto &draws = dynamic ? m_DynamicShadowDraws[cascade] : m_StaticShadowDraws[cascade];
+            for (auto &mesh : renderer->model->meshes)
+            {
+                const GeometryAllocation *geometry = &mesh.GetGeometry(lod);
+                InstanceData meshInstance = instance;
+                if (m_Skinning)
                 {
-                    currentShader->setMat4("finalBonesMatrices[" + std::to_string(j) + "]", transforms[j]);
+                    if (const GeometryAllocation *skinned = m_Skinning->Skin(entt::to_integral(entity), mesh, instance.boneOffset, lod))
+                    {
+                        geometry = skinned;
+                        meshInstance.boneOffset = -1;
+                    }
                 }
+                draws.push_back({geometry, meshInstance, 0});
             }
         }
+    }
+
+    // Sorting by geometry makes every run of equal geometry one instanced draw
+    auto byGeometry = [](const ShadowDraw &a, const ShadowDraw &b)
+    {
+        if (a.geometry->format != b.geometry->format)
+            return a.geometry->format < b.geometry->format;
+        return std::less<const GeometryAllocation *>()(a.geometry, b.geometry);
+    };
+
+    m_ShadowInstances->BeginFrame();
+    for (int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+    {
+        for (auto *draws : {&m_StaticShadowDraws[cascade], &m_DynamicShadowDraws[cascade]})
+        {
+            std::sort(draws->begin(), draws->end(), byGeometry);
+            for (ShadowDraw &draw : *draws)
+                draw.index = m_ShadowInstances->Push(draw.instance);
+        }
+    }
+    m_ShadowInstances->Upload();
+}
+
+void RenderSystem::DrawShadowCasters(std::vector<ShadowDraw> &draws, const glm::mat4 &lightViewProjection)
+{
+    m_ShadowShader->setMat4(m_ShadowViewProjection, lightViewProjection);
+
+    for (std::size_t first = 0; first < draws.size();)
+    {
+        std::size_t end = first + 1;
+        while (end < draws.size() && draws[end].geometry == draws[first].geometry)
+            end++;
+
+        const GeometryAllocation &geometry = *draws[first].geometry;
+        GeometryArena::Get().Bind(geometry.format);
+        m_ShadowInstances->BindAttributes(draws[first].index);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)geometry.indexCount, geometry.indexType,
+                                          (void *)(std::uintptr_t)geometry.indexOffset, (GLsizei)(end - first),
+                                          geometry.baseVertex);
+        RenderStats::Get().drawCalls++;
+
+        first = end;
+    }
+}
+
+void RenderSystem::RenderShadows()
+{
+    if (!m_ShadowMap->IsEnabled())
+        return;
+
+    GLStateCache::Get().SetBlend(false);
+    m_ShadowShader->use();
+
+    for (int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+    {
+        const ShadowCascade &shadowCascade = m_ShadowMap->GetCascade(cascade);
+
+        if (m_StaleCascades & (1u << cascade))
+        {
+            m_ShadowMap->BeginStaticCascade(cascade);
+            DrawShadowCasters(m_StaticShadowDraws[cascade], shadowCascade.viewProjection);
+            m_ShadowMap->MarkStaticValid(cascade);
+        }
 
-        renderer.model->Draw(*currentShader);
+        m_ShadowMap->BeginDynamicCascade(cascade);
+        DrawShadowCasters(m_DynamicShadowDraws[cascade], shadowCascade.viewProjection);
     }
+
+    m_ShadowMap->End();
+    GLStateCache::Get().SetViewport(0, 0, m_ViewportWidth, m_ViewportHeight);
+}
+
+void RenderSystem::DrawBatches(RenderPass pass)
+{
+    Shader *currentShader = nullptr;
+    const ShaderUniforms *uniforms = nullptr;
+
+    for (std::size_t index = 0; index < m_Batches.size(); index++)
+    {
+        const DrawBatch &batch = m_Batches[index];
+        if (batch.pass != pass)
+            continue;
+
+        if (currentShader != batch.shader)
+        {
+            currentShader = batch.shader;
+            currentShader->use();
+            uniforms = &GetShaderUniforms(currentShader);
+        }
+
+        if (currentShader->IsInstanced() && m_Indirect)
+        {
+            std::size_t end = index + 1;
+            while (end < m_Batches.size() && CanMultiDraw(batch, m_Batches[end]))
+                end++;
+
+            DrawMultiIndirect(index, end - index);
+            index = end - 1;
+            continue;
+        }
+
+        if (currentShader->IsInstanced())
+        {
+            batch.mesh->DrawInstanced(*m_Instances, batch.firstInstance, batch.count, batch.material, batch.geometry);
+            continue;
+        }
+
+        for (GLsizei i = 0; i < batch.count; i++)
+        {
+            const InstanceData &instance = m_Instances->Get(batch.firstInstance + i);
+            currentShader->setMat4(uniforms->model, instance.model);
+            currentShader->setInt(uniforms->boneOffset, instance.boneOffset);
+            batch.mesh->Draw(batch.material, batch.geometry);
+        }
+    }
+}
+
+void RenderSystem::Render(Scene &scene)
+{
+    BeginOcclusion(scene);
+    UploadBonePalettes(scene);
+
+    if (!m_Instances)
+        m_Instances = std::make_unique<InstanceBuffer>();
+    if (!m_Indirect && IsMultiDrawIndirectSupported())
+        m_Indirect = std::make_unique<IndirectBuffer>();
+    if (!m_ComputeSkinning)
+        m_Skinning.reset();
+    else if (!m_Skinning && IsComputeSkinningSupported())
+        m_Skinning = std::make_unique<SkinningPass>();
+
+    if (!m_ShadowMap)
+    {
+        m_ShadowMap = std::make_unique<CascadedShadowMap>();
+        m_ShadowInstances = std::make_unique<InstanceBuffer>();
+        m_ShadowShader = std::make_unique<Shader>(FileSystem::getPath("resources/shaders/shadow_depth.vs").c_str(),
+                                                  FileSystem::getPath("resources/shaders/shadow_depth.fs").c_str());
+        m_ShadowViewProjection = m_ShadowShader->GetUniform("lightViewProjection"_hs);
+        m_ShadowShader->use();
+        m_ShadowShader->setInt(m_ShadowShader->GetUniform("bonePalette"_hs), BonePaletteBuffer::TEXTURE_UNIT);
+    }
+
+    if (m_Skinning)
+        m_Skinning->BeginFrame();
+
+    CullRenderables(scene);
+    CullOccluded(scene);
+    BuildQueue(scene);
+    CollectShadowCasters(scene);
+
+    if (m_Skinning)
+        m_Skinning->Flush();
+
+    BuildBatches();
+    RenderShadows();
+    m_ShadowMap->Bind();
+
+    // Each pass states what it needs; the cache drops whatever is already set
+    GLStateCache &cache = GLStateCache::Get();
+    cache.SetDepthTest(true);
+    cache.SetDepthWrite(true);
+    cache.SetBlend(false);
+    DrawBatches(RenderPass::Opaque);
+
+    cache.SetBlend(true);
+    cache.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    cache.SetDepthWrite(false);
+    DrawBatches(RenderPass::Transparent);
+
+    m_BonePalette->EndFrame();
+}
+
+void RenderSystem::Shutdown()
+{
+    // The rasterizer may still be reading meshes the asset clear is about to free
+    JobSystem::Get().Wait(m_OcclusionJob);
+    m_OcclusionPending = false;
+    m_Occlusion.reset();
+
+    for (std::size_t cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+    {
+        m_StaticShadowDraws[cascade].clear();
+        m_DynamicShadowDraws[cascade].clear();
+    }
+
+    m_ShaderUniforms.clear();
+    m_ShadowShader.reset();
+    m_ShadowInstances.reset();
+    m_ShadowMap.reset();
+    m_Skinning.reset();
+    m_Indirect.reset();
+    m_Instances.reset();
+    m_BonePalette.reset();
+}
+
+static void BumpLights(entt::registry &registry, entt::entity)
+{
+    registry.ctx().get<FrameDataVersion>().lights++;
+}
+
+static void BumpLightTransform(entt::registry &registry, entt::entity entity)
+{
+    if (registry.any_of<PointLightComponent, SpotLightComponent>(entity))
+        BumpLights(registry, entity);
+}
+
+void FrameConstantsSystem::Connect(entt::registry &registry)
+{
+    registry.ctx().emplace<FrameDataVersion>();
+
+    registry.on_update<TransformComponent>().connect<&BumpLightTransform>();
+    registry.on_construct<DirectionalLightComponent>().connect<&BumpLights>();
+    registry.on_update<DirectionalLightComponent>().connect<&BumpLights>();
+    registry.on_destroy<DirectionalLightComponent>().connect<&BumpLights>();
+    registry.on_construct<PointLightComponent>().connect<&BumpLights>();
+    registry.on_update<PointLightComponent>().connect<&BumpLights>();
+    registry.on_destroy<PointLightComponent>().connect<&BumpLights>();
+    registry.on_construct<SpotLightComponent>().connect<&BumpLights>();
+    registry.on_update<SpotLightComponent>().connect<&BumpLights>();
+    registry.on_destroy<SpotLightComponent>().connect<&BumpLights>();
+}
+
+void FrameConstantsSystem::Shutdown()
+{
+    m_Clusters.reset();
+    m_Buffer.reset();
+    m_Valid = false;
+}
+
+void FrameConstantsSystem::Update(Scene &scene, float screenWidth, float screenHeight)
+{
+    if (!m_Buffer)
+        m_Buffer = std::make_unique<UniformBuffer>(sizeof(FrameConstants), FRAME_CONSTANTS_BINDING);
+    if (!m_Clusters)
+        m_Clusters = std::make_unique<LightClusterGrid>();
+
+    FrameConstants &constants = m_Constants;
+    const FrameDataVersion &version = scene.registry.ctx().get<FrameDataVersion>();
+    entt::entity camEntity = scene.GetActiveCamera();
+
+    glm::vec2 screenSize(screenWidth, screenHeight);
+    bool resized = !m_Valid || screenSize != m_ScreenSize;
+    bool cameraChanged = resized || camEntity != m_Camera || version.camera != m_CameraVersion;
+    bool lightsChanged = !m_Valid || version.lights != m_LightVersion;
+
+    m_Valid = true;
+    m_ScreenSize = screenSize;
+    m_Camera = camEntity;
+    m_CameraVersion = version.camera;
+    m_LightVersion = version.lights;
+
+    if (resized)
+        constants.screenProjection = glm::ortho(0.0f, screenWidth, screenHeight, 0.0f, -1.0f, 1.0f);
+
+    if (cameraChanged && camEntity != entt::null)
+    {
+        auto &cam = scene.registry.get<CameraComponent>(camEntity);
+        auto &camTrans = scene.registry.get<TransformComponent>(camEntity);
+
+        constants.projection = cam.projectionMatrix;
+        constants.view = cam.viewMatrix;
+        constants.viewProjection = cam.projectionMatrix * cam.viewMatrix;
+        constants.viewPos = glm::vec4(camTrans.position, 1.0f);
+        m_Clusters->SetProjection(cam.projectionMatrix, cam.nearPlane, cam.farPlane, screenWidth, screenHeight);
+    }
+
+    // Cluster assignment is in view space, so it is redone when either the lights or the camera moved
+    if (cameraChanged || lightsChanged)
+    {
+        m_Lights.clear();
+        if (camEntity != entt::null)
+        {
+            // Only lights whose range reaches into the view are worth a slot
+            scene.spatialIndex.QueryFrustum(Frustum::FromMatrix(constants.viewProjection), SPATIAL_LIGHT, m_Lights);
+        }
+        else
+        {
+            auto lightView = scene.registry.view<WorldBoundsComponent>();
+            for (auto entity : lightView)
+            {
+                if (lightView.get<WorldBoundsComponent>(entity).category & SPATIAL_LIGHT)
+                    m_Lights.push_back(entity);
+            }
+        }
+
+        constants.lightCounts = glm::ivec4(0);
+
+        auto dirLightView = scene.registry.view<DirectionalLightComponent>();
+        for (auto entity : dirLightView)
+        {
+            auto &light = dirLightView.get<DirectionalLightComponent>(entity);
+            constants.dirLight.direction = glm::vec4(light.direction, 0.0f);
+            constants.dirLight.ambient = glm::vec4(light.ambient * light.color * light.intensity, 0.0f);
+            constants.dirLight.diffuse = glm::vec4(light.diffuse * light.color * light.intensity, 0.0f);
+            constants.dirLight.specular = glm::vec4(light.specular * light.color * light.intensity, 0.0f);
+            constants.lightCounts.x = 1;
+            break;
+        }
+
+        // Every point and spot light touching the view goes to the cluster grid; no fixed cap
+        m_Clusters->Clear();
+        for (auto entity : m_Lights)
+        {
+            const auto &trans = scene.registry.get<TransformComponent>(entity);
+
+            if (auto *point = scene.registry.try_get<PointLightComponent>(entity))
+            {
+                GPULight light{};
+                light.position = glm::vec4(trans.position, point->radius);
+                light.color = glm::vec4(point->color * point->intensity, (float)GPU_LIGHT_POINT);
+                light.attenuation = glm::vec4(point->constant, point->linear, point->quadratic, point->intensity);
+                m_Clusters->AddLight(light, constants.view);
+                constants.lightCounts.y++;
+            }
+
+            if (auto *spot = scene.registry.try_get<SpotLightComponent>(entity))
+            {
+                GPULight light{};
+                light.position = glm::vec4(trans.position, spot->radius);
+                light.color = glm::vec4(spot->color * spot->intensity, (float)GPU_LIGHT_SPOT);
+                light.attenuation = glm::vec4(spot->constant, spot->linear, spot->quadratic, spot->intensity);
+                light.direction = glm::vec4(trans.rotation * glm::vec3(0.0f, 0.0f, -1.0f), 0.0f);
+                light.cone = glm::vec4(spot->cutOff, spot->outerCutOff, 0.0f, 0.0f);
+                m_Clusters->AddLight(light, constants.view);
+                constants.lightCounts.z++;
+            }
+        }
+
+        // Buffers are patched span by span, so unchanged lights and clusters are not re-sent
+        m_Clusters->Build();
+
+        constants.lightCounts.w = (int)m_Clusters->GetLightCount();
+        constants.clusterDims = m_Clusters->GetGridSize();
+        constants.clusterParams = m_Clusters->GetParams();
+    }
+
+    m_Clusters->Bind();
+    m_Buffer->Patch(&constants);
+}
+
+static void MarkCameraDirty(entt::registry &registry, entt::entity entity)
+{
+    registry.emplace_or_replace<CameraDirtyComponent>(entity);
+}
+
+static void MarkCameraTransformDirty(entt::registry &registry, entt::entity entity)
+{
+    if (registry.all_of<CameraComponent>(entity))
+        MarkCameraDirty(registry, entity);
+}
+
+void CameraSystem::Connect(entt::registry &registry)
+{
+    registry.ctx().emplace<FrameDataVersion>();
+
+    registry.on_construct<CameraComponent>().connect<&MarkCameraDirty>();
+    registry.on_update<CameraComponent>().connect<&MarkCameraDirty>();
+    registry.on_update<TransformComponent>().connect<&MarkCameraTransformDirty>();
 }
 
 void CameraSystem::Update(Scene &scene, float screenWidth, float screenHeight)
 {
+    glm::vec2 screenSize(screenWidth, screenHeight);
+    bool resized = screenSize != m_ScreenSize;
+    m_ScreenSize = screenSize;
+
+    auto &version = scene.registry.ctx().get<FrameDataVersion>();
     auto view = scene.registry.view<CameraComponent, const TransformComponent>();
 
     for (auto entity : view)
     {
         auto [cam, transform] = view.get<CameraComponent, const TransformComponent>(entity);
 
-        if (!cam.isPrimary)
+        // A camera that neither moved nor changed keeps last frame's matrices
+        if (!cam.isPrimary || (!resized && !scene.registry.all_of<CameraDirtyComponent>(entity)))
             continue;
 
         cam.aspectRatio = screenWidth / screenHeight;
@@ -198,7 +1012,10 @@ void CameraSystem::Update(Scene &scene, float screenWidth, float screenHeight)
         cam.up = glm::normalize(glm::cross(cam.right, cam.front));
 
         cam.viewMatrix = glm::lookAt(transform.position, transform.position + cam.front, cam.up);
+        version.camera++;
     }
+
+    scene.registry.clear<CameraDirtyComponent>();
 }
 
 void CameraControlSystem::Update(Scene &scene, float dt, const KeyboardManager &keyboard, const MouseManager &mouse)
@@ -207,54 +1024,63 @@ void CameraControlSystem::Update(Scene &scene, float dt, const KeyboardManager &
     if (camEntity == entt::null)
         return;
 
-    auto &cam = scene.registry.get<CameraComponent>(camEntity);
-    auto &transform = scene.registry.get<TransformComponent>(camEntity);
+    const auto &cam = scene.registry.get<CameraComponent>(camEntity);
 
     float sensitivity = 0.1f;
-    cam.yaw += mouse.GetXOffset() * sensitivity;
-    cam.pitch += mouse.GetYOffset() * sensitivity;
+    float yaw = cam.yaw + mouse.GetXOffset() * sensitivity;
+    float pitch = cam.pitch + mouse.GetYOffset() * sensitivity;
 
-    if (cam.pitch > 89.0f)
-        cam.pitch = 89.0f;
-    if (cam.pitch < -89.0f)
-        cam.pitch = -89.0f;
+    if (pitch > 89.0f)
+        pitch = 89.0f;
+    if (pitch < -89.0f)
+        pitch = -89.0f;
 
+    float fov = cam.fov;
     float scroll = mouse.GetScrollY();
     if (scroll != 0.0f)
     {
-        cam.fov -= scroll;
-        if (cam.fov < 1.0f)
-            cam.fov = 1.0f;
-        if (cam.fov > 45.0f)
-            cam.fov = 45.0f;
+        fov -= scroll;
+        if (fov < 1.0f)
+            fov = 1.0f;
+        if (fov > 45.0f)
+            fov = 45.0f;
     }
 
+    // Patch only on real input so an idle camera is not rebuilt every frame
+    if (yaw != cam.yaw || pitch != cam.pitch || fov != cam.fov)
+        scene.registry.patch<CameraComponent>(camEntity, [&](CameraComponent &camera)
+                                              {
+            camera.yaw = yaw;
+            camera.pitch = pitch;
+            camera.fov = fov; });
+
     float velocity = 2.5f * dt;
+    glm::vec3 move(0.0f);
     if (keyboard.GetKey(GLFW_KEY_W))
-        transform.position += cam.front * velocity;
+        move += cam.front * velocity;
     if (keyboard.GetKey(GLFW_KEY_S))
-        transform.position -= cam.front * velocity;
+        move -= cam.front * velocity;
     if (keyboard.GetKey(GLFW_KEY_A))
-        transform.position -= cam.right * velocity;
+        move -= cam.right * velocity;
     if (keyboard.GetKey(GLFW_KEY_D))
-        transform.position += cam.right * velocity;
+        move += cam.right * velocity;
+
+    if (move != glm::vec3(0.0f))
+        scene.registry.patch<TransformComponent>(camEntity, [&](TransformComponent &transform)
+                                                 { transform.position += move; });
 }
 
-void UIRenderSystem::Render(Scene& scene, float screenWidth, float screenHeight)
+void UIRenderSystem::Render(Scene& scene)
 {
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLStateCache &cache = GLStateCache::Get();
+    cache.SetDepthTest(false);
+    cache.SetBlend(true);
+    cache.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    scene.registry.sort<UITransformComponent>([](const auto& lhs, const auto& rhs) {
-        return lhs.zIndex < rhs.zIndex;
-    });
-
-    glm::mat4 projection = glm::ortho(0.0f, screenWidth, screenHeight, 0.0f, -1.0f, 1.0f);
-    Shader* currentShader = nullptr;
+    m_Queue.Clear();
+    m_Entities.clear();
 
     auto view = scene.registry.view<UITransformComponent, UIRendererComponent>();
-    view.use<UITransformComponent>();
 
     for (auto entity : view)
     {
@@ -262,23 +1088,44 @@ void UIRenderSystem::Render(Scene& scene, float screenWidth, float screenHeight)
 
         if (!renderer.model || !renderer.shader) continue;
 
+        // zIndex is biased into the unsigned high word; LSD radix sort keeps insertion order for ties
+        std::uint64_t key = ((std::uint64_t)((std::uint32_t)transform.zIndex ^ 0x80000000u) << 32) | renderer.shader->GetSortId();
+        m_Queue.Push(key, (std::uint32_t)m_Entities.size());
+        m_Entities.push_back(entity);
+    }
+
+    m_Queue.Sort();
+
+    Shader* currentShader = nullptr;
+    const ShaderUniforms* uniforms = nullptr;
+
+    for (const RenderItem& item : m_Queue.GetItems())
+    {
+        auto [transform, renderer] = view.get<UITransformComponent, UIRendererComponent>(m_Entities[item.payload]);
+
         if (currentShader != renderer.shader) {
             currentShader = renderer.shader;
             currentShader->use();
-            currentShader->setMat4("projection", projection);
-             currentShader->setInt("image", 0);
+
+            auto it = m_ShaderUniforms.find(currentShader);
+            if (it == m_ShaderUniforms.end()) {
+                ShaderUniforms resolved;
+                resolved.model = currentShader->GetUniform("model"_hs);
+                resolved.image = currentShader->GetUniform("image"_hs);
+                it = m_ShaderUniforms.emplace(currentShader, resolved).first;
+            }
+            uniforms = &it->second;
+
+            currentShader->setInt(uniforms->image, 0);
         }
 
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(transform.position, 0.0f));
         model = glm::scale(model, glm::vec3(transform.size, 1.0f)); 
-        currentShader->setMat4("model", model);
+        currentShader->setMat4(uniforms->model, model);
 
         renderer.model->Draw(*currentShader, renderer.color);
     }
-
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_BLEND);
 }
 
 void UIInteractSystem::Update(Scene &scene, float dt, const MouseManager &mouse)
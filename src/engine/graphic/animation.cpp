@@ -5,26 +5,53 @@
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
 Animation::Animation() = default;
 
 Animation::Animation(const std::string &animationPath, Model *model)
 {
+    std::uint64_t hash = AssetCooker::HashFile(animationPath);
+    std::string cookedPath = GetCookedPath(hash);
+
+    MappedFile file;
+    CookedReader reader;
+    if (hash && AssetCooker::Open(cookedPath, COOKED_MAGIC, hash, 0, file, reader) && ReadCooked(reader, *model))
+        return;
+
     Assimp::Importer importer;
     const aiScene *scene = importer.ReadFile(animationPath, aiProcess_Triangulate);
-    assert(scene && scene->mRootNode);
-    auto animation = scene->mAnimations[0];
-    m_Duration = animation->mDuration;
-    m_TicksPerSecond = animation->mTicksPerSecond;
-    aiMatrix4x4 globalTransformation = scene->mRootNode->mTransformation;
-    globalTransformation = globalTransformation.Inverse();
-    ReadHierarchyData(m_RootNode, scene->mRootNode);
-    ReadMissingBones(animation, *model);
+    if (!scene || !scene->mRootNode)
+    {
+        std::cout << "[Animation] Failed to load " << animationPath << ": " << importer.GetErrorString() << std::endl;
+        return;
+    }
+
+    CookedWriter writer;
+    if (!Cook(scene, hash, writer))
+    {
+        std::cout << "[Animation] No animation in " << animationPath << std::endl;
+        return;
+    }
+    if (hash)
+        writer.Save(cookedPath);
+
+    CookedReader cooked(writer.GetData().data(), writer.GetData().size());
+    cooked.Read<CookedHeader>();
+    ReadCooked(cooked, *model);
 }
 
 Animation::~Animation()
 {
 }
 
+std::string Animation::GetCookedPath(std::uint64_t sourceHash)
+{
+    return AssetCooker::GetCookedPath(sourceHash, 0, ".anim");
+}
+
 Bone *Animation::FindBone(const std::string &name)
 {
     auto iter = std::find_if(m_Bones.begin(), m_Bones.end(),
@@ -38,42 +65,138 @@ Bone *Animation::FindBone(const std::string &name)
         return &(*iter);
 }
 
-void Animation::ReadMissingBones(const aiAnimation *animation, Model &model)
+bool Animation::Cook(const aiScene *scene, std::uint64_t sourceHash, CookedWriter &writer)
 {
-    int size = animation->mNumChannels;
+    if (!scene || !scene->mRootNode || !scene->HasAnimations())
+        return false;
+
+    const aiAnimation *animation = scene->mAnimations[0];
 
-    std::map<std::string, BoneInfo> &boneInfoMap = model.GetBoneInfoMap(); 
-    int &boneCount = model.GetBoneCount();      
+    AssetCooker::WriteHeader(writer, COOKED_MAGIC, sourceHash, 0);
+    writer.Write((float)animation->mDuration);
+    writer.Write((std::int32_t)animation->mTicksPerSecond);
+    CookHierarchyData(writer, scene->mRootNode);
 
-    for (int i = 0; i < size; i++)
+    writer.Write((std::uint32_t)animation->mNumChannels);
+    for (unsigned int i = 0; i < animation->mNumChannels; i++)
     {
-        auto channel = animation->mChannels[i];
-        std::string boneName = channel->mNodeName.data;
+        const aiNodeAnim *channel = animation->mChannels[i];
+        writer.WriteString(channel->mNodeName.C_Str());
+
+        std::vector<KeyPosition> positions(channel->mNumPositionKeys);
+        for (unsigned int k = 0; k < channel->mNumPositionKeys; k++)
+            positions[k] = {AssimpGLMHelpers::GetGLMVec(channel->mPositionKeys[k].mValue), (float)channel->mPositionKeys[k].mTime};
+
+        std::vector<KeyRotation> rotations(channel->mNumRotationKeys);
+        for (unsigned int k = 0; k < channel->mNumRotationKeys; k++)
+            rotations[k] = {AssimpGLMHelpers::GetGLMQuat(channel->mRotationKeys[k].mValue), (float)channel->mRotationKeys[k].mTime};
+
+        std::vector<KeyScale> scales(channel->mNumScalingKeys);
+        for (unsigned int k = 0; k < channel->mNumScalingKeys; k++)
+            scales[k] = {AssimpGLMHelpers::GetGLMVec(channel->mScalingKeys[k].mValue), (float)channel->mScalingKeys[k].mTime};
+
+        writer.Write((std::uint32_t)positions.size());
+        writer.Write((std::uint32_t)rotations.size());
+        writer.Write((std::uint32_t)scales.size());
+        writer.WriteArray(positions.data(), positions.size() * sizeof(KeyPosition));
+        writer.WriteArray(rotations.data(), rotations.size() * sizeof(KeyRotation));
+        writer.WriteArray(scales.data(), scales.size() * sizeof(KeyScale));
+    }
+    return true;
+}
 
-        if (boneInfoMap.find(boneName) == boneInfoMap.end())
+void Animation::CookHierarchyData(CookedWriter &writer, const aiNode *src)
+{
+    writer.WriteString(src->mName.C_Str());
+    writer.Write(AssimpGLMHelpers::ConvertMatrixToGLMFormat(src->mTransformation));
+    writer.Write((std::uint32_t)src->mNumChildren);
+
+    for (unsigned int i = 0; i < src->mNumChildren; i++)
+        CookHierarchyData(writer, src->mChildren[i]);
+}
+
+bool Animation::ReadCooked(CookedReader &reader, Model &model)
+{
+    struct Channel
+    {
+        std::string name;
+        std::vector<KeyPosition> positions;
+        std::vector<KeyRotation> rotations;
+        std::vector<KeyScale> scales;
+    };
+
+    // Key arrays are copied out of the mapping whole; nothing touches the model until all of it has been read
+    float duration = reader.Read<float>();
+    std::int32_t ticksPerSecond = reader.Read<std::int32_t>();
+    AssimpNodeData root;
+    ReadHierarchyData(root, reader);
+
+    std::vector<Channel> channels;
+    std::uint32_t channelCount = reader.Read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < channelCount && reader.IsValid(); i++)
+    {
+        Channel &channel = channels.emplace_back();
+        channel.name = reader.ReadString();
+        std::uint32_t positionCount = reader.Read<std::uint32_t>();
+        std::uint32_t rotationCount = reader.Read<std::uint32_t>();
+        std::uint32_t scaleCount = reader.Read<std::uint32_t>();
+
+        const unsigned char *positions = reader.ReadArray((std::size_t)positionCount * sizeof(KeyPosition));
+        const unsigned char *rotations = reader.ReadArray((std::size_t)rotationCount * sizeof(KeyRotation));
+        const unsigned char *scales = reader.ReadArray((std::size_t)scaleCount * sizeof(KeyScale));
+        if (!reader.IsValid())
+            return false;
+
+        channel.positions.resize(positionCount);
+        channel.rotations.resize(rotationCount);
+        channel.scales.resize(scaleCount);
+        std::memcpy(channel.positions.data(), positions, positionCount * sizeof(KeyPosition));
+        std::memcpy(channel.rotations.data(), rotations, rotationCount * sizeof(KeyRotation));
+        std::memcpy(channel.scales.data(), scales, scaleCount * sizeof(KeyScale));
+    }
+
+    if (!reader.IsValid())
+        return false;
+
+    m_Duration = duration;
+    m_TicksPerSecond = ticksPerSecond;
+    m_RootNode = std::move(root);
+
+    // Channels for nodes the mesh does not reference still need a bone id. Clips for the same
+    // model may be loading on several workers at once.
+    static std::mutex s_BoneMapMutex;
+    std::lock_guard<std::mutex> lock(s_BoneMapMutex);
+    std::map<std::string, BoneInfo> &boneInfoMap = model.GetBoneInfoMap();
+    int &boneCount = model.GetBoneCount();
+
+    m_Bones.clear();
+    m_Bones.reserve(channels.size());
+    for (Channel &channel : channels)
+    {
+        if (boneInfoMap.find(channel.name) == boneInfoMap.end())
         {
-            boneInfoMap[boneName].id = boneCount;
+            boneInfoMap[channel.name].id = boneCount;
             boneCount++;
         }
-        m_Bones.push_back(Bone(channel->mNodeName.data,
-                               boneInfoMap[channel->mNodeName.data].id, channel));
+        m_Bones.push_back(Bone(channel.name, boneInfoMap[channel.name].id, std::move(channel.positions),
+                               std::move(channel.rotations), std::move(channel.scales)));
     }
 
     m_BoneInfoMap = boneInfoMap;
+    return true;
 }
 
-void Animation::ReadHierarchyData(AssimpNodeData &dest, const aiNode *src)
+void Animation::ReadHierarchyData(AssimpNodeData &dest, CookedReader &reader)
 {
-    assert(src);
-
-    dest.name = src->mName.data;
-    dest.transformation = AssimpGLMHelpers::ConvertMatrixToGLMFormat(src->mTransformation);
-    dest.childrenCount = src->mNumChildren;
+    dest.name = reader.ReadString();
+    dest.transformation = reader.Read<glm::mat4>();
+    std::uint32_t childCount = reader.Read<std::uint32_t>();
 
-    for (int i = 0; i < src->mNumChildren; i++)
+    for (std::uint32_t i = 0; i < childCount && reader.IsValid(); i++)
     {
         AssimpNodeData newData;
-        ReadHierarchyData(newData, src->mChildren[i]);
-        dest.children.push_back(newData);
+        ReadHierarchyData(newData, reader);
+        dest.children.push_back(std::move(newData));
     }
+    dest.childrenCount = (int)dest.children.size();
 }
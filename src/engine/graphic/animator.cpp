@@ -1,5 +1,6 @@
 #include <engine/graphic/animator.h>
 
+#include <algorithm>
 #include <map>
 
 #include <assimp/Importer.hpp>
@@ -11,10 +12,7 @@ Animator::Animator(Animation *animation)
     m_CurrentTime = 0.0;
     m_CurrentAnimation = animation;
 
-    m_FinalBoneMatrices.reserve(100);
-
-    for (int i = 0; i < 100; i++)
-        m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
+    ResizeBoneMatrices();
 }
 
 void Animator::UpdateAnimation(float dt)
@@ -32,6 +30,8 @@ void Animator::PlayAnimation(Animation *pAnimation)
 {
     m_CurrentAnimation = pAnimation;
     m_CurrentTime = 0.0f;
+
+    ResizeBoneMatrices();
 }
 
 void Animator::CalculateBoneTransform(const AssimpNodeData *node, glm::mat4 parentTransform)
@@ -49,11 +49,12 @@ void Animator::CalculateBoneTransform(const AssimpNodeData *node, glm::mat4 pare
 
     glm::mat4 globalTransformation = parentTransform * nodeTransform;
 
-    auto boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
-    if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+    const auto &boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
+    auto boneInfo = boneInfoMap.find(nodeName);
+    if (boneInfo != boneInfoMap.end())
     {
-        int index = boneInfoMap[nodeName].id;
-        glm::mat4 offset = boneInfoMap[nodeName].offset;
+        int index = boneInfo->second.id;
+        const glm::mat4 &offset = boneInfo->second.offset;
         m_FinalBoneMatrices[index] = globalTransformation * offset;
     }
 
@@ -61,7 +62,19 @@ void Animator::CalculateBoneTransform(const AssimpNodeData *node, glm::mat4 pare
         CalculateBoneTransform(&node->children[i], globalTransformation);
 }
 
-std::vector<glm::mat4> Animator::GetFinalBoneMatrices()
+std::span<const glm::mat4> Animator::GetFinalBoneMatrices() const
 {
     return m_FinalBoneMatrices;
 }
+
+void Animator::ResizeBoneMatrices()
+{
+    int boneCount = 0;
+    if (m_CurrentAnimation)
+    {
+        for (const auto &[name, info] : m_CurrentAnimation->GetBoneIDMap())
+            boneCount = std::max(boneCount, info.id + 1);
+    }
+
+    m_FinalBoneMatrices.assign(boneCount, glm::mat4(1.0f));
+}
@@ -1,47 +1,22 @@
 #include <engine/graphic/bone.h>
 
-#include <list>
-
-#include <engine/utils/assimp_glm_helpers.h>
-
-Bone::Bone(const std::string &name, int ID, const aiNodeAnim *channel)
-    : m_Name(name),
-      m_ID(ID),
-      m_LocalTransform(1.0f)
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <utility>
+
+Bone::Bone(const std::string &name, int ID, std::vector<KeyPosition> positions, std::vector<KeyRotation> rotations,
+           std::vector<KeyScale> scales)
+    : m_Positions(std::move(positions)),
+      m_Rotations(std::move(rotations)),
+      m_Scales(std::move(scales)),
+      m_LocalTransform(1.0f),
+      m_Name(name),
+      m_ID(ID)
 {
-    m_NumPositions = channel->mNumPositionKeys;
-
-    for (int positionIndex = 0; positionIndex < m_NumPositions; ++positionIndex)
-    {
-        aiVector3D aiPosition = channel->mPositionKeys[positionIndex].mValue;
-        float timeStamp = channel->mPositionKeys[positionIndex].mTime;
-        KeyPosition data;
-        data.position = AssimpGLMHelpers::GetGLMVec(aiPosition);
-        data.timeStamp = timeStamp;
-        m_Positions.push_back(data);
-    }
-
-    m_NumRotations = channel->mNumRotationKeys;
-    for (int rotationIndex = 0; rotationIndex < m_NumRotations; ++rotationIndex)
-    {
-        aiQuaternion aiOrientation = channel->mRotationKeys[rotationIndex].mValue;
-        float timeStamp = channel->mRotationKeys[rotationIndex].mTime;
-        KeyRotation data;
-        data.orientation = AssimpGLMHelpers::GetGLMQuat(aiOrientation);
-        data.timeStamp = timeStamp;
-        m_Rotations.push_back(data);
-    }
-
-    m_NumScalings = channel->mNumScalingKeys;
-    for (int keyIndex = 0; keyIndex < m_NumScalings; ++keyIndex)
-    {
-        aiVector3D scale = channel->mScalingKeys[keyIndex].mValue;
-        float timeStamp = channel->mScalingKeys[keyIndex].mTime;
-        KeyScale data;
-        data.scale = AssimpGLMHelpers::GetGLMVec(scale);
-        data.timeStamp = timeStamp;
-        m_Scales.push_back(data);
-    }
+    m_NumPositions = (int)m_Positions.size();
+    m_NumRotations = (int)m_Rotations.size();
+    m_NumScalings = (int)m_Scales.size();
 }
 
 void Bone::Update(float animationTime)
@@ -55,34 +30,42 @@ glm::mat4 Bone::GetLocalTransform() { return m_LocalTransform; }
 std::string Bone::GetBoneName() const { return m_Name; }
 int Bone::GetBoneID() { return m_ID; }
 
+// Index of the key starting the segment that holds animationTime. Playback moves forward by
+// less than a key per frame, so the cursor's segment or the next one almost always matches;
+// seeks and loops fall back to a binary search. Times outside the keys clamp to the first or
+// last segment.
+template <typename Key>
+static int FindKeyIndex(const std::vector<Key> &keys, float animationTime, int &cursor)
+{
+    const int last = (int)keys.size() - 2;
+    auto covers = [&](int index)
+    { return keys[index].timeStamp <= animationTime && animationTime < keys[index + 1].timeStamp; };
+
+    if (covers(cursor))
+        return cursor;
+    if (cursor < last && covers(cursor + 1))
+        return ++cursor;
+
+    auto next = std::upper_bound(keys.begin() + 1, keys.end() - 1, animationTime,
+                                 [](float time, const Key &key)
+                                 { return time < key.timeStamp; });
+    cursor = (int)(next - keys.begin()) - 1;
+    return cursor;
+}
+
 int Bone::GetPositionIndex(float animationTime)
 {
-    for (int index = 0; index < m_NumPositions - 1; ++index)
-    {
-        if (animationTime < m_Positions[index + 1].timeStamp)
-            return index;
-    }
-    assert(0);
+    return FindKeyIndex(m_Positions, animationTime, m_PositionCursor);
 }
 
 int Bone::GetRotationIndex(float animationTime)
 {
-    for (int index = 0; index < m_NumRotations - 1; ++index)
-    {
-        if (animationTime < m_Rotations[index + 1].timeStamp)
-            return index;
-    }
-    assert(0);
+    return FindKeyIndex(m_Rotations, animationTime, m_RotationCursor);
 }
 
 int Bone::GetScaleIndex(float animationTime)
 {
-    for (int index = 0; index < m_NumScalings - 1; ++index)
-    {
-        if (animationTime < m_Scales[index + 1].timeStamp)
-            return index;
-    }
-    assert(0);
+    return FindKeyIndex(m_Scales, animationTime, m_ScaleCursor);
 }
 
 float Bone::GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
@@ -90,7 +73,8 @@ float Bone::GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float anima
     float scaleFactor = 0.0f;
     float midWayLength = animationTime - lastTimeStamp;
     float framesDiff = nextTimeStamp - lastTimeStamp;
-    scaleFactor = midWayLength / framesDiff;
+    if (framesDiff > 0.0f)
+        scaleFactor = glm::clamp(midWayLength / framesDiff, 0.0f, 1.0f);
     return scaleFactor;
 }
 
@@ -0,0 +1,125 @@
+#include <engine/graphic/bone_palette_buffer.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+BonePaletteBuffer::BonePaletteBuffer(std::size_t initialCapacity)
+    : m_Capacity(0)
+{
+    // The limit is in RGBA32F texels and every frame in flight gets its own region
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    m_MaxCapacity = (std::size_t)maxTexels / 4 / FRAMES_IN_FLIGHT;
+
+    glGenBuffers(1, &m_Buffer);
+    glGenTextures(1, &m_Texture);
+    Reallocate(std::min(initialCapacity, m_MaxCapacity));
+}
+
+BonePaletteBuffer::~BonePaletteBuffer()
+{
+    for (GLsync fence : m_Fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+    }
+    GLStateCache::Get().ForgetTexture(m_Texture);
+    GLStateCache::Get().ForgetBuffer(m_Buffer);
+    glDeleteTextures(1, &m_Texture);
+    glDeleteBuffers(1, &m_Buffer);
+}
+
+void BonePaletteBuffer::BeginFrame()
+{
+    m_Frame = (m_Frame + 1) % FRAMES_IN_FLIGHT;
+    m_Staging.clear();
+}
+
+int BonePaletteBuffer::Allocate(std::span<const glm::mat4> matrices)
+{
+    if (m_Staging.size() + matrices.size() > m_MaxCapacity)
+    {
+        if (!m_LimitReported)
+            std::cout << "[BonePaletteBuffer] Palette would exceed GL_MAX_TEXTURE_BUFFER_SIZE, drawing bind pose" << std::endl;
+        m_LimitReported = true;
+        return -1;
+    }
+
+    int offset = (int)m_Staging.size();
+    m_Staging.insert(m_Staging.end(), matrices.begin(), matrices.end());
+    return offset;
+}
+
+void BonePaletteBuffer::Upload()
+{
+    if (m_Staging.size() > m_Capacity)
+    {
+        std::size_t capacity = m_Capacity;
+        while (capacity < m_Staging.size())
+            capacity *= 2;
+        Reallocate(std::min(capacity, m_MaxCapacity));
+    }
+
+    m_FrameBase = m_Frame * (int)m_Capacity;
+    if (m_Staging.empty())
+        return;
+
+    // The region written this frame was last read FRAMES_IN_FLIGHT frames ago
+    GLsync &fence = m_Fences[m_Frame];
+    if (fence)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    GLsizeiptr size = m_Staging.size() * sizeof(glm::mat4);
+    GLintptr offset = m_FrameBase * (GLintptr)sizeof(glm::mat4);
+
+    GLStateCache::Get().BindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+    void *dst = glMapBufferRange(GL_TEXTURE_BUFFER, offset, size,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst)
+    {
+        std::memcpy(dst, m_Staging.data(), size);
+        glUnmapBuffer(GL_TEXTURE_BUFFER);
+        RenderStats::Get().bytesUploaded += (unsigned int)size;
+    }
+}
+
+void BonePaletteBuffer::EndFrame()
+{
+    if (m_Staging.empty())
+        return;
+
+    m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void BonePaletteBuffer::Bind() const
+{
+    GLStateCache::Get().BindTexture(TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_Texture);
+}
+
+void BonePaletteBuffer::Reallocate(std::size_t capacity)
+{
+    for (GLsync &fence : m_Fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    m_Capacity = capacity;
+
+    GLStateCache &cache = GLStateCache::Get();
+    cache.BindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+    glBufferData(GL_TEXTURE_BUFFER, m_Capacity * FRAMES_IN_FLIGHT * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+
+    cache.BindTexture(TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_Texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_Buffer);
+}
@@ -0,0 +1,51 @@
+#include <engine/graphic/bounds.h>
+
+#include <algorithm>
+#include <cmath>
+
+void AABB::Expand(const glm::vec3 &point)
+{
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+void AABB::Merge(const AABB &other)
+{
+    if (!other.IsValid())
+        return;
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+}
+
+AABB AABB::Transform(const glm::mat4 &matrix) const
+{
+    if (!IsValid())
+        return *this;
+
+    // Transform the center and fold the extents through |M| (Arvo's method)
+    glm::vec3 center = glm::vec3(matrix * glm::vec4(GetCenter(), 1.0f));
+    glm::vec3 extents = GetExtents();
+
+    glm::vec3 worldExtents(0.0f);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        worldExtents += glm::abs(glm::vec3(matrix[axis])) * extents[axis];
+    }
+
+    AABB result;
+    result.min = center - worldExtents;
+    result.max = center + worldExtents;
+    return result;
+}
+
+BoundingSphere BoundingSphere::Transform(const glm::mat4 &matrix) const
+{
+    float scaleX = glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0]));
+    float scaleY = glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1]));
+    float scaleZ = glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]));
+
+    BoundingSphere result;
+    result.center = glm::vec3(matrix * glm::vec4(center, 1.0f));
+    result.radius = radius * std::sqrt(std::max(scaleX, std::max(scaleY, scaleZ)));
+    return result;
+}
@@ -1,4 +1,6 @@
 #include <engine/graphic/compute_shader.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/shader.h>
 
 #include <fstream>
 #include <sstream>
@@ -23,6 +25,7 @@ ComputeShader::ComputeShader(const char *computePath)
     {
         std::cout << "[ComputeShader] ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
     }
+    computeCode = Shader::ResolveIncludes(computeCode, computePath);
     const char *cShaderCode = computeCode.c_str();
 
     unsigned int compute;
@@ -37,72 +40,134 @@ ComputeShader::ComputeShader(const char *computePath)
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
 
+    m_Uniforms.Reflect(ID);
+
     glDeleteShader(compute);
 }
 
 void ComputeShader::use()
 {
-    glUseProgram(ID);
+    GLStateCache::Get().UseProgram(ID);
+}
+
+UniformHandle ComputeShader::GetUniform(entt::id_type id) const
+{
+    return m_Uniforms.Find(id);
+}
+
+UniformHandle ComputeShader::GetUniform(const std::string &name) const
+{
+    return m_Uniforms.Find(name);
 }
 
 void ComputeShader::setBool(const std::string &name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(m_Uniforms.Find(name).location, (int)value);
 }
 
 void ComputeShader::setInt(const std::string &name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(m_Uniforms.Find(name).location, value);
 }
 
 void ComputeShader::setFloat(const std::string &name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(m_Uniforms.Find(name).location, value);
 }
 
 void ComputeShader::setVec2(const std::string &name, const glm::vec2 &value) const
 {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform2fv(m_Uniforms.Find(name).location, 1, &value[0]);
 }
 
 void ComputeShader::setVec2(const std::string &name, float x, float y) const
 {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    glUniform2f(m_Uniforms.Find(name).location, x, y);
 }
 
 void ComputeShader::setVec3(const std::string &name, const glm::vec3 &value) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform3fv(m_Uniforms.Find(name).location, 1, &value[0]);
 }
 
 void ComputeShader::setVec3(const std::string &name, float x, float y, float z) const
 {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    glUniform3f(m_Uniforms.Find(name).location, x, y, z);
 }
 
 void ComputeShader::setVec4(const std::string &name, const glm::vec4 &value) const
 {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform4fv(m_Uniforms.Find(name).location, 1, &value[0]);
 }
 
 void ComputeShader::setVec4(const std::string &name, float x, float y, float z, float w)
 {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    glUniform4f(m_Uniforms.Find(name).location, x, y, z, w);
 }
 
 void ComputeShader::setMat2(const std::string &name, const glm::mat2 &mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix2fv(m_Uniforms.Find(name).location, 1, GL_FALSE, &mat[0][0]);
 }
 
 void ComputeShader::setMat3(const std::string &name, const glm::mat3 &mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(m_Uniforms.Find(name).location, 1, GL_FALSE, &mat[0][0]);
 }
 
 void ComputeShader::setMat4(const std::string &name, const glm::mat4 &mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(m_Uniforms.Find(name).location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void ComputeShader::setBool(UniformHandle handle, bool value) const
+{
+    glUniform1i(handle.location, (int)value);
+}
+
+void ComputeShader::setInt(UniformHandle handle, int value) const
+{
+    glUniform1i(handle.location, value);
+}
+
+void ComputeShader::setFloat(UniformHandle handle, float value) const
+{
+    glUniform1f(handle.location, value);
+}
+
+void ComputeShader::setVec2(UniformHandle handle, const glm::vec2 &value) const
+{
+    glUniform2fv(handle.location, 1, &value[0]);
+}
+
+void ComputeShader::setVec3(UniformHandle handle, const glm::vec3 &value) const
+{
+    glUniform3fv(handle.location, 1, &value[0]);
+}
+
+void ComputeShader::setVec4(UniformHandle handle, const glm::vec4 &value) const
+{
+    glUniform4fv(handle.location, 1, &value[0]);
+}
+
+void ComputeShader::setMat2(UniformHandle handle, const glm::mat2 &mat) const
+{
+    glUniformMatrix2fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void ComputeShader::setMat3(UniformHandle handle, const glm::mat3 &mat) const
+{
+    glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void ComputeShader::setMat4(UniformHandle handle, const glm::mat4 &mat) const
+{
+    glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void ComputeShader::setMat4Array(UniformHandle handle, const glm::mat4 *mats, int count) const
+{
+    glUniformMatrix4fv(handle.location, count, GL_FALSE, &mats[0][0][0]);
 }
 
 void ComputeShader::checkCompileErrors(GLuint shader, std::string type)
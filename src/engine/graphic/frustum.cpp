@@ -0,0 +1,154 @@
+#include <engine/graphic/frustum.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+Frustum Frustum::FromMatrix(const glm::mat4 &viewProjection)
+{
+    // glm is column major: row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&](int i)
+    { return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]); };
+
+    glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+    Frustum frustum;
+    frustum.planes[0] = r3 + r0;
+    frustum.planes[1] = r3 - r0;
+    frustum.planes[2] = r3 + r1;
+    frustum.planes[3] = r3 - r1;
+    frustum.planes[4] = r3 + r2;
+    frustum.planes[5] = r3 - r2;
+
+    for (glm::vec4 &plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+
+    return frustum;
+}
+
+bool Frustum::Intersects(const AABB &box) const
+{
+    glm::vec3 center = box.GetCenter();
+    glm::vec3 extents = box.GetExtents();
+
+    for (const glm::vec4 &plane : planes)
+    {
+        glm::vec3 normal(plane);
+        float distance = glm::dot(normal, center) + plane.w;
+        float radius = glm::dot(glm::abs(normal), extents);
+        if (distance + radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::Intersects(const BoundingSphere &sphere) const
+{
+    for (const glm::vec4 &plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+            return false;
+    }
+    return true;
+}
+
+void FrustumCuller::Clear()
+{
+    m_CenterX.clear();
+    m_CenterY.clear();
+    m_CenterZ.clear();
+    m_ExtentX.clear();
+    m_ExtentY.clear();
+    m_ExtentZ.clear();
+}
+
+std::uint32_t FrustumCuller::Add(const AABB &box)
+{
+    glm::vec3 center = box.GetCenter();
+    glm::vec3 extents = box.GetExtents();
+
+    m_CenterX.push_back(center.x);
+    m_CenterY.push_back(center.y);
+    m_CenterZ.push_back(center.z);
+    m_ExtentX.push_back(extents.x);
+    m_ExtentY.push_back(extents.y);
+    m_ExtentZ.push_back(extents.z);
+
+    return (std::uint32_t)(m_CenterX.size() - 1);
+}
+
+void FrustumCuller::Cull(const Frustum &frustum, std::vector<std::uint32_t> &visible) const
+{
+    std::size_t begin = 0;
+
+#ifdef FRUSTUM_USE_SSE
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    __m128 absX[6], absY[6], absZ[6];
+    for (int p = 0; p < 6; p++)
+    {
+        const glm::vec4 &plane = frustum.planes[p];
+        planeX[p] = _mm_set1_ps(plane.x);
+        planeY[p] = _mm_set1_ps(plane.y);
+        planeZ[p] = _mm_set1_ps(plane.z);
+        planeW[p] = _mm_set1_ps(plane.w);
+        absX[p] = _mm_set1_ps(glm::abs(plane.x));
+        absY[p] = _mm_set1_ps(glm::abs(plane.y));
+        absZ[p] = _mm_set1_ps(glm::abs(plane.z));
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    const std::size_t simdCount = Size() & ~(std::size_t)3;
+
+    for (; begin < simdCount; begin += 4)
+    {
+        __m128 cx = _mm_loadu_ps(&m_CenterX[begin]);
+        __m128 cy = _mm_loadu_ps(&m_CenterY[begin]);
+        __m128 cz = _mm_loadu_ps(&m_CenterZ[begin]);
+        __m128 ex = _mm_loadu_ps(&m_ExtentX[begin]);
+        __m128 ey = _mm_loadu_ps(&m_ExtentY[begin]);
+        __m128 ez = _mm_loadu_ps(&m_ExtentZ[begin]);
+
+        __m128 outside = zero;
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)),
+                                       _mm_mul_ps(absZ[p], ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        int mask = ~_mm_movemask_ps(outside) & 0xF;
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (mask & (1 << lane))
+                visible.push_back((std::uint32_t)(begin + lane));
+        }
+    }
+#endif
+
+    CullScalar(frustum, begin, visible);
+}
+
+void FrustumCuller::CullScalar(const Frustum &frustum, std::size_t begin, std::vector<std::uint32_t> &visible) const
+{
+    for (std::size_t i = begin; i < Size(); i++)
+    {
+        bool inside = true;
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+            float distance = plane.x * m_CenterX[i] + plane.y * m_CenterY[i] + plane.z * m_CenterZ[i] + plane.w;
+            float radius = glm::abs(plane.x) * m_ExtentX[i] + glm::abs(plane.y) * m_ExtentY[i] +
+                           glm::abs(plane.z) * m_ExtentZ[i];
+            if (distance + radius < 0.0f)
+            {
+                inside = false;
+                break;
+            }
+        }
+
+        if (inside)
+            visible.push_back((std::uint32_t)i);
+    }
+}
@@ -0,0 +1,288 @@
+#include <engine/graphic/geometry_arena.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+
+bool RangeAllocator::Allocate(std::size_t size, std::size_t alignment, std::size_t &offset)
+{
+    for (auto it = m_Free.begin(); it != m_Free.end(); ++it)
+    {
+        std::size_t start = it->first;
+        std::size_t length = it->second;
+        std::size_t aligned = (start + alignment - 1) / alignment * alignment;
+        if (aligned + size > start + length)
+            continue;
+
+        m_Free.erase(it);
+        if (aligned > start)
+            m_Free[start] = aligned - start;
+        if (aligned + size < start + length)
+            m_Free[aligned + size] = start + length - (aligned + size);
+
+        offset = aligned;
+        m_Used += size;
+        return true;
+    }
+    return false;
+}
+
+void RangeAllocator::Free(std::size_t offset, std::size_t size)
+{
+    m_Used -= size;
+
+    auto next = m_Free.lower_bound(offset);
+    if (next != m_Free.end() && offset + size == next->first)
+    {
+        size += next->second;
+        next = m_Free.erase(next);
+    }
+
+    if (next != m_Free.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset)
+        {
+            prev->second += size;
+            return;
+        }
+    }
+
+    m_Free[offset] = size;
+}
+
+void RangeAllocator::Grow(std::size_t capacity)
+{
+    if (capacity <= m_Capacity)
+        return;
+
+    std::size_t added = capacity - m_Capacity;
+    std::size_t start = m_Capacity;
+    m_Capacity = capacity;
+
+    m_Used += added;
+    Free(start, added);
+}
+
+GeometryArena &GeometryArena::Get()
+{
+    static GeometryArena arena;
+    return arena;
+}
+
+void GeometryArena::Shutdown()
+{
+    GLStateCache &cache = GLStateCache::Get();
+    for (VertexPool &pool : m_Pools)
+    {
+        if (!pool.vao)
+            continue;
+
+        cache.ForgetVertexArray(pool.vao);
+        cache.ForgetBuffer(pool.vbo);
+        glDeleteVertexArrays(1, &pool.vao);
+        glDeleteBuffers(1, &pool.vbo);
+        pool = VertexPool{};
+    }
+
+    if (m_IndexBuffer)
+    {
+        cache.ForgetBuffer(m_IndexBuffer);
+        glDeleteBuffers(1, &m_IndexBuffer);
+        m_IndexBuffer = 0;
+        m_Indices = RangeAllocator{};
+    }
+}
+
+GeometryAllocation GeometryArena::Allocate(VertexFormat format, const void *vertices, std::size_t vertexCount,
+                                           const void *indices, std::size_t indexCount, GLenum indexType)
+{
+    GeometryAllocation allocation;
+    if (!vertexCount || !indexCount)
+        return allocation;
+
+    VertexPool &pool = GetPool(format);
+    const GLsizei stride = GetVertexStride(format);
+    const std::size_t indexSize = indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+
+    std::size_t firstVertex = (std::size_t)AllocateVertices(format, vertexCount);
+
+    // Uploads go through COPY_WRITE so the element binding of whatever VAO is bound stays intact
+    GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, pool.vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, firstVertex * stride, vertexCount * stride, vertices);
+    RenderStats::Get().bytesUploaded += (unsigned int)(vertexCount * stride);
+
+    std::size_t indexOffset = UploadIndices(indices, indexCount * indexSize);
+
+    allocation.format = format;
+    allocation.baseVertex = (GLint)firstVertex;
+    allocation.vertexCount = (GLuint)vertexCount;
+    allocation.indexOffset = (GLuint)indexOffset;
+    allocation.indexCount = (GLuint)indexCount;
+    allocation.indexType = indexType;
+    return allocation;
+}
+
+void GeometryArena::Free(const GeometryAllocation &allocation)
+{
+    if (!allocation.IsValid())
+        return;
+
+    const std::size_t indexSize = allocation.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+    GetPool(allocation.format).allocator.Free(allocation.baseVertex, allocation.vertexCount);
+    m_Indices.Free(allocation.indexOffset, allocation.indexCount * indexSize);
+}
+
+GeometryAllocation GeometryArena::AllocateIndices(const GeometryAllocation &vertices, const void *indices,
+                                                  std::size_t indexCount)
+{
+    GeometryAllocation allocation = vertices;
+    allocation.indexCount = 0;
+    if (!vertices.IsValid() || !indexCount)
+        return allocation;
+
+    const std::size_t indexSize = vertices.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+    allocation.indexOffset = (GLuint)UploadIndices(indices, indexCount * indexSize);
+    allocation.indexCount = (GLuint)indexCount;
+    return allocation;
+}
+
+void GeometryArena::FreeIndices(const GeometryAllocation &allocation)
+{
+    if (!allocation.IsValid())
+        return;
+
+    const std::size_t indexSize = allocation.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+    m_Indices.Free(allocation.indexOffset, allocation.indexCount * indexSize);
+}
+
+std::size_t GeometryArena::UploadIndices(const void *indices, std::size_t bytes)
+{
+    std::size_t offset = 0;
+    if (!m_Indices.Allocate(bytes, 4, offset))
+    {
+        GrowIndices(m_Indices.GetCapacity() + bytes + 4);
+        m_Indices.Allocate(bytes, 4, offset);
+    }
+
+    GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, m_IndexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytes, indices);
+    RenderStats::Get().bytesUploaded += (unsigned int)bytes;
+    return offset;
+}
+
+GLint GeometryArena::AllocateVertices(VertexFormat format, std::size_t vertexCount)
+{
+    if (!vertexCount)
+        return -1;
+
+    VertexPool &pool = GetPool(format);
+    std::size_t firstVertex = 0;
+    if (!pool.allocator.Allocate(vertexCount, 1, firstVertex))
+    {
+        GrowVertices(format, pool.allocator.GetCapacity() + vertexCount);
+        pool.allocator.Allocate(vertexCount, 1, firstVertex);
+    }
+    return (GLint)firstVertex;
+}
+
+void GeometryArena::FreeVertices(VertexFormat format, GLint baseVertex, std::size_t vertexCount)
+{
+    if (baseVertex < 0 || !vertexCount)
+        return;
+
+    GetPool(format).allocator.Free((std::size_t)baseVertex, vertexCount);
+}
+
+void GeometryArena::Bind(VertexFormat format)
+{
+    GLStateCache::Get().BindVertexArray(GetPool(format).vao);
+}
+
+std::size_t GeometryArena::GetVertexBytes() const
+{
+    std::size_t bytes = 0;
+    for (std::size_t format = 0; format < VERTEX_FORMAT_COUNT; format++)
+        bytes += m_Pools[format].allocator.GetUsed() * GetVertexStride((VertexFormat)format);
+    return bytes;
+}
+
+GeometryArena::VertexPool &GeometryArena::GetPool(VertexFormat format)
+{
+    VertexPool &pool = m_Pools[(std::size_t)format];
+    if (pool.vao)
+        return pool;
+
+    if (!m_IndexBuffer)
+    {
+        glGenBuffers(1, &m_IndexBuffer);
+        GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, m_IndexBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, INITIAL_INDEX_CAPACITY, nullptr, GL_STATIC_DRAW);
+        m_Indices.Grow(INITIAL_INDEX_CAPACITY);
+    }
+
+    GLStateCache &cache = GLStateCache::Get();
+    glGenVertexArrays(1, &pool.vao);
+    glGenBuffers(1, &pool.vbo);
+
+    cache.BindBuffer(GL_ARRAY_BUFFER, pool.vbo);
+    glBufferData(GL_ARRAY_BUFFER, INITIAL_VERTEX_CAPACITY * GetVertexStride(format), nullptr, GL_STATIC_DRAW);
+    pool.allocator.Grow(INITIAL_VERTEX_CAPACITY);
+
+    cache.BindVertexArray(pool.vao);
+    cache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+    SetupVertexAttributes(format);
+
+    return pool;
+}
+
+void GeometryArena::GrowVertices(VertexFormat format, std::size_t minimumCapacity)
+{
+    VertexPool &pool = GetPool(format);
+    const GLsizei stride = GetVertexStride(format);
+
+    std::size_t capacity = pool.allocator.GetCapacity();
+    while (capacity < minimumCapacity)
+        capacity *= 2;
+
+    pool.vbo = Reallocate(pool.vbo, pool.allocator.GetCapacity() * stride, capacity * stride);
+    pool.allocator.Grow(capacity);
+
+    GLStateCache &cache = GLStateCache::Get();
+    cache.BindVertexArray(pool.vao);
+    cache.BindBuffer(GL_ARRAY_BUFFER, pool.vbo);
+    SetupVertexAttributes(format);
+}
+
+void GeometryArena::GrowIndices(std::size_t minimumCapacity)
+{
+    std::size_t capacity = m_Indices.GetCapacity();
+    while (capacity < minimumCapacity)
+        capacity *= 2;
+
+    m_IndexBuffer = Reallocate(m_IndexBuffer, m_Indices.GetCapacity(), capacity);
+    m_Indices.Grow(capacity);
+
+    GLStateCache &cache = GLStateCache::Get();
+    for (VertexPool &pool : m_Pools)
+    {
+        if (!pool.vao)
+            continue;
+        cache.BindVertexArray(pool.vao);
+        cache.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+    }
+}
+
+GLuint GeometryArena::Reallocate(GLuint buffer, std::size_t oldBytes, std::size_t newBytes)
+{
+    GLuint grown = 0;
+    glGenBuffers(1, &grown);
+
+    GLStateCache &cache = GLStateCache::Get();
+    cache.BindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+    cache.BindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+
+    cache.ForgetBuffer(buffer);
+    glDeleteBuffers(1, &buffer);
+    return grown;
+}
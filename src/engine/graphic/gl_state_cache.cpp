@@ -0,0 +1,340 @@
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+
+GLStateCache &GLStateCache::Get()
+{
+    static GLStateCache cache;
+    return cache;
+}
+
+GLStateCache::GLStateCache()
+{
+    Invalidate();
+}
+
+void GLStateCache::UseProgram(GLuint program)
+{
+    RenderStats &stats = RenderStats::Get();
+    if (m_Program == program)
+    {
+        stats.glCallsElided++;
+        return;
+    }
+
+    glUseProgram(program);
+    m_Program = program;
+    stats.glCallsIssued++;
+}
+
+void GLStateCache::BindVertexArray(GLuint vao)
+{
+    RenderStats &stats = RenderStats::Get();
+    if (m_VertexArray == vao)
+    {
+        stats.glCallsElided++;
+        return;
+    }
+
+    glBindVertexArray(vao);
+    m_VertexArray = vao;
+    stats.glCallsIssued++;
+}
+
+void GLStateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+    RenderStats &stats = RenderStats::Get();
+    int slot = BufferSlot(target);
+    // Element array bindings belong to the bound vertex array, so they are issued but not shadowed
+    if (slot < 0)
+    {
+        glBindBuffer(target, buffer);
+        stats.glCallsIssued++;
+        return;
+    }
+
+    if (m_Buffers[slot] == buffer)
+    {
+        stats.glCallsElided++;
+        return;
+    }
+
+    glBindBuffer(target, buffer);
+    m_Buffers[slot] = buffer;
+    stats.glCallsIssued++;
+}
+
+void GLStateCache::BindUniformBufferRange(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    RenderStats &stats = RenderStats::Get();
+    if (binding >= MAX_UNIFORM_BINDINGS)
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+        m_Buffers[BufferSlot(GL_UNIFORM_BUFFER)] = buffer;
+        stats.glCallsIssued++;
+        return;
+    }
+
+    BufferRange &range = m_UniformRanges[binding];
+    if (range.buffer == buffer && range.offset == offset && range.size == size)
+    {
+        stats.glCallsElided++;
+        return;
+    }
+
+    // Indexed binds also replace the generic GL_UNIFORM_BUFFER binding
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+    range = {buffer, offset, size};
+    m_Buffers[BufferSlot(GL_UNIFORM_BUFFER)] = buffer;
+    stats.glCallsIssued++;
+}
+
+void GLStateCache::BindBufferBase(GLenum target, GLuint binding, GLuint buffer)
+{
+    // Indexed storage bindings are not shadowed, but they do replace the generic binding
+    glBindBufferBase(target, binding, buffer);
+    int slot = BufferSlot(target);
+    if (slot >= 0)
+        m_Buffers[slot] = buffer;
+
+    // A whole-buffer uniform binding matches no range, so the next range bind is issued
+    if (target == GL_UNIFORM_BUFFER && binding < MAX_UNIFORM_BINDINGS)
+        m_UniformRanges[binding] = {buffer, 0, -1};
+    RenderStats::Get().glCallsIssued++;
+}
+
+void GLStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    RenderStats &stats = RenderStats::Get();
+    if (unit >= MAX_TEXTURE_UNITS)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        m_ActiveUnit = unit;
+        stats.glCallsIssued += 2;
+        return;
+    }
+
+    if (m_Textures[unit] == texture && m_TextureTargets[unit] == target)
+    {
+        stats.glCallsElided++;
+        return;
+    }
+
+    if (m_ActiveUnit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        m_ActiveUnit = unit;
+        stats.glCallsIssued++;
+    }
+
+    glBindTexture(target, texture);
+    m_Textures[unit] = texture;
+    m_TextureTargets[unit] = target;
+    stats.glCallsIssued++;
+}
+
+void GLStateCache::BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    RenderStats &stats = RenderStats::Get();
+    bool read = target != GL_DRAW_FRAMEBUFFER;
+    bool draw = target != GL_READ_FRAMEBUFFER;
+    if ((!read || m_ReadFramebuffer == framebuffer) && (!draw || m_DrawFramebuffer == framebuffer))
+    {
+        stats.glCallsElided++;
+        return;
+    }
+
+    glBindFramebuffer(target, framebuffer);
+    if (read)
+        m_ReadFramebuffer = framebuffer;
+    if (draw)
+        m_DrawFramebuffer = framebuffer;
+    stats.glCallsIssued++;
+}
+
+void GLStateCache::SetViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    RenderStats &stats = RenderStats::Get();
+    if (m_Viewport[0] == x && m_Viewport[1] == y && m_Viewport[2] == width && m_Viewport[3] == height)
+    {
+        stats.glCallsElided++;
+        return;
+    }
+
+    glViewport(x, y, width, height);
+    m_Viewport[0] = x;
+    m_Viewport[1] = y;
+    m_Viewport[2] = width;
+    m_Viewport[3] = height;
+    stats.glCallsIssued++;
+}
+
+void GLStateCache::SetDepthTest(bool enabled)
+{
+    SetCapability(m_DepthTest, GL_DEPTH_TEST, enabled);
+}
+
+void GLStateCache::SetBlend(bool enabled)
+{
+    SetCapability(m_Blend, GL_BLEND, enabled);
+}
+
+void GLStateCache::SetCullFace(bool enabled)
+{
+    SetCapability(m_CullFace, GL_CULL_FACE, enabled);
+}
+
+void GLStateCache::SetDepthClamp(bool enabled)
+{
+    SetCapability(m_DepthClamp, GL_DEPTH_CLAMP, enabled);
+}
+
+void GLStateCache::SetDepthWrite(bool enabled)
+{
+    RenderStats &stats = RenderStats::Get();
+    Toggle wanted = enabled ? Toggle::On : Toggle::Off;
+    if (m_DepthWrite == wanted)
+    {
+        stats.glCallsElided++;
+        return;
+    }
+
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    m_DepthWrite = wanted;
+    stats.glCallsIssued++;
+}
+
+void GLStateCache::SetBlendFunc(GLenum src, GLenum dst)
+{
+    RenderStats &stats = RenderStats::Get();
+    if (m_BlendSrc == src && m_BlendDst == dst)
+    {
+        stats.glCallsElided++;
+        return;
+    }
+
+    glBlendFunc(src, dst);
+    m_BlendSrc = src;
+    m_BlendDst = dst;
+    stats.glCallsIssued++;
+}
+
+void GLStateCache::ForgetProgram(GLuint program)
+{
+    if (m_Program == program)
+        m_Program = UNKNOWN;
+}
+
+void GLStateCache::ForgetVertexArray(GLuint vao)
+{
+    if (m_VertexArray == vao)
+        m_VertexArray = UNKNOWN;
+}
+
+void GLStateCache::ForgetBuffer(GLuint buffer)
+{
+    for (GLuint &bound : m_Buffers)
+    {
+        if (bound == buffer)
+            bound = UNKNOWN;
+    }
+
+    for (BufferRange &range : m_UniformRanges)
+    {
+        if (range.buffer == buffer)
+            range.buffer = UNKNOWN;
+    }
+}
+
+void GLStateCache::ForgetTexture(GLuint texture)
+{
+    for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+    {
+        if (m_Textures[unit] == texture)
+            m_Textures[unit] = UNKNOWN;
+    }
+}
+
+void GLStateCache::ForgetFramebuffer(GLuint framebuffer)
+{
+    if (m_ReadFramebuffer == framebuffer)
+        m_ReadFramebuffer = UNKNOWN;
+    if (m_DrawFramebuffer == framebuffer)
+        m_DrawFramebuffer = UNKNOWN;
+}
+
+void GLStateCache::Invalidate()
+{
+    m_Program = UNKNOWN;
+    m_VertexArray = UNKNOWN;
+    m_ActiveUnit = UNKNOWN;
+    m_ReadFramebuffer = UNKNOWN;
+    m_DrawFramebuffer = UNKNOWN;
+
+    // A negative size matches no real viewport
+    m_Viewport[0] = m_Viewport[1] = 0;
+    m_Viewport[2] = m_Viewport[3] = -1;
+
+    for (GLuint &buffer : m_Buffers)
+        buffer = UNKNOWN;
+
+    for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+    {
+        m_Textures[unit] = UNKNOWN;
+        m_TextureTargets[unit] = UNKNOWN;
+    }
+
+    for (BufferRange &range : m_UniformRanges)
+        range = {UNKNOWN, 0, 0};
+
+    m_DepthTest = Toggle::Unknown;
+    m_DepthWrite = Toggle::Unknown;
+    m_Blend = Toggle::Unknown;
+    m_CullFace = Toggle::Unknown;
+    m_DepthClamp = Toggle::Unknown;
+    m_BlendSrc = UNKNOWN;
+    m_BlendDst = UNKNOWN;
+}
+
+int GLStateCache::BufferSlot(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER:
+        return 0;
+    case GL_UNIFORM_BUFFER:
+        return 1;
+    case GL_TEXTURE_BUFFER:
+        return 2;
+    case GL_COPY_READ_BUFFER:
+        return 3;
+    case GL_COPY_WRITE_BUFFER:
+        return 4;
+    case GL_PIXEL_UNPACK_BUFFER:
+        return 5;
+    case GL_DRAW_INDIRECT_BUFFER:
+        return 6;
+    case GL_SHADER_STORAGE_BUFFER:
+        return 7;
+    default:
+        return -1;
+    }
+}
+
+void GLStateCache::SetCapability(Toggle &state, GLenum capability, bool enabled)
+{
+    RenderStats &stats = RenderStats::Get();
+    Toggle wanted = enabled ? Toggle::On : Toggle::Off;
+    if (state == wanted)
+    {
+        stats.glCallsElided++;
+        return;
+    }
+
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+    state = wanted;
+    stats.glCallsIssued++;
+}
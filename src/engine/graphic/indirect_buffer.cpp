@@ -0,0 +1,52 @@
+#include <engine/graphic/indirect_buffer.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+
+bool IsMultiDrawIndirectSupported()
+{
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+IndirectBuffer::IndirectBuffer(std::size_t initialCapacity)
+    : m_Capacity(initialCapacity)
+{
+    glGenBuffers(1, &m_ID);
+    GLStateCache::Get().BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_ID);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, m_Capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+}
+
+IndirectBuffer::~IndirectBuffer()
+{
+    GLStateCache::Get().ForgetBuffer(m_ID);
+    glDeleteBuffers(1, &m_ID);
+}
+
+void IndirectBuffer::BeginFrame()
+{
+    m_Staging.clear();
+}
+
+GLuint IndirectBuffer::Push(const DrawElementsIndirectCommand &command)
+{
+    m_Staging.push_back(command);
+    return (GLuint)(m_Staging.size() - 1);
+}
+
+void IndirectBuffer::Upload()
+{
+    if (m_Staging.empty())
+        return;
+
+    while (m_Capacity < m_Staging.size())
+        m_Capacity *= 2;
+
+    GLStateCache::Get().BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_ID);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, m_Capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, GetUploadedBytes(), m_Staging.data());
+    RenderStats::Get().bytesUploaded += (unsigned int)GetUploadedBytes();
+}
+
+void IndirectBuffer::Bind() const
+{
+    GLStateCache::Get().BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_ID);
+}
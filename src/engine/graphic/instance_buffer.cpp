@@ -0,0 +1,72 @@
+#include <engine/graphic/instance_buffer.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+
+#include <cstddef>
+
+InstanceBuffer::InstanceBuffer(std::size_t initialCapacity)
+    : m_Capacity(initialCapacity)
+{
+    glGenBuffers(1, &m_ID);
+    GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_ID);
+    glBufferData(GL_ARRAY_BUFFER, m_Capacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    GLStateCache::Get().ForgetBuffer(m_ID);
+    glDeleteBuffers(1, &m_ID);
+}
+
+void InstanceBuffer::BeginFrame()
+{
+    m_Staging.clear();
+}
+
+GLuint InstanceBuffer::Push(const InstanceData &instance)
+{
+    m_Staging.push_back(instance);
+    return (GLuint)(m_Staging.size() - 1);
+}
+
+void InstanceBuffer::Upload()
+{
+    if (m_Staging.empty())
+        return;
+
+    while (m_Capacity < m_Staging.size())
+        m_Capacity *= 2;
+
+    // Orphan the previous store so the driver never stalls on last frame's draws
+    GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_ID);
+    glBufferData(GL_ARRAY_BUFFER, m_Capacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_Staging.size() * sizeof(InstanceData), m_Staging.data());
+    RenderStats::Get().bytesUploaded += (unsigned int)(m_Staging.size() * sizeof(InstanceData));
+}
+
+void InstanceBuffer::BindAttributes(GLuint firstInstance) const
+{
+    const GLsizei stride = sizeof(InstanceData);
+    const std::size_t base = firstInstance * sizeof(InstanceData);
+
+    GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_ID);
+
+    for (GLuint column = 0; column < 4; column++)
+    {
+        GLuint location = FIRST_ATTRIBUTE + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride,
+                              (void *)(base + offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glEnableVertexAttribArray(FIRST_ATTRIBUTE + 4);
+    glVertexAttribPointer(FIRST_ATTRIBUTE + 4, 4, GL_FLOAT, GL_FALSE, stride,
+                          (void *)(base + offsetof(InstanceData, color)));
+    glVertexAttribDivisor(FIRST_ATTRIBUTE + 4, 1);
+
+    glEnableVertexAttribArray(FIRST_ATTRIBUTE + 5);
+    glVertexAttribIPointer(FIRST_ATTRIBUTE + 5, 1, GL_INT, stride,
+                           (void *)(base + offsetof(InstanceData, boneOffset)));
+    glVertexAttribDivisor(FIRST_ATTRIBUTE + 5, 1);
+}
@@ -0,0 +1,339 @@
+#include <engine/graphic/light_clusters.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHT_CLUSTERS_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+static_assert(LightClusterGrid::TILES_X % 4 == 0, "Rows are tested four clusters at a time");
+static_assert(LightClusterGrid::CLUSTER_COUNT < (1 << 16), "Cluster ids are packed into 16 bits");
+
+static constexpr std::size_t MAX_LIGHTS = 1 << 16;
+
+LightClusterGrid::LightClusterGrid()
+{
+    m_LightBuffer.format = GL_RGBA32F;
+    m_GridBuffer.format = GL_RG32UI;
+    m_IndexBuffer.format = GL_R32UI;
+
+    GLStateCache &cache = GLStateCache::Get();
+    const GLuint units[] = {LIGHTS_TEXTURE_UNIT, GRID_TEXTURE_UNIT, INDICES_TEXTURE_UNIT};
+    TextureBuffer *buffers[] = {&m_LightBuffer, &m_GridBuffer, &m_IndexBuffer};
+    for (int i = 0; i < 3; i++)
+    {
+        TextureBuffer &target = *buffers[i];
+        glGenBuffers(1, &target.buffer);
+        glGenTextures(1, &target.texture);
+
+        target.capacity = 256;
+        cache.BindBuffer(GL_TEXTURE_BUFFER, target.buffer);
+        glBufferData(GL_TEXTURE_BUFFER, target.capacity, nullptr, GL_STREAM_DRAW);
+
+        cache.BindTexture(units[i], GL_TEXTURE_BUFFER, target.texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, target.format, target.buffer);
+    }
+
+    const std::size_t clusters = CLUSTER_COUNT;
+    for (auto *stream : {&m_MinX, &m_MinY, &m_MinZ, &m_MaxX, &m_MaxY, &m_MaxZ})
+        stream->resize(clusters);
+    m_Counts.resize(clusters);
+    m_Grid.resize(clusters);
+}
+
+LightClusterGrid::~LightClusterGrid()
+{
+    GLStateCache &cache = GLStateCache::Get();
+    for (TextureBuffer *target : {&m_LightBuffer, &m_GridBuffer, &m_IndexBuffer})
+    {
+        cache.ForgetTexture(target->texture);
+        cache.ForgetBuffer(target->buffer);
+        glDeleteTextures(1, &target->texture);
+        glDeleteBuffers(1, &target->buffer);
+    }
+}
+
+void LightClusterGrid::SetProjection(const glm::mat4 &projection, float nearPlane, float farPlane, float screenWidth,
+                                     float screenHeight)
+{
+    glm::vec2 screen(screenWidth, screenHeight);
+    if (projection == m_Projection && nearPlane == m_Near && farPlane == m_Far && screen == m_Screen)
+        return;
+
+    m_Projection = projection;
+    m_Near = nearPlane;
+    m_Far = farPlane;
+    m_Screen = screen;
+
+    // slice = log(depth) * scale + bias gives exponentially deeper slices
+    float logRatio = std::log(farPlane / nearPlane);
+    m_Params = glm::vec4(SLICES / logRatio, -SLICES * std::log(nearPlane) / logRatio,
+                         screenWidth / TILES_X, screenHeight / TILES_Y);
+
+    glm::mat4 inverseProjection = glm::inverse(projection);
+    auto rayThrough = [&](float ndcX, float ndcY)
+    {
+        glm::vec4 point = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+        glm::vec3 view = glm::vec3(point) / point.w;
+        return view / -view.z; // direction scaled to unit depth
+    };
+
+    for (int z = 0; z < SLICES; z++)
+    {
+        float sliceNear = nearPlane * std::pow(farPlane / nearPlane, (float)z / SLICES);
+        float sliceFar = nearPlane * std::pow(farPlane / nearPlane, (float)(z + 1) / SLICES);
+
+        for (int y = 0; y < TILES_Y; y++)
+        {
+            for (int x = 0; x < TILES_X; x++)
+            {
+                float x0 = -1.0f + 2.0f * x / TILES_X;
+                float x1 = -1.0f + 2.0f * (x + 1) / TILES_X;
+                float y0 = -1.0f + 2.0f * y / TILES_Y;
+                float y1 = -1.0f + 2.0f * (y + 1) / TILES_Y;
+                const glm::vec3 rays[4] = {rayThrough(x0, y0), rayThrough(x1, y0), rayThrough(x0, y1), rayThrough(x1, y1)};
+
+                glm::vec3 boxMin(1e30f);
+                glm::vec3 boxMax(-1e30f);
+                for (const glm::vec3 &ray : rays)
+                {
+                    for (float depth : {sliceNear, sliceFar})
+                    {
+                        boxMin = glm::min(boxMin, ray * depth);
+                        boxMax = glm::max(boxMax, ray * depth);
+                    }
+                }
+
+                std::size_t cluster = (z * TILES_Y + y) * TILES_X + x;
+                m_MinX[cluster] = boxMin.x;
+                m_MinY[cluster] = boxMin.y;
+                m_MinZ[cluster] = boxMin.z;
+                m_MaxX[cluster] = boxMax.x;
+                m_MaxY[cluster] = boxMax.y;
+                m_MaxZ[cluster] = boxMax.z;
+            }
+        }
+    }
+}
+
+void LightClusterGrid::Clear()
+{
+    m_Lights.clear();
+    m_ViewLights.clear();
+}
+
+void LightClusterGrid::AddLight(const GPULight &light, const glm::mat4 &view)
+{
+    if (m_Lights.size() >= MAX_LIGHTS)
+        return;
+
+    ViewLight viewLight;
+    viewLight.center = glm::vec3(view * glm::vec4(glm::vec3(light.position), 1.0f));
+    viewLight.radius = light.position.w;
+    viewLight.spot = (int)light.color.w == GPU_LIGHT_SPOT;
+    viewLight.direction = viewLight.spot ? glm::normalize(glm::mat3(view) * glm::vec3(light.direction)) : glm::vec3(0.0f);
+    viewLight.cosOuter = light.cone.y;
+
+    m_Lights.push_back(light);
+    m_ViewLights.push_back(viewLight);
+}
+
+int LightClusterGrid::SliceFromDepth(float depth) const
+{
+    int slice = (int)std::floor(std::log(depth) * m_Params.x + m_Params.y);
+    return std::clamp(slice, 0, SLICES - 1);
+}
+
+void LightClusterGrid::AssignLight(std::uint32_t lightIndex)
+{
+    const ViewLight &light = m_ViewLights[lightIndex];
+
+    float depthNear = -light.center.z - light.radius;
+    float depthFar = -light.center.z + light.radius;
+    if (depthFar < m_Near || depthNear > m_Far)
+        return;
+    depthNear = std::max(depthNear, m_Near);
+    depthFar = std::min(depthFar, m_Far);
+
+    // Screen rectangle of the light's view-space box; every corner is in front of the camera
+    glm::vec2 ndcMin(1e30f);
+    glm::vec2 ndcMax(-1e30f);
+    for (int corner = 0; corner < 8; corner++)
+    {
+        glm::vec4 point(light.center.x + ((corner & 1) ? light.radius : -light.radius),
+                        light.center.y + ((corner & 2) ? light.radius : -light.radius),
+                        (corner & 4) ? -depthFar : -depthNear, 1.0f);
+        glm::vec4 clip = m_Projection * point;
+        glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, ndc);
+        ndcMax = glm::max(ndcMax, ndc);
+    }
+    if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f)
+        return;
+
+    int x0 = std::clamp((int)std::floor((ndcMin.x * 0.5f + 0.5f) * TILES_X), 0, TILES_X - 1);
+    int x1 = std::clamp((int)std::floor((ndcMax.x * 0.5f + 0.5f) * TILES_X), 0, TILES_X - 1);
+    int y0 = std::clamp((int)std::floor((ndcMin.y * 0.5f + 0.5f) * TILES_Y), 0, TILES_Y - 1);
+    int y1 = std::clamp((int)std::floor((ndcMax.y * 0.5f + 0.5f) * TILES_Y), 0, TILES_Y - 1);
+    int z0 = SliceFromDepth(depthNear);
+    int z1 = SliceFromDepth(depthFar);
+
+    const float radiusSq = light.radius * light.radius;
+    const float sinOuter = std::sqrt(std::max(0.0f, 1.0f - light.cosOuter * light.cosOuter));
+
+    auto accept = [&](std::size_t cluster)
+    {
+        if (light.spot)
+        {
+            // Cone against the cluster's bounding sphere, after Wronski's "Cull that cone"
+            glm::vec3 boxMin(m_MinX[cluster], m_MinY[cluster], m_MinZ[cluster]);
+            glm::vec3 boxMax(m_MaxX[cluster], m_MaxY[cluster], m_MaxZ[cluster]);
+            glm::vec3 center = (boxMin + boxMax) * 0.5f;
+            float sphereRadius = glm::length(boxMax - boxMin) * 0.5f;
+
+            glm::vec3 v = center - light.center;
+            float along = glm::dot(v, light.direction);
+            float across = std::sqrt(std::max(0.0f, glm::dot(v, v) - along * along));
+            float closest = light.cosOuter * across - along * sinOuter;
+            if (closest > sphereRadius || along > sphereRadius + light.radius || along < -sphereRadius)
+                return;
+        }
+
+        m_Counts[cluster]++;
+        m_Hits.push_back((std::uint32_t)(cluster << 16) | lightIndex);
+    };
+
+    for (int z = z0; z <= z1; z++)
+    {
+        for (int y = y0; y <= y1; y++)
+        {
+            const std::size_t row = (std::size_t)(z * TILES_Y + y) * TILES_X;
+            int x = x0;
+
+#ifdef LIGHT_CLUSTERS_USE_SSE
+            const __m128 cx = _mm_set1_ps(light.center.x);
+            const __m128 cy = _mm_set1_ps(light.center.y);
+            const __m128 cz = _mm_set1_ps(light.center.z);
+            const __m128 r2 = _mm_set1_ps(radiusSq);
+            const __m128 zero = _mm_setzero_ps();
+
+            // Rows are a multiple of four wide, so aligned groups never cross into the next row
+            for (x = x0 & ~3; x <= x1; x += 4)
+            {
+                std::size_t base = row + x;
+                __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_MinX[base]), cx), zero),
+                                       _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(&m_MaxX[base])), zero));
+                __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_MinY[base]), cy), zero),
+                                       _mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(&m_MaxY[base])), zero));
+                __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_MinZ[base]), cz), zero),
+                                       _mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(&m_MaxZ[base])), zero));
+                __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+                int mask = _mm_movemask_ps(_mm_cmple_ps(distanceSq, r2));
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    int tile = x + lane;
+                    if ((mask & (1 << lane)) && tile >= x0 && tile <= x1)
+                        accept(base + lane);
+                }
+            }
+#endif
+
+            for (; x <= x1; x++)
+            {
+                std::size_t cluster = row + x;
+                glm::vec3 boxMin(m_MinX[cluster], m_MinY[cluster], m_MinZ[cluster]);
+                glm::vec3 boxMax(m_MaxX[cluster], m_MaxY[cluster], m_MaxZ[cluster]);
+                glm::vec3 delta = glm::max(boxMin - light.center, glm::vec3(0.0f)) +
+                                  glm::max(light.center - boxMax, glm::vec3(0.0f));
+                if (glm::dot(delta, delta) <= radiusSq)
+                    accept(cluster);
+            }
+        }
+    }
+}
+
+void LightClusterGrid::Build()
+{
+    std::fill(m_Counts.begin(), m_Counts.end(), 0u);
+    m_Hits.clear();
+
+    // Nothing can be assigned before a projection was set
+    if (m_Near > 0.0f)
+    {
+        for (std::uint32_t light = 0; light < m_ViewLights.size(); light++)
+            AssignLight(light);
+    }
+
+    // Counting sort of the (cluster, light) hits into contiguous per-cluster lists
+    std::uint32_t offset = 0;
+    for (std::size_t cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+    {
+        m_Grid[cluster] = glm::uvec2(offset, m_Counts[cluster]);
+        offset += m_Counts[cluster];
+        m_Counts[cluster] = m_Grid[cluster].x;
+    }
+
+    m_Indices.resize(m_Hits.size());
+    for (std::uint32_t hit : m_Hits)
+        m_Indices[m_Counts[hit >> 16]++] = hit & 0xFFFF;
+
+    Upload(m_LightBuffer, m_Lights.data(), m_Lights.size() * sizeof(GPULight));
+    Upload(m_GridBuffer, m_Grid.data(), m_Grid.size() * sizeof(glm::uvec2));
+    Upload(m_IndexBuffer, m_Indices.data(), m_Indices.size() * sizeof(std::uint32_t));
+}
+
+void LightClusterGrid::Bind() const
+{
+    GLStateCache &cache = GLStateCache::Get();
+    cache.BindTexture(LIGHTS_TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_LightBuffer.texture);
+    cache.BindTexture(GRID_TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_GridBuffer.texture);
+    cache.BindTexture(INDICES_TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_IndexBuffer.texture);
+}
+
+void LightClusterGrid::Upload(TextureBuffer &target, const void *data, std::size_t bytes)
+{
+    if (bytes == 0)
+        return;
+
+    const unsigned char *source = static_cast<const unsigned char *>(data);
+    GLStateCache::Get().BindBuffer(GL_TEXTURE_BUFFER, target.buffer);
+
+    // Same size as last time: only send the span that actually differs, usually nothing
+    if (bytes == target.uploaded.size())
+    {
+        const std::size_t chunk = 64;
+        std::size_t first = bytes, last = 0;
+        for (std::size_t offset = 0; offset < bytes; offset += chunk)
+        {
+            std::size_t length = std::min(chunk, bytes - offset);
+            if (std::memcmp(source + offset, target.uploaded.data() + offset, length) != 0)
+            {
+                first = std::min(first, offset);
+                last = offset + length;
+            }
+        }
+
+        if (first < last)
+        {
+            glBufferSubData(GL_TEXTURE_BUFFER, first, last - first, source + first);
+            std::memcpy(target.uploaded.data() + first, source + first, last - first);
+            RenderStats::Get().bytesUploaded += (unsigned int)(last - first);
+        }
+        return;
+    }
+
+    while (target.capacity < bytes)
+        target.capacity *= 2;
+
+    // Orphan the previous frame's store instead of waiting for the GPU to finish with it
+    glBufferData(GL_TEXTURE_BUFFER, target.capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+    target.uploaded.assign(source, source + bytes);
+    RenderStats::Get().bytesUploaded += (unsigned int)bytes;
+}
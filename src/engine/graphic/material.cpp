@@ -0,0 +1,151 @@
+#include <engine/graphic/material.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+
+#include <cstring>
+
+static const char *s_SamplerNames[TEXTURE_SLOT_COUNT] = {
+    "texture_diffuse1",
+    "texture_specular1",
+    "texture_normal1",
+    "texture_height1",
+};
+
+GLint GetSamplerUnit(const std::string &samplerName)
+{
+    for (std::size_t slot = 0; slot < TEXTURE_SLOT_COUNT; slot++)
+    {
+        if (samplerName == s_SamplerNames[slot])
+            return (GLint)(MATERIAL_TEXTURE_UNIT + slot);
+    }
+    return -1;
+}
+
+MaterialLibrary &MaterialLibrary::Get()
+{
+    static MaterialLibrary library;
+    return library;
+}
+
+MaterialLibrary::MaterialLibrary()
+{
+    m_Materials.push_back(Material{});
+}
+
+void MaterialLibrary::Shutdown()
+{
+    m_Params.reset();
+    m_Capacity = 0;
+    m_Dirty = true;
+
+    if (m_WhiteTexture)
+    {
+        GLStateCache::Get().ForgetTexture(m_WhiteTexture);
+        glDeleteTextures(1, &m_WhiteTexture);
+        m_WhiteTexture = 0;
+    }
+}
+
+MaterialHandle MaterialLibrary::Create(const Material &material)
+{
+    m_Dirty = true;
+    if (!m_FreeHandles.empty())
+    {
+        MaterialHandle handle = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+        m_Materials[handle] = material;
+        return handle;
+    }
+
+    m_Materials.push_back(material);
+    return (MaterialHandle)(m_Materials.size() - 1);
+}
+
+void MaterialLibrary::Release(MaterialHandle handle)
+{
+    if (handle == DEFAULT_MATERIAL || handle >= m_Materials.size())
+        return;
+
+    // The textures belong to the cache, which may already have deleted them and reused the names
+    m_Materials[handle] = Material{};
+    m_FreeHandles.push_back(handle);
+    m_Dirty = true;
+}
+
+const Material &MaterialLibrary::GetMaterial(MaterialHandle handle) const
+{
+    return m_Materials[Resolve(handle)];
+}
+
+void MaterialLibrary::SetParams(MaterialHandle handle, const MaterialParams &params)
+{
+    m_Materials[Resolve(handle)].params = params;
+    m_Dirty = true;
+}
+
+void MaterialLibrary::Bind(MaterialHandle handle)
+{
+    if (m_Dirty)
+        Upload();
+
+    handle = Resolve(handle);
+    const Material &material = m_Materials[handle];
+
+    GLStateCache &cache = GLStateCache::Get();
+    for (std::size_t slot = 0; slot < TEXTURE_SLOT_COUNT; slot++)
+    {
+        GLuint texture = material.textures[slot] ? material.textures[slot] : m_WhiteTexture;
+        cache.BindTexture(MATERIAL_TEXTURE_UNIT + (GLuint)slot, GL_TEXTURE_2D, texture);
+    }
+
+    cache.BindUniformBufferRange(MATERIAL_PARAMS_BINDING, m_Params->GetID(),
+                                 (GLintptr)handle * m_Stride, sizeof(MaterialParams));
+    RenderStats::Get().materialBinds++;
+}
+
+MaterialHandle MaterialLibrary::Resolve(MaterialHandle handle) const
+{
+    return handle < m_Materials.size() ? handle : DEFAULT_MATERIAL;
+}
+
+void MaterialLibrary::Upload()
+{
+    if (!m_WhiteTexture)
+        CreateWhiteTexture();
+
+    // Each material owns one aligned slice so binding is a single glBindBufferRange
+    if (!m_Stride)
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_Stride = ((GLsizeiptr)sizeof(MaterialParams) + alignment - 1) / alignment * alignment;
+    }
+
+    if (!m_Params || m_Capacity < m_Materials.size())
+    {
+        std::size_t capacity = m_Capacity ? m_Capacity : 64;
+        while (capacity < m_Materials.size())
+            capacity *= 2;
+
+        m_Params = std::make_unique<UniformBuffer>(capacity * m_Stride, MATERIAL_PARAMS_BINDING);
+        m_Capacity = capacity;
+    }
+
+    m_Staging.assign(m_Materials.size() * m_Stride, 0);
+    for (std::size_t i = 0; i < m_Materials.size(); i++)
+        std::memcpy(m_Staging.data() + i * m_Stride, &m_Materials[i].params, sizeof(MaterialParams));
+
+    m_Params->Update(m_Staging.data(), (GLsizeiptr)m_Staging.size());
+    m_Dirty = false;
+}
+
+void MaterialLibrary::CreateWhiteTexture()
+{
+    const unsigned char white[4] = {255, 255, 255, 255};
+
+    glGenTextures(1, &m_WhiteTexture);
+    GLStateCache::Get().BindTexture(MATERIAL_TEXTURE_UNIT, GL_TEXTURE_2D, m_WhiteTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
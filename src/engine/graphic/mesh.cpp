@@ -1,101 +1,163 @@
 #include <engine/graphic/mesh.h>
+#include <engine/graphic/render_stats.h>
 
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+static unsigned int s_NextMeshSortId = 0;
+
 Mesh::Mesh(std::vector<Vertex> vertices,
            std::vector<unsigned int> indices,
-           std::vector<Texture> textures)
+           std::vector<Texture> textures,
+           MaterialHandle material)
+    : m_SortId(s_NextMeshSortId++), m_Material(material)
 {
     this->vertices = vertices;
     this->indices = indices;
     this->textures = textures;
 
+    computeBounds();
     setupMesh();
 }
 
-void Mesh::Draw(Shader &shader)
+Mesh::Mesh(VertexFormat format, const void *packedVertices, std::size_t vertexCount, const void *packedIndices,
+           std::size_t indexCount, GLenum indexType, MaterialHandle material, const AABB &bounds,
+           const BoundingSphere &sphere)
+    : m_SortId(s_NextMeshSortId++), m_Material(material), m_Bounds(bounds), m_Sphere(sphere)
+{
+    // Every packed layout starts with its position
+    const unsigned char *bytes = static_cast<const unsigned char *>(packedVertices);
+    const std::size_t stride = GetVertexStride(format);
+    m_Positions.resize(vertexCount);
+    for (std::size_t i = 0; i < vertexCount; i++)
+        std::memcpy(&m_Positions[i], bytes + i * stride, sizeof(glm::vec3));
+
+    const unsigned char *indexBytes = static_cast<const unsigned char *>(packedIndices);
+    m_PackedIndices.assign(indexBytes, indexBytes + indexCount * (indexType == GL_UNSIGNED_SHORT ? 2 : 4));
+
+    m_Geometry = GeometryArena::Get().Allocate(format, packedVertices, vertexCount, packedIndices, indexCount, indexType);
+}
+
+void Mesh::Draw(MaterialHandle material, const GeometryAllocation *geometry)
+{
+    MaterialLibrary::Get().Bind(material != INVALID_MATERIAL ? material : m_Material);
+
+    const GeometryAllocation &draw = geometry ? *geometry : m_Geometry;
+    GeometryArena::Get().Bind(draw.format);
+    glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)draw.indexCount, draw.indexType,
+                             (void *)(std::uintptr_t)draw.indexOffset, draw.baseVertex);
+    RenderStats::Get().drawCalls++;
+}
+
+void Mesh::DrawInstanced(const InstanceBuffer &instances, GLuint firstInstance, GLsizei count, MaterialHandle material,
+                         const GeometryAllocation *geometry)
+{
+    MaterialLibrary::Get().Bind(material != INVALID_MATERIAL ? material : m_Material);
+
+    const GeometryAllocation &draw = geometry ? *geometry : m_Geometry;
+    GeometryArena::Get().Bind(draw.format);
+    instances.BindAttributes(firstInstance);
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)draw.indexCount, draw.indexType,
+                                      (void *)(std::uintptr_t)draw.indexOffset, count, draw.baseVertex);
+    RenderStats::Get().drawCalls++;
+}
+
+const GeometryAllocation &Mesh::GetGeometry(std::size_t lod) const
+{
+    if (lod == 0 || m_Lods.empty())
+        return m_Geometry;
+    return m_Lods[std::min(lod, m_Lods.size()) - 1].geometry;
+}
+
+float Mesh::GetLodError(std::size_t lod) const
+{
+    if (lod == 0 || m_Lods.empty())
+        return 0.0f;
+    return m_Lods[std::min(lod, m_Lods.size()) - 1].error;
+}
+
+void Mesh::AddLod(std::vector<unsigned int> lodIndices, float error)
 {
-    unsigned int diffuseNr = 1;
-    unsigned int specularNr = 1;
-    unsigned int normalNr = 1;
-    unsigned int heightNr = 1;
+    // The simplifier measures error relative to half the bounds' diagonal
+    MeshLod lod;
+    lod.error = error * glm::length(m_Bounds.GetExtents());
 
-    for (unsigned int i = 0; i < textures.size(); i++)
+    if (m_Geometry.indexType == GL_UNSIGNED_SHORT)
     {
-        glActiveTexture(GL_TEXTURE0 + i);
-
-        std::string number;
-        std::string name = textures[i].type;
-
-        if (name == "texture_diffuse")
-            number = std::to_string(diffuseNr++);
-        else if (name == "texture_specular")
-            number = std::to_string(specularNr++);
-        else if (name == "texture_normal")
-            number = std::to_string(normalNr++);
-        else if (name == "texture_height")
-            number = std::to_string(heightNr++);
-
-        glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        std::vector<std::uint16_t> shortIndices(lodIndices.begin(), lodIndices.end());
+        lod.geometry = GeometryArena::Get().AllocateIndices(m_Geometry, shortIndices.data(), shortIndices.size());
     }
+    else
+        lod.geometry = GeometryArena::Get().AllocateIndices(m_Geometry, lodIndices.data(), lodIndices.size());
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    if (!lod.geometry.IsValid())
+        return;
 
-    glActiveTexture(GL_TEXTURE0);
+    lod.indices = std::move(lodIndices);
+    m_Lods.push_back(std::move(lod));
+}
+
+void Mesh::AddPackedLod(const void *lodIndices, std::size_t indexCount, float error)
+{
+    MeshLod lod;
+    lod.error = error;
+    lod.geometry = GeometryArena::Get().AllocateIndices(m_Geometry, lodIndices, indexCount);
+    if (lod.geometry.IsValid())
+        m_Lods.push_back(std::move(lod));
+}
+
+std::size_t Mesh::GetGpuBytes() const
+{
+    const std::size_t indexSize = m_Geometry.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+    std::size_t bytes = (std::size_t)m_Geometry.vertexCount * GetVertexStride(m_Geometry.format) +
+                        (std::size_t)m_Geometry.indexCount * indexSize;
+    for (const MeshLod &lod : m_Lods)
+        bytes += (std::size_t)lod.geometry.indexCount * indexSize;
+    return bytes;
+}
+
+void Mesh::Release()
+{
+    GeometryArena &arena = GeometryArena::Get();
+    for (const MeshLod &lod : m_Lods)
+        arena.FreeIndices(lod.geometry);
+    arena.Free(m_Geometry);
+
+    m_Lods.clear();
+    m_Geometry = GeometryAllocation{};
+}
+
+void Mesh::computeBounds()
+{
+    for (const Vertex &vertex : vertices)
+        m_Bounds.Expand(vertex.Position);
+
+    if (!m_Bounds.IsValid())
+        return;
+
+    m_Sphere.center = m_Bounds.GetCenter();
+    for (const Vertex &vertex : vertices)
+        m_Sphere.radius = glm::max(m_Sphere.radius, glm::length(vertex.Position - m_Sphere.center));
 }
 
 void Mesh::setupMesh()
 {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER,
-                 vertices.size() * sizeof(Vertex),
-                 vertices.data(),
-                 GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 indices.size() * sizeof(unsigned int),
-                 indices.data(),
-                 GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (void *)offsetof(Vertex, Position));
-
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (void *)offsetof(Vertex, Normal));
-
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (void *)offsetof(Vertex, TexCoords));
-
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (void *)offsetof(Vertex, Tangent));
-
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (void *)offsetof(Vertex, Bitangent));
-
-    glEnableVertexAttribArray(5);
-    glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex),
-                           (void *)offsetof(Vertex, m_BoneIDs));
-
-    glEnableVertexAttribArray(6);
-    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (void *)offsetof(Vertex, m_Weights));
-
-    glBindVertexArray(0);
-}
\ No newline at end of file
+    VertexFormat format = ChooseVertexFormat(vertices);
+    std::vector<unsigned char> packed = PackVertices(format, vertices);
+
+    if (vertices.size() < 65536)
+    {
+        std::vector<std::uint16_t> shortIndices(indices.begin(), indices.end());
+        m_Geometry = GeometryArena::Get().Allocate(format, packed.data(), vertices.size(),
+                                                   shortIndices.data(), shortIndices.size(), GL_UNSIGNED_SHORT);
+        return;
+    }
+
+    m_Geometry = GeometryArena::Get().Allocate(format, packed.data(), vertices.size(),
+                                               indices.data(), indices.size(), GL_UNSIGNED_INT);
+}
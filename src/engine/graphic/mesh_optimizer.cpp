@@ -0,0 +1,377 @@
+#include <engine/graphic/mesh_optimizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+void VertexCacheStats::Merge(const VertexCacheStats &other)
+{
+    triangles += other.triangles;
+    vertices += other.vertices;
+    misses += other.misses;
+}
+
+void MeshOptimizationReport::Merge(const MeshOptimizationReport &other)
+{
+    before.Merge(other.before);
+    after.Merge(other.after);
+    verticesBefore += other.verticesBefore;
+    verticesAfter += other.verticesAfter;
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int> &indices, std::size_t vertexCount,
+                                                   unsigned int cacheSize)
+{
+    VertexCacheStats stats;
+    stats.triangles = indices.size() / 3;
+
+    // Timestamp FIFO: a vertex is resident while fewer than cacheSize misses happened since it was loaded
+    std::vector<std::size_t> loadedAt(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+
+    for (unsigned int index : indices)
+    {
+        if (index >= vertexCount)
+            continue;
+
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            stats.vertices++;
+        }
+
+        if (loadedAt[index] == 0 || stats.misses - loadedAt[index] >= cacheSize)
+        {
+            stats.misses++;
+            loadedAt[index] = stats.misses;
+        }
+    }
+
+    return stats;
+}
+
+namespace
+{
+    struct VertexHash
+    {
+        const std::vector<Vertex> *vertices;
+
+        std::size_t operator()(unsigned int index) const
+        {
+            // FNV-1a over the raw vertex bytes; Vertex has no padding
+            const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&(*vertices)[index]);
+            std::uint64_t hash = 14695981039346656037ull;
+            for (std::size_t i = 0; i < sizeof(Vertex); i++)
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            return (std::size_t)hash;
+        }
+    };
+
+    struct VertexEqual
+    {
+        const std::vector<Vertex> *vertices;
+
+        bool operator()(unsigned int a, unsigned int b) const
+        {
+            return std::memcmp(&(*vertices)[a], &(*vertices)[b], sizeof(Vertex)) == 0;
+        }
+    };
+
+    // Forsyth scoring, see "Linear-Speed Vertex Cache Optimisation"
+    constexpr int FORSYTH_CACHE_SIZE = 32;
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+    float ScoreVertex(int cachePosition, unsigned int remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+                score = LAST_TRIANGLE_SCORE;
+            else
+            {
+                const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+
+        score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+        return score;
+    }
+}
+
+static_assert(sizeof(Vertex) == 88, "Vertex must not contain padding for bytewise deduplication");
+
+void MeshOptimizer::DeduplicateVertices(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    std::unordered_map<unsigned int, unsigned int, VertexHash, VertexEqual> unique(
+        vertices.size(), VertexHash{&vertices}, VertexEqual{&vertices});
+
+    std::vector<unsigned int> remap(vertices.size());
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+
+    for (unsigned int i = 0; i < vertices.size(); i++)
+    {
+        auto [it, inserted] = unique.try_emplace(i, (unsigned int)result.size());
+        if (inserted)
+            result.push_back(vertices[i]);
+        remap[i] = it->second;
+    }
+
+    for (unsigned int &index : indices)
+        index = remap[index];
+
+    vertices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int> &indices, std::size_t vertexCount)
+{
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Vertex -> triangle adjacency in CSR layout
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int index : indices)
+        remaining[index]++;
+
+    std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; v++)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (std::size_t t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+
+    std::vector<float> vertexScore(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; v++)
+        vertexScore[v] = ScoreVertex(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (std::size_t t = 0; t < triangleCount; t++)
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    std::size_t scanCursor = 0;
+    long best = 0;
+    for (std::size_t t = 1; t < triangleCount; t++)
+        if (triangleScore[t] > triangleScore[best])
+            best = (long)t;
+
+    while (best >= 0)
+    {
+        emitted[best] = true;
+        const unsigned int *tri = &indices[best * 3];
+
+        nextCache.clear();
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = tri[k];
+            result.push_back(v);
+            if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+                nextCache.push_back(v);
+
+            // Drop the triangle from the vertex's live adjacency list
+            unsigned int *begin = &adjacency[adjacencyOffset[v]];
+            unsigned int *end = begin + remaining[v];
+            *std::find(begin, end, (unsigned int)best) = *(end - 1);
+            remaining[v]--;
+        }
+
+        for (unsigned int v : cache)
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                nextCache.push_back(v);
+        std::swap(cache, nextCache);
+
+        // Vertices pushed out of the cache lose their position bonus
+        for (std::size_t i = FORSYTH_CACHE_SIZE; i < cache.size(); i++)
+            vertexScore[cache[i]] = ScoreVertex(-1, remaining[cache[i]]);
+        if (cache.size() > (std::size_t)FORSYTH_CACHE_SIZE)
+            cache.resize(FORSYTH_CACHE_SIZE);
+
+        for (std::size_t i = 0; i < cache.size(); i++)
+            vertexScore[cache[i]] = ScoreVertex((int)i, remaining[cache[i]]);
+
+        // Only triangles touching the cache can have changed score
+        best = -1;
+        float bestScore = -1.0f;
+        for (unsigned int v : cache)
+        {
+            for (unsigned int a = adjacencyOffset[v]; a < adjacencyOffset[v] + remaining[v]; a++)
+            {
+                unsigned int t = adjacency[a];
+                const unsigned int *other = &indices[t * 3];
+                float score = vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+                triangleScore[t] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = (long)t;
+                }
+            }
+        }
+
+        // Cache ran dry: continue with the next triangle in source order
+        if (best < 0)
+        {
+            while (scanCursor < triangleCount && emitted[scanCursor])
+                scanCursor++;
+            if (scanCursor < triangleCount)
+                best = (long)scanCursor;
+        }
+    }
+
+    indices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                                     float threshold)
+{
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Per-triangle cache misses with the same FIFO model AnalyzeVertexCache uses
+    std::vector<unsigned char> triangleMisses(triangleCount, 0);
+    std::vector<std::size_t> loadedAt(vertices.size(), 0);
+    std::size_t misses = 0;
+    for (std::size_t t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (loadedAt[v] == 0 || misses - loadedAt[v] >= DEFAULT_CACHE_SIZE)
+            {
+                loadedAt[v] = ++misses;
+                triangleMisses[t]++;
+            }
+        }
+    }
+    const float meshACMR = (float)misses / triangleCount;
+
+    struct Cluster
+    {
+        std::size_t first;
+        std::size_t count;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters;
+
+    std::size_t clusterStart = 0;
+    std::size_t clusterMisses = 0;
+    for (std::size_t t = 0; t < triangleCount; t++)
+    {
+        bool hardBoundary = triangleMisses[t] == 3;
+        bool softBoundary = triangleMisses[t] >= 2 && t > clusterStart &&
+                            (float)clusterMisses / (t - clusterStart) <= meshACMR * threshold;
+        if (t > clusterStart && (hardBoundary || softBoundary))
+        {
+            clusters.push_back({clusterStart, t - clusterStart, 0.0f});
+            clusterStart = t;
+            clusterMisses = 0;
+        }
+        clusterMisses += triangleMisses[t];
+    }
+    clusters.push_back({clusterStart, triangleCount - clusterStart, 0.0f});
+
+    if (clusters.size() < 2)
+        return;
+
+    glm::vec3 meshCentroid(0.0f);
+    for (const Vertex &vertex : vertices)
+        meshCentroid += vertex.Position;
+    meshCentroid /= (float)vertices.size();
+
+    // Clusters facing away from the mesh centre are likely in front of the rest of the mesh
+    for (Cluster &cluster : clusters)
+    {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+        for (std::size_t t = cluster.first; t < cluster.first + cluster.count; t++)
+        {
+            const glm::vec3 &a = vertices[indices[t * 3]].Position;
+            const glm::vec3 &b = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3 &c = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 n = glm::cross(b - a, c - a);
+            float triangleArea = glm::length(n);
+            centroid += (a + b + c) * (triangleArea / 3.0f);
+            normal += n;
+            area += triangleArea;
+        }
+
+        float normalLength = glm::length(normal);
+        if (area <= 0.0f || normalLength <= 0.0f)
+            continue;
+        cluster.sortKey = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(),
+                     [](const Cluster &a, const Cluster &b)
+                     { return a.sortKey > b.sortKey; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (const Cluster &cluster : clusters)
+        result.insert(result.end(), indices.begin() + cluster.first * 3,
+                      indices.begin() + (cluster.first + cluster.count) * 3);
+
+    indices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const unsigned int UNUSED = 0xFFFFFFFFu;
+    std::vector<unsigned int> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+
+    for (unsigned int &index : indices)
+    {
+        if (remap[index] == UNUSED)
+        {
+            remap[index] = (unsigned int)result.size();
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(result);
+}
+
+MeshOptimizationReport MeshOptimizer::Optimize(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    MeshOptimizationReport report;
+    report.verticesBefore = vertices.size();
+    report.before = AnalyzeVertexCache(indices, vertices.size());
+
+    indices.resize(indices.size() / 3 * 3);
+
+    DeduplicateVertices(vertices, indices);
+    OptimizeVertexCache(indices, vertices.size());
+    OptimizeOverdraw(indices, vertices);
+    OptimizeVertexFetch(vertices, indices);
+
+    report.verticesAfter = vertices.size();
+    report.after = AnalyzeVertexCache(indices, vertices.size());
+    return report;
+}
@@ -0,0 +1,319 @@
+#include <engine/graphic/mesh_simplifier.h>
+#include <engine/graphic/mesh_optimizer.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    // Symmetric 4x4 matrix accumulating weighted squared distances to a set of planes
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+        double weight = 0;
+
+        static Quadric FromPlane(const glm::dvec3 &normal, double distance, double weight)
+        {
+            Quadric q;
+            q.a00 = weight * normal.x * normal.x;
+            q.a01 = weight * normal.x * normal.y;
+            q.a02 = weight * normal.x * normal.z;
+            q.a03 = weight * normal.x * distance;
+            q.a11 = weight * normal.y * normal.y;
+            q.a12 = weight * normal.y * normal.z;
+            q.a13 = weight * normal.y * distance;
+            q.a22 = weight * normal.z * normal.z;
+            q.a23 = weight * normal.z * distance;
+            q.a33 = weight * distance * distance;
+            q.weight = weight;
+            return q;
+        }
+
+        Quadric &operator+=(const Quadric &o)
+        {
+            a00 += o.a00, a01 += o.a01, a02 += o.a02, a03 += o.a03;
+            a11 += o.a11, a12 += o.a12, a13 += o.a13;
+            a22 += o.a22, a23 += o.a23;
+            a33 += o.a33;
+            weight += o.weight;
+            return *this;
+        }
+
+        double Evaluate(const glm::vec3 &p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+                           a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+                           a22 * z * z + 2 * a23 * z + a33;
+            // Weighted mean squared distance, so the cost is in squared model units
+            return error > 0.0 && weight > 0.0 ? error / weight : 0.0;
+        }
+    };
+
+    struct Collapse
+    {
+        unsigned int from;
+        unsigned int to;
+        double cost;
+    };
+
+    struct PositionHash
+    {
+        std::size_t operator()(const glm::vec3 &p) const
+        {
+            std::uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            return (std::size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+        }
+    };
+}
+
+std::vector<unsigned int> MeshSimplifier::Simplify(const std::vector<Vertex> &vertices,
+                                                   const std::vector<unsigned int> &indices,
+                                                   std::size_t targetIndexCount, float maxError, float *error)
+{
+    std::vector<unsigned int> result = indices;
+    if (error)
+        *error = 0.0f;
+
+    const std::size_t vertexCount = vertices.size();
+    if (result.size() <= targetIndexCount || vertexCount == 0)
+        return result;
+
+    // Vertices sharing a position (UV or normal seams) are tracked through their first occurrence
+    std::vector<unsigned int> positionOf(vertexCount);
+    std::vector<unsigned int> wedgeCount(vertexCount, 0);
+    {
+        std::unordered_map<glm::vec3, unsigned int, PositionHash> first;
+        first.reserve(vertexCount);
+        for (unsigned int i = 0; i < vertexCount; i++)
+        {
+            positionOf[i] = first.emplace(vertices[i].Position, i).first->second;
+            wedgeCount[positionOf[i]]++;
+        }
+    }
+
+    // Edges used by exactly two triangles are interior; anything else is a border or non-manifold
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<std::uint64_t, unsigned int> edgeUses;
+        edgeUses.reserve(result.size());
+        for (std::size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int e = 0; e < 3; e++)
+            {
+                std::uint64_t a = positionOf[result[i + e]];
+                std::uint64_t b = positionOf[result[i + (e + 1) % 3]];
+                edgeUses[a < b ? (a << 32 | b) : (b << 32 | a)]++;
+            }
+        }
+
+        for (const auto &[edge, uses] : edgeUses)
+        {
+            if (uses != 2)
+            {
+                locked[edge >> 32] = true;
+                locked[edge & 0xFFFFFFFFu] = true;
+            }
+        }
+
+        for (unsigned int i = 0; i < vertexCount; i++)
+            locked[i] = locked[positionOf[i]] || wedgeCount[positionOf[i]] > 1;
+    }
+
+    glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+    for (unsigned int index : result)
+    {
+        minimum = glm::min(minimum, vertices[index].Position);
+        maximum = glm::max(maximum, vertices[index].Position);
+    }
+    const double radius = 0.5 * glm::length(glm::dvec3(maximum - minimum));
+    const double errorLimit = (double)maxError * radius * ((double)maxError * radius);
+
+    // Area weighted plane quadrics, accumulated per position
+    std::vector<Quadric> quadrics(vertexCount);
+    for (std::size_t i = 0; i < result.size(); i += 3)
+    {
+        glm::dvec3 p0 = vertices[result[i]].Position;
+        glm::dvec3 p1 = vertices[result[i + 1]].Position;
+        glm::dvec3 p2 = vertices[result[i + 2]].Position;
+
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double length = glm::length(normal);
+        if (length <= 0.0)
+            continue;
+
+        normal /= length;
+        Quadric q = Quadric::FromPlane(normal, -glm::dot(normal, p0), length * 0.5);
+        for (int k = 0; k < 3; k++)
+            quadrics[positionOf[result[i + k]]] += q;
+    }
+
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1);
+    std::vector<unsigned int> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<bool> busy(vertexCount);
+    double largestError = 0.0;
+
+    while (result.size() > targetIndexCount)
+    {
+        const std::size_t triangleCount = result.size() / 3;
+
+        // Vertex to triangle adjacency for the flip test
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+        for (unsigned int index : result)
+            adjacencyOffsets[index + 1]++;
+        for (std::size_t i = 0; i < vertexCount; i++)
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        adjacency.resize(result.size());
+        {
+            std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (std::size_t i = 0; i < result.size(); i++)
+                adjacency[fill[result[i]]++] = (unsigned int)(i / 3);
+        }
+
+        // Every directed edge of a manifold mesh appears once in winding order, so each candidate is seen once
+        collapses.clear();
+        for (std::size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int e = 0; e < 3; e++)
+            {
+                unsigned int from = result[i + e];
+                unsigned int to = result[i + (e + 1) % 3];
+                if (locked[from] || positionOf[from] == positionOf[to])
+                    continue;
+
+                Quadric q = quadrics[positionOf[from]];
+                q += quadrics[positionOf[to]];
+                collapses.push_back({from, to, q.Evaluate(vertices[to].Position)});
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b)
+                  { return a.cost < b.cost; });
+
+        for (unsigned int i = 0; i < vertexCount; i++)
+            remap[i] = i;
+        std::fill(busy.begin(), busy.end(), false);
+
+        const std::size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+        std::size_t removed = 0;
+        std::size_t applied = 0;
+
+        for (const Collapse &collapse : collapses)
+        {
+            if (collapse.cost > errorLimit || removed >= std::max<std::size_t>(trianglesToRemove, 1))
+                break;
+            if (busy[collapse.from] || busy[collapse.to])
+                continue;
+
+            // Reject collapses that fold a surrounding triangle over or turn it by more than ~75 degrees;
+            // the margin keeps several passes of small turns from adding up to a flip
+            const glm::vec3 &target = vertices[collapse.to].Position;
+            bool flips = false;
+            std::size_t collapsedTriangles = 0;
+            for (unsigned int t = adjacencyOffsets[collapse.from]; t < adjacencyOffsets[collapse.from + 1]; t++)
+            {
+                const unsigned int *tri = &result[adjacency[t] * 3];
+                bool containsTarget = false;
+                for (int k = 0; k < 3; k++)
+                    containsTarget |= positionOf[tri[k]] == positionOf[collapse.to];
+                if (containsTarget)
+                {
+                    collapsedTriangles++;
+                    continue;
+                }
+
+                int corner = tri[0] == collapse.from ? 0 : tri[1] == collapse.from ? 1 : 2;
+                const glm::vec3 &p0 = vertices[tri[corner]].Position;
+                const glm::vec3 &p1 = vertices[tri[(corner + 1) % 3]].Position;
+                const glm::vec3 &p2 = vertices[tri[(corner + 2) % 3]].Position;
+
+                glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+                glm::vec3 after = glm::cross(p1 - target, p2 - target);
+                if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+                {
+                    flips = true;
+                    break;
+                }
+            }
+            if (flips)
+                continue;
+
+            // The one-ring moves with this collapse, so nothing touching it may collapse in the same pass
+            for (unsigned int t = adjacencyOffsets[collapse.from]; t < adjacencyOffsets[collapse.from + 1]; t++)
+            {
+                const unsigned int *tri = &result[adjacency[t] * 3];
+                busy[tri[0]] = busy[tri[1]] = busy[tri[2]] = true;
+            }
+            busy[collapse.to] = true;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[positionOf[collapse.to]] += quadrics[positionOf[collapse.from]];
+            largestError = std::max(largestError, collapse.cost);
+            removed += collapsedTriangles;
+            applied++;
+        }
+
+        if (applied == 0)
+            break;
+
+        std::size_t write = 0;
+        for (std::size_t i = 0; i < triangleCount * 3; i += 3)
+        {
+            unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c])
+                continue;
+
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (error)
+        *error = radius > 0.0 ? (float)(std::sqrt(largestError) / radius) : 0.0f;
+    return result;
+}
+
+std::vector<MeshLodLevel> MeshSimplifier::GenerateLods(const std::vector<Vertex> &vertices,
+                                                       const std::vector<unsigned int> &indices,
+                                                       const MeshLodSettings &settings)
+{
+    std::vector<MeshLodLevel> levels;
+    levels.reserve(settings.ratios.size());
+    const std::vector<unsigned int> *previous = &indices;
+    float previousError = 0.0f;
+
+    for (float ratio : settings.ratios)
+    {
+        std::size_t target = (std::size_t)(indices.size() / 3 * ratio) * 3;
+        if (target < 3 || target >= previous->size())
+            break;
+
+        float error = 0.0f;
+        std::vector<unsigned int> simplified = Simplify(vertices, *previous, target, settings.maxError, &error);
+
+        // A level that barely differs from the previous one only costs memory
+        if (simplified.size() < 3 || simplified.size() * 10 > previous->size() * 9)
+            break;
+
+        MeshOptimizer::OptimizeVertexCache(simplified, vertices.size());
+
+        // Each level is simplified from the previous one, so the errors add up
+        previousError += error;
+        levels.push_back({std::move(simplified), previousError});
+        previous = &levels.back().indices;
+    }
+
+    return levels;
+}
@@ -1,7 +1,11 @@
 #include <engine/graphic/model.h>
+#include <engine/graphic/animation.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/texture_cache.h>
+#include <engine/graphic/texture_cooker.h>
+#include <engine/core/job_system.h>
 
 #include <glm/gtc/matrix_transform.hpp>
-#include <stb_image.h>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 
@@ -9,50 +13,447 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_set>
 #include <vector>
 
 #include <engine/utils/assimp_glm_helpers.h>
 
-Model::Model(std::string const &path, bool gamma) : gammaCorrection(gamma)
+Model::Model(std::string const &path, bool gamma, const MeshLodSettings &lodSettings)
+    : gammaCorrection(gamma)
 {
-    loadModel(path);
+    ModelData data;
+    if (!Import(path, lodSettings, data))
+    {
+        directory = data.directory;
+        return;
+    }
+
+    directory = data.directory;
+    m_BoneInfoMap = data.boneInfoMap;
+    m_BoneCounter = data.boneCounter;
+    meshes.reserve(data.meshes.size());
+
+    std::size_t bytes = 0;
+    while (!UploadStep(data, bytes))
+        ;
+}
+
+Model::Model(const ModelData &data, bool gamma)
+    : directory(data.directory), gammaCorrection(gamma), m_BoneInfoMap(data.boneInfoMap), m_BoneCounter(data.boneCounter)
+{
+    meshes.reserve(data.meshes.size());
 }
 
-void Model::Draw(Shader &shader)
+Model::~Model()
+{
+    for (Mesh &mesh : meshes)
+        mesh.Release();
+
+    for (MaterialHandle material : m_Materials)
+        MaterialLibrary::Get().Release(material);
+
+    for (TextureKey key : m_TextureKeys)
+        TextureCache::Get().Release(key);
+}
+
+std::size_t Model::GetGpuBytes() const
+{
+    std::size_t bytes = 0;
+    for (const Mesh &mesh : meshes)
+        bytes += mesh.GetGpuBytes();
+    return bytes;
+}
+
+void Model::Draw()
 {
     for (unsigned int i = 0; i < meshes.size(); i++)
-        meshes[i].Draw(shader);
+        meshes[i].Draw();
+}
+
+void Model::DrawInstanced(const InstanceBuffer &instances, GLuint firstInstance, GLsizei count)
+{
+    for (unsigned int i = 0; i < meshes.size(); i++)
+        meshes[i].DrawInstanced(instances, firstInstance, count);
 }
 
 std::map<std::string, BoneInfo> &Model::GetBoneInfoMap() { return m_BoneInfoMap; }
 int &Model::GetBoneCount() { return m_BoneCounter; }
 
-void Model::loadModel(std::string const &path)
+bool Model::Import(std::string const &path, const MeshLodSettings &lodSettings, ModelData &data)
 {
+    data.path = path;
+    data.directory = path.substr(0, path.find_last_of('/'));
+
+    std::uint64_t hash = AssetCooker::HashFile(path);
+    std::uint64_t settingsHash = getCookSettingsHash(lodSettings);
+    std::string cookedPath = AssetCooker::GetCookedPath(hash, settingsHash, ".model");
+    if (hash && loadCooked(cookedPath, hash, settingsHash, data))
+    {
+        std::cout << "[Model] " << path << ": loaded cooked " << cookedPath << std::endl;
+        decodeImages(data);
+        return true;
+    }
+
     Assimp::Importer importer;
     const aiScene *scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
         std::cout << "[Model] ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
-        return;
+        return false;
+    }
+
+    std::vector<const aiMesh *> sceneMeshes;
+    processNode(scene->mRootNode, scene, sceneMeshes);
+
+    // Bone ids and materials are numbered in node order here, so the meshes themselves can be
+    // converted in parallel below and still come out the same on every import
+    std::vector<std::uint32_t> materialIndices(scene->mNumMaterials, UINT32_MAX);
+    std::unordered_map<std::string, std::string> seenTextures;
+    data.meshes.resize(sceneMeshes.size());
+    for (std::size_t i = 0; i < sceneMeshes.size(); i++)
+    {
+        const aiMesh *mesh = sceneMeshes[i];
+        for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
+        {
+            std::string boneName = mesh->mBones[boneIndex]->mName.C_Str();
+            if (data.boneInfoMap.find(boneName) != data.boneInfoMap.end())
+                continue;
+
+            BoneInfo newBoneInfo;
+            newBoneInfo.id = data.boneCounter++;
+            newBoneInfo.offset = AssimpGLMHelpers::ConvertMatrixToGLMFormat(mesh->mBones[boneIndex]->mOffsetMatrix);
+            data.boneInfoMap[boneName] = newBoneInfo;
+        }
+
+        std::uint32_t &material = materialIndices[mesh->mMaterialIndex];
+        if (material == UINT32_MAX)
+        {
+            material = (std::uint32_t)data.materials.size();
+            ModelData::MaterialData &result = data.materials.emplace_back();
+            const aiMaterial *source = scene->mMaterials[mesh->mMaterialIndex];
+            loadMaterialTextures(source, aiTextureType_DIFFUSE, "texture_diffuse", result.textures, seenTextures);
+            loadMaterialTextures(source, aiTextureType_SPECULAR, "texture_specular", result.textures, seenTextures);
+            loadMaterialTextures(source, aiTextureType_HEIGHT, "texture_normal", result.textures, seenTextures);
+            loadMaterialTextures(source, aiTextureType_AMBIENT, "texture_height", result.textures, seenTextures);
+            result.params = loadMaterialParams(source, result.textures);
+        }
+        data.meshes[i].material = material;
+    }
+
+    std::vector<MeshOptimizationReport> reports(sceneMeshes.size());
+    JobSystem::Get().ParallelFor(sceneMeshes.size(), 1, [&](std::size_t begin, std::size_t end)
+                                 {
+        for (std::size_t i = begin; i < end; i++)
+            processMesh(sceneMeshes[i], data.boneInfoMap, lodSettings, data.meshes[i], reports[i]); });
+
+    MeshOptimizationReport report;
+    for (const MeshOptimizationReport &meshReport : reports)
+        report.Merge(meshReport);
+
+    std::cout << "[Model] " << path << ": " << report.before.triangles << " triangles, vertices "
+              << report.verticesBefore << " -> " << report.verticesAfter << ", ACMR " << report.before.GetACMR()
+              << " -> " << report.after.GetACMR() << ", ATVR " << report.before.GetATVR() << " -> "
+              << report.after.GetATVR() << std::endl;
+
+    if (hash)
+    {
+        cookModel(cookedPath, hash, settingsHash, data);
+
+        // Skinned models usually carry their clip, so Animation can load it without importing the file again
+        CookedWriter animation;
+        if (Animation::Cook(scene, hash, animation))
+            animation.Save(Animation::GetCookedPath(hash));
+    }
+
+    decodeImages(data);
+    return true;
+}
+
+// Textures another model already uploaded are only keyed, not read
+void Model::decodeImages(ModelData &data)
+{
+    std::unordered_set<std::string> paths;
+    for (const ModelData::MaterialData &material : data.materials)
+    {
+        for (const Texture &texture : material.textures)
+        {
+            if (!paths.insert(texture.path).second)
+                continue;
+
+            ModelData::Image &image = data.images.emplace_back();
+            image.path = texture.path;
+            image.type = texture.type;
+        }
+    }
+
+    JobSystem::Get().ParallelFor(data.images.size(), 1, [&data](std::size_t begin, std::size_t end)
+                                 {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            ModelData::Image &image = data.images[i];
+            const std::string path = data.directory + '/' + image.path;
+            const TextureUsage usage = TextureCooker::GetUsage(image.type);
+            image.key = TextureCache::MakeKey(path, usage, false);
+            if (!TextureCache::Get().Contains(image.key))
+                image.data = TextureCooker::Load(path, usage);
+        } });
+}
+
+bool Model::UploadStep(ModelData &data, std::size_t &bytes)
+{
+    if (m_UploadCursor < data.images.size())
+    {
+        ModelData::Image &image = data.images[m_UploadCursor++];
+
+        CachedTexture texture = TextureCache::Get().Acquire(image.key, data.directory + '/' + image.path,
+                                                            TextureCooker::GetUsage(image.type), false, &image.data, true);
+        image.id = texture.id;
+        m_TextureKeys.push_back(image.key);
+
+        bytes += image.data.GetSize();
+        image.data = ImageData{};
+        return false;
+    }
+
+    std::size_t meshIndex = m_UploadCursor - data.images.size();
+    if (meshIndex == 0)
+    {
+        std::unordered_map<std::string, GLuint> ids;
+        for (const ModelData::Image &image : data.images)
+            ids.emplace(image.path, image.id);
+
+        for (ModelData::MaterialData &source : data.materials)
+        {
+            for (Texture &texture : source.textures)
+                texture.id = ids[texture.path];
+
+            Material material = materialFromTextures(source.textures);
+            material.params = source.params;
+            m_Materials.push_back(MaterialLibrary::Get().Create(material));
+        }
     }
 
-    directory = path.substr(0, path.find_last_of('/'));
-    processNode(scene->mRootNode, scene);
+    if (meshIndex < data.meshes.size())
+    {
+        const ModelData::MeshData &source = data.meshes[meshIndex];
+        Mesh &mesh = meshes.emplace_back(source.format, source.vertices, source.vertexCount, source.indices,
+                                         source.indexCount, source.indexType, m_Materials[source.material],
+                                         source.bounds, source.sphere);
+        for (const ModelData::Lod &lod : source.lods)
+            mesh.AddPackedLod(lod.indices, lod.indexCount, lod.error);
+
+        bytes += mesh.GetGpuBytes();
+        m_UploadCursor++;
+        if (meshIndex + 1 < data.meshes.size())
+            return false;
+    }
+
+    finishLoading(data.path);
+    return true;
+}
+
+void Model::finishLoading(std::string const &path)
+{
+    for (const Mesh &mesh : meshes)
+    {
+        m_Bounds.Merge(mesh.GetBounds());
+
+        if (mesh.GetLodCount() > m_LodErrors.size())
+            m_LodErrors.resize(mesh.GetLodCount(), 0.0f);
+    }
+
+    for (std::size_t lod = 1; lod < m_LodErrors.size(); lod++)
+    {
+        for (const Mesh &mesh : meshes)
+            m_LodErrors[lod] = glm::max(m_LodErrors[lod], mesh.GetLodError(lod));
+    }
+
+    if (m_LodErrors.size() > 1)
+    {
+        std::cout << "[Model] " << path << ": " << m_LodErrors.size() - 1 << " LOD levels, error";
+        for (std::size_t lod = 1; lod < m_LodErrors.size(); lod++)
+            std::cout << " " << m_LodErrors[lod];
+        std::cout << std::endl;
+    }
+
+    if (m_Bounds.IsValid())
+    {
+        m_Sphere.center = m_Bounds.GetCenter();
+        for (const Mesh &mesh : meshes)
+        {
+            const BoundingSphere &sphere = mesh.GetBoundingSphere();
+            m_Sphere.radius = glm::max(m_Sphere.radius, glm::length(sphere.center - m_Sphere.center) + sphere.radius);
+        }
+    }
+}
+
+std::uint64_t Model::getCookSettingsHash(const MeshLodSettings &lodSettings)
+{
+    std::uint64_t hash = AssetCooker::HashBytes(&COOKED_REVISION, sizeof(COOKED_REVISION));
+    hash = AssetCooker::HashBytes(lodSettings.ratios.data(), lodSettings.ratios.size() * sizeof(float), hash);
+    return AssetCooker::HashBytes(&lodSettings.maxError, sizeof(float), hash);
 }
 
-void Model::processNode(aiNode *node, const aiScene *scene)
+// Layout after the header: materials (params, textures), bones, then meshes. Each mesh's vertices,
+// indices and LOD indices are stored in the exact format the geometry arena holds them in.
+void Model::cookModel(std::string const &cookedPath, std::uint64_t sourceHash, std::uint64_t settingsHash,
+                      const ModelData &data)
+{
+    CookedWriter writer;
+    AssetCooker::WriteHeader(writer, COOKED_MAGIC, sourceHash, settingsHash);
+
+    writer.Write((std::uint32_t)data.materials.size());
+    for (const ModelData::MaterialData &material : data.materials)
+    {
+        writer.Write(material.params);
+        writer.Write((std::uint32_t)material.textures.size());
+        for (const Texture &texture : material.textures)
+        {
+            writer.WriteString(texture.type);
+            writer.WriteString(texture.path);
+        }
+    }
+
+    writer.Write((std::int32_t)data.boneCounter);
+    writer.Write((std::uint32_t)data.boneInfoMap.size());
+    for (const auto &[name, info] : data.boneInfoMap)
+    {
+        writer.WriteString(name);
+        writer.Write((std::int32_t)info.id);
+        writer.Write(info.offset);
+    }
+
+    writer.Write((std::uint32_t)data.meshes.size());
+    for (const ModelData::MeshData &mesh : data.meshes)
+    {
+        const std::size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+
+        writer.Write(mesh.material);
+        writer.Write((std::uint32_t)mesh.format);
+        writer.Write((std::uint32_t)mesh.indexType);
+        writer.Write(mesh.vertexCount);
+        writer.Write(mesh.indexCount);
+        writer.Write((std::uint32_t)mesh.lods.size());
+        writer.Write(mesh.bounds.min);
+        writer.Write(mesh.bounds.max);
+        writer.Write(mesh.sphere.center);
+        writer.Write(mesh.sphere.radius);
+
+        writer.WriteArray(mesh.vertices, (std::size_t)mesh.vertexCount * GetVertexStride(mesh.format));
+        writer.WriteArray(mesh.indices, (std::size_t)mesh.indexCount * indexSize);
+
+        for (const ModelData::Lod &lod : mesh.lods)
+        {
+            writer.Write(lod.indexCount);
+            writer.Write(lod.error);
+            writer.WriteArray(lod.indices, (std::size_t)lod.indexCount * indexSize);
+        }
+    }
+
+    if (writer.Save(cookedPath))
+        std::cout << "[Model] Cooked " << cookedPath << " (" << writer.GetData().size() << " bytes)" << std::endl;
+}
+
+// The meshes point straight into the mapped file, which data keeps open until it is uploaded
+bool Model::loadCooked(std::string const &cookedPath, std::uint64_t sourceHash, std::uint64_t settingsHash,
+                       ModelData &data)
+{
+    MappedFile file;
+    CookedReader reader;
+    if (!AssetCooker::Open(cookedPath, COOKED_MAGIC, sourceHash, settingsHash, file, reader))
+        return false;
+
+    std::vector<ModelData::MaterialData> materials;
+    std::uint32_t materialCount = reader.Read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < materialCount && reader.IsValid(); i++)
+    {
+        ModelData::MaterialData &material = materials.emplace_back();
+        material.params = reader.Read<MaterialParams>();
+
+        std::uint32_t textureCount = reader.Read<std::uint32_t>();
+        for (std::uint32_t t = 0; t < textureCount && reader.IsValid(); t++)
+        {
+            Texture &texture = material.textures.emplace_back();
+            texture.id = 0;
+            texture.type = reader.ReadString();
+            texture.path = reader.ReadString();
+        }
+    }
+
+    std::map<std::string, BoneInfo> boneInfoMap;
+    std::int32_t boneCounter = reader.Read<std::int32_t>();
+    std::uint32_t boneCount = reader.Read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < boneCount && reader.IsValid(); i++)
+    {
+        std::string name = reader.ReadString();
+        BoneInfo info;
+        info.id = reader.Read<std::int32_t>();
+        info.offset = reader.Read<glm::mat4>();
+        boneInfoMap[name] = info;
+    }
+
+    std::vector<ModelData::MeshData> meshes;
+    std::uint32_t meshCount = reader.Read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < meshCount && reader.IsValid(); i++)
+    {
+        ModelData::MeshData &mesh = meshes.emplace_back();
+        mesh.material = reader.Read<std::uint32_t>();
+        std::uint32_t format = reader.Read<std::uint32_t>();
+        mesh.indexType = reader.Read<std::uint32_t>();
+        mesh.vertexCount = reader.Read<std::uint32_t>();
+        mesh.indexCount = reader.Read<std::uint32_t>();
+        std::uint32_t lodCount = reader.Read<std::uint32_t>();
+        mesh.bounds.min = reader.Read<glm::vec3>();
+        mesh.bounds.max = reader.Read<glm::vec3>();
+        mesh.sphere.center = reader.Read<glm::vec3>();
+        mesh.sphere.radius = reader.Read<float>();
+
+        if (format >= VERTEX_FORMAT_COUNT || mesh.material >= materials.size() ||
+            (mesh.indexType != GL_UNSIGNED_SHORT && mesh.indexType != GL_UNSIGNED_INT))
+        {
+            std::cout << "[Model] " << cookedPath << " is damaged, importing again" << std::endl;
+            return false;
+        }
+        mesh.format = (VertexFormat)format;
+
+        const std::size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+        mesh.vertices = reader.ReadArray((std::size_t)mesh.vertexCount * GetVertexStride(mesh.format));
+        mesh.indices = reader.ReadArray((std::size_t)mesh.indexCount * indexSize);
+
+        for (std::uint32_t l = 0; l < lodCount && reader.IsValid(); l++)
+        {
+            ModelData::Lod &lod = mesh.lods.emplace_back();
+            lod.indexCount = reader.Read<std::uint32_t>();
+            lod.error = reader.Read<float>();
+            lod.indices = reader.ReadArray((std::size_t)lod.indexCount * indexSize);
+        }
+    }
+
+    if (!reader.IsValid())
+    {
+        std::cout << "[Model] " << cookedPath << " is truncated, importing again" << std::endl;
+        return false;
+    }
+
+    data.materials = std::move(materials);
+    data.boneInfoMap = std::move(boneInfoMap);
+    data.boneCounter = boneCounter;
+    data.meshes = std::move(meshes);
+    data.cooked = std::move(file);
+    return true;
+}
+
+void Model::processNode(const aiNode *node, const aiScene *scene, std::vector<const aiMesh *> &sceneMeshes)
 {
     for (unsigned int i = 0; i < node->mNumMeshes; i++)
     {
-        aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
     }
 
     for (unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, sceneMeshes);
     }
 }
 
@@ -65,11 +466,13 @@ void Model::SetVertexBoneDataToDefault(Vertex &vertex)
     }
 }
 
-Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
+// Runs on a worker per mesh; everything shared is only read
+void Model::processMesh(const aiMesh *mesh, const std::map<std::string, BoneInfo> &boneInfoMap,
+                        const MeshLodSettings &lodSettings, ModelData::MeshData &result,
+                        MeshOptimizationReport &report)
 {
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
 
     for (unsigned int i = 0; i < mesh->mNumVertices; i++)
     {
@@ -104,20 +507,97 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
         for (unsigned int j = 0; j < face.mNumIndices; j++)
             indices.push_back(face.mIndices[j]);
     }
-    aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
 
-    std::vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-    textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-    std::vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-    textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-    std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-    textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-    std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-    textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+    ExtractBoneWeightForVertices(vertices, mesh, boneInfoMap);
 
-    ExtractBoneWeightForVertices(vertices, mesh, scene);
+    report = MeshOptimizer::Optimize(vertices, indices);
+    std::vector<MeshLodLevel> lods = MeshSimplifier::GenerateLods(vertices, indices, lodSettings);
 
-    return Mesh(vertices, indices, textures);
+    for (const Vertex &vertex : vertices)
+        result.bounds.Expand(vertex.Position);
+    if (result.bounds.IsValid())
+    {
+        result.sphere.center = result.bounds.GetCenter();
+        for (const Vertex &vertex : vertices)
+            result.sphere.radius = glm::max(result.sphere.radius, glm::length(vertex.Position - result.sphere.center));
+    }
+
+    // Same layout Mesh picks for raw vertices: the narrowest vertex format, 16-bit indices when they fit
+    result.format = ChooseVertexFormat(vertices);
+    result.indexType = vertices.size() < 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    result.vertexCount = (std::uint32_t)vertices.size();
+    result.indexCount = (std::uint32_t)indices.size();
+
+    std::vector<unsigned char> &storage = result.storage;
+    auto append = [&storage, &result](const std::vector<unsigned int> &source)
+    {
+        storage.resize((storage.size() + 3) & ~(std::size_t)3);
+        std::size_t offset = storage.size();
+        if (result.indexType == GL_UNSIGNED_SHORT)
+        {
+            std::vector<std::uint16_t> shortIndices(source.begin(), source.end());
+            storage.insert(storage.end(), (const unsigned char *)shortIndices.data(),
+                           (const unsigned char *)(shortIndices.data() + shortIndices.size()));
+        }
+        else
+            storage.insert(storage.end(), (const unsigned char *)source.data(),
+                           (const unsigned char *)(source.data() + source.size()));
+        return offset;
+    };
+
+    storage = PackVertices(result.format, vertices);
+    std::size_t indexOffset = append(indices);
+    std::vector<std::size_t> lodOffsets;
+    // The simplifier measures error relative to half the bounds' diagonal, not the sphere radius
+    const float lodScale = glm::length(result.bounds.GetExtents());
+    for (const MeshLodLevel &lod : lods)
+    {
+        lodOffsets.push_back(append(lod.indices));
+        result.lods.push_back({nullptr, (std::uint32_t)lod.indices.size(), lod.error * lodScale});
+    }
+
+    result.vertices = storage.data();
+    result.indices = storage.data() + indexOffset;
+    for (std::size_t i = 0; i < result.lods.size(); i++)
+        result.lods[i].indices = storage.data() + lodOffsets[i];
+}
+
+MaterialParams Model::loadMaterialParams(const aiMaterial *material, const std::vector<Texture> &textures)
+{
+    MaterialParams params;
+
+    bool hasDiffuse = std::any_of(textures.begin(), textures.end(), [](const Texture &texture)
+                                  { return texture.type == "texture_diffuse"; });
+    aiColor4D color;
+    if (!hasDiffuse && material->Get(AI_MATKEY_COLOR_DIFFUSE, color) == AI_SUCCESS)
+        params.baseColor = glm::vec4(color.r, color.g, color.b, 1.0f);
+
+    float opacity = 1.0f;
+    if (material->Get(AI_MATKEY_OPACITY, opacity) == AI_SUCCESS)
+        params.baseColor.a = opacity;
+
+    float shininess = 0.0f;
+    if (material->Get(AI_MATKEY_SHININESS, shininess) == AI_SUCCESS && shininess > 0.0f)
+        params.specular.a = shininess;
+
+    return params;
+}
+
+Material Model::materialFromTextures(const std::vector<Texture> &textures)
+{
+    Material result;
+    for (auto it = textures.rbegin(); it != textures.rend(); ++it)
+    {
+        if (it->type == "texture_diffuse")
+            result.SetTexture(TextureSlot::Diffuse, it->id);
+        else if (it->type == "texture_specular")
+            result.SetTexture(TextureSlot::Specular, it->id);
+        else if (it->type == "texture_normal")
+            result.SetTexture(TextureSlot::Normal, it->id);
+        else if (it->type == "texture_height")
+            result.SetTexture(TextureSlot::Height, it->id);
+    }
+    return result;
 }
 
 void Model::SetVertexBoneData(Vertex &vertex, int boneID, float weight)
@@ -133,29 +613,16 @@ void Model::SetVertexBoneData(Vertex &vertex, int boneID, float weight)
     }
 }
 
-void Model::ExtractBoneWeightForVertices(std::vector<Vertex> &vertices, aiMesh *mesh, const aiScene *scene)
+void Model::ExtractBoneWeightForVertices(std::vector<Vertex> &vertices, const aiMesh *mesh,
+                                         const std::map<std::string, BoneInfo> &boneInfoMap)
 {
-    auto &boneInfoMap = m_BoneInfoMap;
-    int &boneCount = m_BoneCounter;
-
     for (int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
     {
-        int boneID = -1;
         std::string boneName = mesh->mBones[boneIndex]->mName.C_Str();
-        if (boneInfoMap.find(boneName) == boneInfoMap.end())
-        {
-            BoneInfo newBoneInfo;
-            newBoneInfo.id = boneCount;
-            newBoneInfo.offset = AssimpGLMHelpers::ConvertMatrixToGLMFormat(mesh->mBones[boneIndex]->mOffsetMatrix);
-            boneInfoMap[boneName] = newBoneInfo;
-            boneID = boneCount;
-            boneCount++;
-        }
-        else
-        {
-            boneID = boneInfoMap[boneName].id;
-        }
-        assert(boneID != -1);
+        auto it = boneInfoMap.find(boneName);
+        assert(it != boneInfoMap.end());
+        int boneID = it->second.id;
+
         auto weights = mesh->mBones[boneIndex]->mWeights;
         int numWeights = mesh->mBones[boneIndex]->mNumWeights;
 
@@ -169,73 +636,19 @@ void Model::ExtractBoneWeightForVertices(std::vector<Vertex> &vertices, aiMesh *
     }
 }
 
-unsigned int Model::TextureFromFile(const char *path, const std::string &directory, bool gamma)
-{
-    std::string filename = std::string(path);
-    filename = directory + '/' + filename;
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-
-std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName)
+// A path keeps the type it was first seen with, as one texture object serves every use of it
+void Model::loadMaterialTextures(const aiMaterial *mat, aiTextureType type, std::string typeName,
+                                 std::vector<Texture> &textures, std::unordered_map<std::string, std::string> &seen)
 {
-    std::vector<Texture> textures;
     for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
     {
         aiString str;
         mat->GetTexture(type, i, &str);
-        bool skip = false;
-        for (unsigned int j = 0; j < textures_loaded.size(); j++)
-        {
-            if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-            {
-                textures.push_back(textures_loaded[j]);
-                skip = true;
-                break;
-            }
-        }
-        if (!skip)
-        {
-            Texture texture;
-            texture.id = TextureFromFile(str.C_Str(), this->directory);
-            texture.type = typeName;
-            texture.path = str.C_Str();
-            textures.push_back(texture);
-            textures_loaded.push_back(texture);
-        }
-    }
 
-    return textures;
-}
\ No newline at end of file
+        Texture texture;
+        texture.id = 0;
+        texture.path = str.C_Str();
+        texture.type = seen.emplace(texture.path, typeName).first->second;
+        textures.push_back(texture);
+    }
+}
@@ -0,0 +1,398 @@
+#include <engine/graphic/occlusion_culler.h>
+#include <engine/core/job_system.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+static_assert(OcclusionCuller::WIDTH % OcclusionCuller::TILE_WIDTH == 0, "Width must be a whole number of tiles");
+static_assert(OcclusionCuller::HEIGHT % OcclusionCuller::TILE_HEIGHT == 0, "Height must be a whole number of tiles");
+static_assert(OcclusionCuller::TILE_WIDTH == 32 && OcclusionCuller::TILE_HEIGHT == 4,
+              "A tile row is one 32-bit mask and a tile is one SSE register");
+
+static constexpr int TILE_COUNT = OcclusionCuller::TILES_X * OcclusionCuller::TILES_Y;
+
+// Bits [lo, hi) of a 32 pixel tile row; empty when hi <= lo
+static std::uint32_t SpanMask(int lo, int hi)
+{
+    lo = std::clamp(lo, 0, 32);
+    hi = std::clamp(hi, 0, 32);
+    if (hi <= lo)
+        return 0u;
+
+    std::uint32_t below = hi == 32 ? ~0u : (1u << hi) - 1u;
+    std::uint32_t from = lo == 32 ? 0u : ~0u << lo;
+    return below & from;
+}
+
+OcclusionCuller::OcclusionCuller()
+    : m_Masks(TILE_COUNT * 4), m_ZMax0(TILE_COUNT), m_ZMax1(TILE_COUNT)
+{
+    Begin(glm::mat4(1.0f));
+}
+
+void OcclusionCuller::Begin(const glm::mat4 &viewProjection)
+{
+    m_ViewProjection = viewProjection;
+    m_Occluders.clear();
+
+    std::fill(m_Masks.begin(), m_Masks.end(), 0u);
+    std::fill(m_ZMax0.begin(), m_ZMax0.end(), 1.0f);
+    std::fill(m_ZMax1.begin(), m_ZMax1.end(), 0.0f);
+}
+
+void OcclusionCuller::AddOccluder(const void *positions, std::size_t stride, const void *indices, bool shortIndices,
+                                  std::size_t indexCount, const glm::mat4 &model)
+{
+    if (!positions || !indices || indexCount < 3)
+        return;
+
+    m_Occluders.push_back({static_cast<const unsigned char *>(positions), stride, indices, shortIndices, indexCount,
+                           m_ViewProjection * model});
+}
+
+void OcclusionCuller::Rasterize()
+{
+    JobSystem &jobs = JobSystem::Get();
+
+    m_Triangles.resize(m_Occluders.size());
+    jobs.ParallelFor(m_Occluders.size(), 1, [this](std::size_t begin, std::size_t end)
+                     {
+        for (std::size_t i = begin; i < end; i++)
+            SetupTriangles(m_Occluders[i], m_Triangles[i]); });
+
+    // Every tile belongs to exactly one band, so bands can be filled without locking
+    jobs.ParallelFor(TILES_Y, 4, [this](std::size_t begin, std::size_t end)
+                     {
+        for (std::size_t row = begin; row < end; row++)
+            RasterizeBand((int)row); });
+}
+
+void OcclusionCuller::SetupTriangles(const Occluder &occluder, std::vector<Triangle> &triangles) const
+{
+    triangles.clear();
+
+    auto emit = [&](const glm::vec4 &c0, const glm::vec4 &c1, const glm::vec4 &c2)
+    {
+        glm::vec3 v[3];
+        const glm::vec4 *clip[3] = {&c0, &c1, &c2};
+        for (int i = 0; i < 3; i++)
+        {
+            float invW = 1.0f / clip[i]->w;
+            v[i].x = (clip[i]->x * invW * 0.5f + 0.5f) * WIDTH;
+            v[i].y = (clip[i]->y * invW * 0.5f + 0.5f) * HEIGHT;
+            // Left unclamped: a triangle crossing the far plane must keep its true depth slope
+            v[i].z = clip[i]->z * invW * 0.5f + 0.5f;
+        }
+
+        float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+        if (std::abs(area) < 1e-6f)
+            return;
+
+        // Occluders are two sided; wind everything counter-clockwise so inside is positive
+        if (area < 0.0f)
+        {
+            std::swap(v[1], v[2]);
+            area = -area;
+        }
+
+        Triangle tri;
+        tri.minX = std::min({v[0].x, v[1].x, v[2].x});
+        tri.maxX = std::max({v[0].x, v[1].x, v[2].x});
+        tri.minY = std::min({v[0].y, v[1].y, v[2].y});
+        tri.maxY = std::max({v[0].y, v[1].y, v[2].y});
+        if (tri.maxX < 0.0f || tri.minX > WIDTH || tri.maxY < 0.0f || tri.minY > HEIGHT)
+            return;
+
+        for (int e = 0; e < 3; e++)
+        {
+            const glm::vec3 &p = v[e];
+            const glm::vec3 &q = v[(e + 1) % 3];
+            tri.a[e] = p.y - q.y;
+            tri.b[e] = q.x - p.x;
+            tri.c[e] = p.x * q.y - q.x * p.y;
+        }
+
+        float invArea = 1.0f / area;
+        tri.dzdx = ((v[1].z - v[0].z) * (v[2].y - v[0].y) - (v[2].z - v[0].z) * (v[1].y - v[0].y)) * invArea;
+        tri.dzdy = ((v[2].z - v[0].z) * (v[1].x - v[0].x) - (v[1].z - v[0].z) * (v[2].x - v[0].x)) * invArea;
+        tri.zRef = v[0].z - tri.dzdx * v[0].x - tri.dzdy * v[0].y;
+        tri.zMax = std::max({v[0].z, v[1].z, v[2].z});
+
+        triangles.push_back(tri);
+    };
+
+    const glm::mat4 &mvp = occluder.modelViewProjection;
+    for (std::size_t i = 0; i + 2 < occluder.indexCount; i += 3)
+    {
+        glm::vec4 clip[3];
+        float nearDistance[3];
+        int inside = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            std::size_t index = occluder.shortIndices ? static_cast<const std::uint16_t *>(occluder.indices)[i + k]
+                                                      : static_cast<const std::uint32_t *>(occluder.indices)[i + k];
+            const glm::vec3 &position = *reinterpret_cast<const glm::vec3 *>(occluder.positions + index * occluder.stride);
+            clip[k] = mvp * glm::vec4(position, 1.0f);
+            nearDistance[k] = clip[k].z + clip[k].w;
+            inside += nearDistance[k] >= 0.0f;
+        }
+
+        if (inside == 0)
+            continue;
+        if (inside == 3)
+        {
+            emit(clip[0], clip[1], clip[2]);
+            continue;
+        }
+
+        // Clip against the near plane; one or two vertices survive, giving a triangle or a quad
+        glm::vec4 polygon[4];
+        int count = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            int next = (k + 1) % 3;
+            if (nearDistance[k] >= 0.0f)
+                polygon[count++] = clip[k];
+            if ((nearDistance[k] >= 0.0f) != (nearDistance[next] >= 0.0f))
+            {
+                float t = nearDistance[k] / (nearDistance[k] - nearDistance[next]);
+                polygon[count++] = glm::mix(clip[k], clip[next], t);
+            }
+        }
+
+        for (int k = 1; k + 1 < count; k++)
+            emit(polygon[0], polygon[k], polygon[k + 1]);
+    }
+}
+
+void OcclusionCuller::RasterizeBand(int tileRow)
+{
+    const int y0 = tileRow * TILE_HEIGHT;
+
+    for (const std::vector<Triangle> &triangles : m_Triangles)
+    {
+        for (const Triangle &tri : triangles)
+        {
+            if (tri.maxY < y0 + 0.5f || tri.minY > y0 + TILE_HEIGHT - 0.5f)
+                continue;
+
+            // Span of covered pixel centers on each of the band's four rows
+            int start[4], end[4];
+#if OCCLUSION_USE_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 rowY = _mm_add_ps(_mm_set1_ps((float)y0), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+            __m128 lo = _mm_set1_ps(tri.minX);
+            __m128 hi = _mm_set1_ps(tri.maxX);
+
+            for (int e = 0; e < 3; e++)
+            {
+                __m128 value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.b[e]), rowY), _mm_set1_ps(tri.c[e]));
+                if (tri.a[e] > 0.0f)
+                    lo = _mm_max_ps(lo, _mm_mul_ps(value, _mm_set1_ps(-1.0f / tri.a[e])));
+                else if (tri.a[e] < 0.0f)
+                    hi = _mm_min_ps(hi, _mm_mul_ps(value, _mm_set1_ps(-1.0f / tri.a[e])));
+                else
+                {
+                    __m128 outside = _mm_cmplt_ps(value, zero);
+                    hi = _mm_or_ps(_mm_and_ps(outside, _mm_set1_ps(-1.0f)), _mm_andnot_ps(outside, hi));
+                }
+            }
+
+            // Offsetting by a positive bias makes truncation act as floor
+            const __m128 bias = _mm_set1_ps(2.0f * WIDTH);
+            __m128 first = _mm_min_ps(_mm_max_ps(_mm_sub_ps(lo, _mm_set1_ps(0.5f)), zero), _mm_set1_ps((float)WIDTH));
+            __m128 last = _mm_min_ps(_mm_max_ps(_mm_sub_ps(hi, _mm_set1_ps(0.5f)), _mm_set1_ps(-1.0f)),
+                                     _mm_set1_ps(WIDTH - 1.0f));
+            __m128i biasInt = _mm_set1_epi32(2 * WIDTH);
+            __m128i startInt = _mm_sub_epi32(biasInt, _mm_cvttps_epi32(_mm_sub_ps(bias, first)));
+            __m128i endInt = _mm_add_epi32(_mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(last, bias)), biasInt),
+                                           _mm_set1_epi32(1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(start), startInt);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(end), endInt);
+#else
+            for (int row = 0; row < TILE_HEIGHT; row++)
+            {
+                float y = y0 + row + 0.5f;
+                float lo = tri.minX, hi = tri.maxX;
+                for (int e = 0; e < 3; e++)
+                {
+                    float value = tri.b[e] * y + tri.c[e];
+                    if (tri.a[e] > 0.0f)
+                        lo = std::max(lo, -value / tri.a[e]);
+                    else if (tri.a[e] < 0.0f)
+                        hi = std::min(hi, -value / tri.a[e]);
+                    else if (value < 0.0f)
+                        hi = -1.0f;
+                }
+                start[row] = (int)std::ceil(std::clamp(lo - 0.5f, 0.0f, (float)WIDTH));
+                end[row] = (int)std::floor(std::clamp(hi - 0.5f, -1.0f, WIDTH - 1.0f)) + 1;
+            }
+#endif
+
+            int spanBegin = WIDTH, spanEnd = 0;
+            for (int row = 0; row < TILE_HEIGHT; row++)
+            {
+                if (end[row] > start[row])
+                {
+                    spanBegin = std::min(spanBegin, start[row]);
+                    spanEnd = std::max(spanEnd, end[row]);
+                }
+            }
+            if (spanEnd <= spanBegin)
+                continue;
+
+            for (int tileX = spanBegin / TILE_WIDTH; tileX <= (spanEnd - 1) / TILE_WIDTH; tileX++)
+            {
+                const int x0 = tileX * TILE_WIDTH;
+
+                std::uint32_t coverage[4];
+                for (int row = 0; row < TILE_HEIGHT; row++)
+                    coverage[row] = SpanMask(start[row] - x0, end[row] - x0);
+                if ((coverage[0] | coverage[1] | coverage[2] | coverage[3]) == 0u)
+                    continue;
+
+                // Farthest point of the depth plane over the tile, never beyond the farthest vertex;
+                // only the stored value is clamped to the depth range
+                float cornerX = tri.dzdx > 0.0f ? (float)(x0 + TILE_WIDTH) : (float)x0;
+                float cornerY = tri.dzdy > 0.0f ? (float)(y0 + TILE_HEIGHT) : (float)y0;
+                float depth = std::clamp(std::min(tri.zMax, tri.zRef + tri.dzdx * cornerX + tri.dzdy * cornerY), 0.0f, 1.0f);
+
+                UpdateTile(tileRow * TILES_X + tileX, coverage, depth);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::UpdateTile(int tile, const std::uint32_t coverage[4], float depth)
+{
+    float &zMax0 = m_ZMax0[tile];
+    float &zMax1 = m_ZMax1[tile];
+    if (depth >= zMax0)
+        return;
+
+    std::uint32_t *mask = &m_Masks[tile * 4];
+
+#if OCCLUSION_USE_SSE
+    const __m128i full = _mm_set1_epi32(-1);
+    __m128i incoming = _mm_loadu_si128(reinterpret_cast<const __m128i *>(coverage));
+    __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask));
+    auto isFull = [&](__m128i bits)
+    { return _mm_movemask_epi8(_mm_cmpeq_epi32(bits, full)) == 0xFFFF; };
+    auto isEmpty = [&](__m128i bits)
+    { return _mm_movemask_epi8(_mm_cmpeq_epi32(bits, _mm_setzero_si128())) == 0xFFFF; };
+#else
+    std::uint32_t incoming[4] = {coverage[0], coverage[1], coverage[2], coverage[3]};
+    std::uint32_t current[4] = {mask[0], mask[1], mask[2], mask[3]};
+    auto isFull = [](const std::uint32_t *bits)
+    { return (bits[0] & bits[1] & bits[2] & bits[3]) == ~0u; };
+    auto isEmpty = [](const std::uint32_t *bits)
+    { return (bits[0] | bits[1] | bits[2] | bits[3]) == 0u; };
+#endif
+
+    auto clearWorkingLayer = [&]()
+    {
+#if OCCLUSION_USE_SSE
+        current = _mm_setzero_si128();
+#else
+        std::fill(current, current + 4, 0u);
+#endif
+        zMax1 = 0.0f;
+    };
+
+    if (isFull(incoming))
+    {
+        // The triangle alone covers the tile and is nearer than the reference layer
+        zMax0 = depth;
+        if (zMax1 >= zMax0)
+            clearWorkingLayer();
+    }
+    else
+    {
+        // Start a new working layer when the triangle is much nearer than the current one
+        if (!isEmpty(current) && zMax1 - depth > zMax0 - zMax1)
+            clearWorkingLayer();
+
+#if OCCLUSION_USE_SSE
+        current = _mm_or_si128(current, incoming);
+#else
+        for (int row = 0; row < 4; row++)
+            current[row] |= incoming[row];
+#endif
+        zMax1 = std::max(zMax1, depth);
+
+        // A fully covered working layer becomes the new reference layer
+        if (isFull(current))
+        {
+            zMax0 = std::min(zMax0, zMax1);
+            clearWorkingLayer();
+        }
+    }
+
+#if OCCLUSION_USE_SSE
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(mask), current);
+#else
+    std::copy(current, current + 4, mask);
+#endif
+}
+
+bool OcclusionCuller::IsVisible(const AABB &box) const
+{
+    float minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX;
+    float minZ = 1.0f;
+
+    for (int corner = 0; corner < 8; corner++)
+    {
+        glm::vec3 position((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y,
+                           (corner & 4) ? box.max.z : box.min.z);
+        glm::vec4 clip = m_ViewProjection * glm::vec4(position, 1.0f);
+
+        // Boxes reaching past the near plane are never culled
+        if (clip.z < -clip.w || clip.w <= 0.0f)
+            return true;
+
+        float invW = 1.0f / clip.w;
+        float x = (clip.x * invW * 0.5f + 0.5f) * WIDTH;
+        float y = (clip.y * invW * 0.5f + 0.5f) * HEIGHT;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, clip.z * invW * 0.5f + 0.5f);
+    }
+
+    if (maxX < 0.0f || minX >= WIDTH || maxY < 0.0f || minY >= HEIGHT)
+        return true;
+
+    int tileX0 = (int)std::max(minX, 0.0f) / TILE_WIDTH;
+    int tileX1 = (int)std::min(maxX, WIDTH - 1.0f) / TILE_WIDTH;
+    int tileY0 = (int)std::max(minY, 0.0f) / TILE_HEIGHT;
+    int tileY1 = (int)std::min(maxY, HEIGHT - 1.0f) / TILE_HEIGHT;
+
+    // Visible as soon as one tile's reference layer lies behind the box's nearest point
+    for (int tileY = tileY0; tileY <= tileY1; tileY++)
+    {
+        const float *row = &m_ZMax0[tileY * TILES_X];
+        int tileX = tileX0;
+#if OCCLUSION_USE_SSE
+        const __m128 boxDepth = _mm_set1_ps(minZ);
+        for (; tileX + 3 <= tileX1; tileX += 4)
+        {
+            if (_mm_movemask_ps(_mm_cmple_ps(boxDepth, _mm_loadu_ps(row + tileX))) != 0)
+                return true;
+        }
+#endif
+        for (; tileX <= tileX1; tileX++)
+        {
+            if (minZ <= row[tileX])
+                return true;
+        }
+    }
+
+    return false;
+}
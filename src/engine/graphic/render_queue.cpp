@@ -0,0 +1,79 @@
+#include <engine/graphic/render_queue.h>
+
+#include <algorithm>
+#include <cstring>
+
+void RenderQueue::Clear()
+{
+    m_Items.clear();
+}
+
+void RenderQueue::Push(std::uint64_t key, std::uint32_t payload)
+{
+    m_Items.push_back({key, payload});
+}
+
+void RenderQueue::Sort()
+{
+    const std::size_t count = m_Items.size();
+    if (count < 2)
+        return;
+
+    // One pass builds all eight byte histograms; bytes shared by every key are skipped
+    std::uint32_t histograms[8][256];
+    std::memset(histograms, 0, sizeof(histograms));
+
+    for (const RenderItem &item : m_Items)
+    {
+        for (int byte = 0; byte < 8; byte++)
+            histograms[byte][(item.key >> (byte * 8)) & 0xFF]++;
+    }
+
+    m_Scratch.resize(count);
+    RenderItem *src = m_Items.data();
+    RenderItem *dst = m_Scratch.data();
+
+    for (int byte = 0; byte < 8; byte++)
+    {
+        std::uint32_t *histogram = histograms[byte];
+        if (histogram[(src[0].key >> (byte * 8)) & 0xFF] == count)
+            continue;
+
+        std::uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++)
+        {
+            std::uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            std::uint32_t bucket = (src[i].key >> (byte * 8)) & 0xFF;
+            dst[histogram[bucket]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != m_Items.data())
+        m_Items.swap(m_Scratch);
+}
+
+std::uint64_t RenderQueue::MakeKey(RenderPass pass, std::uint32_t shader, std::uint32_t material,
+                                   std::uint32_t mesh, float depth)
+{
+    constexpr std::uint64_t depthMax = (1ull << DEPTH_BITS) - 1;
+    std::uint64_t quantizedDepth = (std::uint64_t)(std::clamp(depth, 0.0f, 1.0f) * (float)depthMax);
+
+    std::uint64_t state = ((std::uint64_t)(shader & ((1u << SHADER_BITS) - 1)) << (MATERIAL_BITS + MESH_BITS)) |
+                          ((std::uint64_t)(material & ((1u << MATERIAL_BITS) - 1)) << MESH_BITS) |
+                          (std::uint64_t)(mesh & ((1u << MESH_BITS) - 1));
+
+    std::uint64_t key = (std::uint64_t)pass << 62;
+    if (pass == RenderPass::Transparent)
+        key |= ((depthMax - quantizedDepth) << (SHADER_BITS + MATERIAL_BITS + MESH_BITS)) | state;
+    else
+        key |= (state << DEPTH_BITS) | quantizedDepth;
+    return key;
+}
@@ -0,0 +1,12 @@
+#include <engine/graphic/render_stats.h>
+
+void RenderStats::Reset()
+{
+    *this = RenderStats{};
+}
+
+RenderStats &RenderStats::Get()
+{
+    static RenderStats stats;
+    return stats;
+}
@@ -1,11 +1,15 @@
 #include <engine/graphic/shader.h>
+#include <engine/graphic/gl_state_cache.h>
 
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+static unsigned int s_NextShaderSortId = 0;
+
 Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath,
                const char *tessControlPath, const char *tessEvalPath)
+    : m_SortId(s_NextShaderSortId++)
 {
     std::string vertexCode;
     std::string fragmentCode;
@@ -68,6 +72,15 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geo
         std::cout << "[Shader] ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: "
                   << e.what() << std::endl;
     }
+    vertexCode = ResolveIncludes(vertexCode, vertexPath);
+    fragmentCode = ResolveIncludes(fragmentCode, fragmentPath);
+    if (geometryPath != nullptr)
+        geometryCode = ResolveIncludes(geometryCode, geometryPath);
+    if (tessControlPath != nullptr)
+        tessControlCode = ResolveIncludes(tessControlCode, tessControlPath);
+    if (tessEvalPath != nullptr)
+        tessEvalCode = ResolveIncludes(tessEvalCode, tessEvalPath);
+
     const char *vShaderCode = vertexCode.c_str();
     const char *fShaderCode = fragmentCode.c_str();
 
@@ -124,75 +137,204 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geo
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
 
+    m_Uniforms.Reflect(ID);
+    m_Instanced = glGetAttribLocation(ID, "instanceModel") >= 0;
+
     glDeleteShader(vertex);
     glDeleteShader(fragment);
     if (geometryPath != nullptr)
         glDeleteShader(geometry);
 }
 
+std::string Shader::ResolveIncludes(const std::string &code, const std::string &path, int depth)
+{
+    if (depth > 8)
+    {
+        std::cout << "[Shader] ERROR::SHADER::INCLUDE_DEPTH_EXCEEDED: " << path << std::endl;
+        return code;
+    }
+
+    std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+    std::stringstream input(code);
+    std::stringstream output;
+    std::string line;
+    bool inBlockComment = false;
+
+    while (std::getline(input, line))
+    {
+        // A directive must be the first token of its line, outside any block comment
+        bool directive = false;
+        if (!inBlockComment)
+        {
+            std::size_t hash = line.find_first_not_of(" \t");
+            std::size_t name = hash == std::string::npos ? hash : line.find_first_not_of(" \t", hash + 1);
+            directive = name != std::string::npos && line[hash] == '#' && line.compare(name, 7, "include") == 0;
+        }
+
+        for (std::size_t i = 0; i + 1 < line.size(); i++)
+        {
+            if (!inBlockComment && line[i] == '/' && line[i + 1] == '/')
+                break;
+            if (line.compare(i, 2, inBlockComment ? "*/" : "/*") == 0)
+            {
+                inBlockComment = !inBlockComment;
+                i++;
+            }
+        }
+
+        std::size_t open = line.find('"');
+        std::size_t close = line.find('"', open + 1);
+        if (!directive || open == std::string::npos || close == std::string::npos)
+        {
+            output << line << "\n";
+            continue;
+        }
+
+        std::string includePath = directory + line.substr(open + 1, close - open - 1);
+        std::ifstream includeFile(includePath);
+        if (!includeFile)
+        {
+            std::cout << "[Shader] ERROR::SHADER::INCLUDE_NOT_FOUND: " << includePath << std::endl;
+            continue;
+        }
+
+        std::stringstream includeStream;
+        includeStream << includeFile.rdbuf();
+        output << ResolveIncludes(includeStream.str(), includePath, depth + 1) << "\n";
+    }
+
+    return output.str();
+}
+
+Shader::~Shader()
+{
+    GLStateCache::Get().ForgetProgram(ID);
+    glDeleteProgram(ID);
+}
+
 void Shader::use()
 {
-    glUseProgram(ID);
+    GLStateCache::Get().UseProgram(ID);
+}
+
+UniformHandle Shader::GetUniform(entt::id_type id) const
+{
+    return m_Uniforms.Find(id);
+}
+
+UniformHandle Shader::GetUniform(const std::string &name) const
+{
+    return m_Uniforms.Find(name);
 }
 
 void Shader::setBool(const std::string &name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(m_Uniforms.Find(name).location, (int)value);
 }
 
 void Shader::setInt(const std::string &name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(m_Uniforms.Find(name).location, value);
 }
 
 void Shader::setFloat(const std::string &name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(m_Uniforms.Find(name).location, value);
 }
 
 void Shader::setVec2(const std::string &name, const glm::vec2 &value) const
 {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform2fv(m_Uniforms.Find(name).location, 1, &value[0]);
 }
 
 void Shader::setVec2(const std::string &name, float x, float y) const
 {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    glUniform2f(m_Uniforms.Find(name).location, x, y);
 }
 
 void Shader::setVec3(const std::string &name, const glm::vec3 &value) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform3fv(m_Uniforms.Find(name).location, 1, &value[0]);
 }
 
 void Shader::setVec3(const std::string &name, float x, float y, float z) const
 {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    glUniform3f(m_Uniforms.Find(name).location, x, y, z);
 }
 
 void Shader::setVec4(const std::string &name, const glm::vec4 &value) const
 {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform4fv(m_Uniforms.Find(name).location, 1, &value[0]);
 }
 
 void Shader::setVec4(const std::string &name, float x, float y, float z, float w)
 {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    glUniform4f(m_Uniforms.Find(name).location, x, y, z, w);
 }
 
 void Shader::setMat2(const std::string &name, const glm::mat2 &mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix2fv(m_Uniforms.Find(name).location, 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(m_Uniforms.Find(name).location, 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(m_Uniforms.Find(name).location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setBool(UniformHandle handle, bool value) const
+{
+    glUniform1i(handle.location, (int)value);
+}
+
+void Shader::setInt(UniformHandle handle, int value) const
+{
+    glUniform1i(handle.location, value);
+}
+
+void Shader::setFloat(UniformHandle handle, float value) const
+{
+    glUniform1f(handle.location, value);
+}
+
+void Shader::setVec2(UniformHandle handle, const glm::vec2 &value) const
+{
+    glUniform2fv(handle.location, 1, &value[0]);
+}
+
+void Shader::setVec3(UniformHandle handle, const glm::vec3 &value) const
+{
+    glUniform3fv(handle.location, 1, &value[0]);
+}
+
+void Shader::setVec4(UniformHandle handle, const glm::vec4 &value) const
+{
+    glUniform4fv(handle.location, 1, &value[0]);
+}
+
+void Shader::setMat2(UniformHandle handle, const glm::mat2 &mat) const
+{
+    glUniformMatrix2fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat3(UniformHandle handle, const glm::mat3 &mat) const
+{
+    glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat4(UniformHandle handle, const glm::mat4 &mat) const
+{
+    glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat4Array(UniformHandle handle, const glm::mat4 *mats, int count) const
+{
+    glUniformMatrix4fv(handle.location, count, GL_FALSE, &mats[0][0][0]);
 }
 
 void Shader::checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,209 @@
+#include <engine/graphic/shadow_map.h>
+#include <engine/graphic/gl_state_cache.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+CascadedShadowMap::CascadedShadowMap(GLsizei resolution)
+    : m_Resolution(resolution)
+{
+    m_LiveTexture = CreateDepthArray();
+    m_CacheTexture = CreateDepthArray();
+
+    // The live array is sampled with hardware depth comparison for PCF
+    GLStateCache::Get().BindTexture(TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, m_LiveTexture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    glGenFramebuffers(1, &m_LiveFramebuffer);
+    glGenFramebuffers(1, &m_CacheFramebuffer);
+    for (GLuint framebuffer : {m_LiveFramebuffer, m_CacheFramebuffer})
+    {
+        GLStateCache::Get().BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+    GLStateCache::Get().BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    m_Buffer = std::make_unique<UniformBuffer>(sizeof(ShadowConstants), SHADOW_DATA_BINDING);
+    m_Buffer->Update(&m_Constants, sizeof(ShadowConstants));
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+    GLStateCache::Get().ForgetFramebuffer(m_LiveFramebuffer);
+    GLStateCache::Get().ForgetFramebuffer(m_CacheFramebuffer);
+    glDeleteFramebuffers(1, &m_LiveFramebuffer);
+    glDeleteFramebuffers(1, &m_CacheFramebuffer);
+
+    GLStateCache::Get().ForgetTexture(m_LiveTexture);
+    GLStateCache::Get().ForgetTexture(m_CacheTexture);
+    glDeleteTextures(1, &m_LiveTexture);
+    glDeleteTextures(1, &m_CacheTexture);
+}
+
+std::uint32_t CascadedShadowMap::Update(const glm::mat4 &cameraView, float fov, float aspect, float nearPlane,
+                                        float farPlane, const glm::vec3 &lightDirection)
+{
+    glm::vec3 direction = glm::normalize(lightDirection);
+    if (direction != m_LightDirection)
+    {
+        m_LightDirection = direction;
+        m_StaticValid = 0;
+    }
+
+    // Practical split scheme: a blend of uniform and logarithmic splits
+    float shadowFar = std::min(farPlane, MAX_DISTANCE);
+    float splits[SHADOW_CASCADE_COUNT];
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; i++)
+    {
+        float p = (float)(i + 1) / SHADOW_CASCADE_COUNT;
+        float logarithmic = nearPlane * std::pow(shadowFar / nearPlane, p);
+        float uniform = nearPlane + (shadowFar - nearPlane) * p;
+        splits[i] = uniform + (logarithmic - uniform) * SPLIT_LAMBDA;
+    }
+
+    glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), direction, up);
+    glm::mat4 inverseView = glm::inverse(cameraView);
+
+    float tanHalfY = std::tan(glm::radians(fov) * 0.5f);
+    float tanHalfX = tanHalfY * aspect;
+
+    float splitNear = nearPlane;
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; i++)
+    {
+        float splitFar = splits[i];
+
+        // Bounding sphere of the slice; its radius only depends on the projection, so it is stable while moving
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int c = 0; c < 8; c++)
+        {
+            float depth = (c & 4) ? splitFar : splitNear;
+            corners[c] = glm::vec3(((c & 1) ? 1.0f : -1.0f) * depth * tanHalfX,
+                                   ((c & 2) ? 1.0f : -1.0f) * depth * tanHalfY, -depth);
+            center += corners[c] / 8.0f;
+        }
+
+        float radius = 0.0f;
+        for (const glm::vec3 &corner : corners)
+            radius = std::max(radius, glm::length(corner - center));
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        float halfSize = radius * (1.0f + SNAP_MARGIN);
+        float texel = 2.0f * halfSize / m_Resolution;
+        float step = std::max(std::floor((halfSize - radius) / texel), 1.0f) * texel;
+
+        glm::vec3 lightCenter = glm::vec3(lightRotation * (inverseView * glm::vec4(center, 1.0f)));
+        lightCenter = glm::floor(lightCenter / step + 0.5f) * step;
+
+        ShadowCascade &cascade = m_Cascades[i];
+        if (cascade.lightSpaceCenter != lightCenter || cascade.halfSize != halfSize)
+            m_StaticValid &= ~(1u << i);
+
+        cascade.lightSpaceCenter = lightCenter;
+        cascade.halfSize = halfSize;
+        cascade.splitFar = splitFar;
+
+        // Light space looks down -z, so casters between the cascade and the light have a larger z
+        glm::mat4 projection = glm::ortho(lightCenter.x - halfSize, lightCenter.x + halfSize,
+                                          lightCenter.y - halfSize, lightCenter.y + halfSize,
+                                          -(lightCenter.z + halfSize + CASTER_PULLBACK), -(lightCenter.z - halfSize));
+        cascade.viewProjection = projection * lightRotation;
+
+        splitNear = splitFar;
+    }
+
+    ShadowConstants constants{};
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; i++)
+    {
+        constants.cascadeViewProjection[i] = m_Cascades[i].viewProjection;
+        constants.cascadeSplits[i] = m_Cascades[i].splitFar;
+        constants.cascadeTexelSizes[i] = 2.0f * m_Cascades[i].halfSize / m_Resolution;
+    }
+    constants.params = glm::vec4(0.0005f, 1.0f, 0.0f, 0.0f);
+
+    if (std::memcmp(&constants, &m_Constants, sizeof(ShadowConstants)) != 0)
+    {
+        m_Constants = constants;
+        m_Buffer->Update(&m_Constants, sizeof(ShadowConstants));
+    }
+
+    return ~m_StaticValid & ((1u << SHADOW_CASCADE_COUNT) - 1);
+}
+
+void CascadedShadowMap::Disable()
+{
+    if (!IsEnabled())
+        return;
+
+    m_Constants.params.y = 0.0f;
+    m_Buffer->Update(&m_Constants, sizeof(ShadowConstants));
+}
+
+void CascadedShadowMap::BeginStaticCascade(int cascade)
+{
+    GLStateCache &cache = GLStateCache::Get();
+    cache.BindFramebuffer(GL_FRAMEBUFFER, m_CacheFramebuffer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_CacheTexture, 0, cascade);
+    cache.SetViewport(0, 0, m_Resolution, m_Resolution);
+
+    // Casters in front of the near plane are clamped instead of clipped
+    cache.SetDepthClamp(true);
+    cache.SetDepthTest(true);
+    cache.SetDepthWrite(true);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void CascadedShadowMap::BeginDynamicCascade(int cascade)
+{
+    GLStateCache &cache = GLStateCache::Get();
+    cache.BindFramebuffer(GL_READ_FRAMEBUFFER, m_CacheFramebuffer);
+    glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_CacheTexture, 0, cascade);
+    cache.BindFramebuffer(GL_DRAW_FRAMEBUFFER, m_LiveFramebuffer);
+    glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_LiveTexture, 0, cascade);
+    glBlitFramebuffer(0, 0, m_Resolution, m_Resolution, 0, 0, m_Resolution, m_Resolution,
+                      GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    cache.BindFramebuffer(GL_FRAMEBUFFER, m_LiveFramebuffer);
+    cache.SetViewport(0, 0, m_Resolution, m_Resolution);
+    cache.SetDepthClamp(true);
+    cache.SetDepthTest(true);
+    cache.SetDepthWrite(true);
+}
+
+void CascadedShadowMap::End()
+{
+    GLStateCache &cache = GLStateCache::Get();
+    cache.SetDepthClamp(false);
+    cache.BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void CascadedShadowMap::Bind() const
+{
+    GLStateCache::Get().BindTexture(TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, m_LiveTexture);
+}
+
+GLuint CascadedShadowMap::CreateDepthArray() const
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+
+    GLStateCache::Get().BindTexture(TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, m_Resolution, m_Resolution, SHADOW_CASCADE_COUNT, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+    const float border[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+    return texture;
+}
@@ -0,0 +1,129 @@
+#include <engine/graphic/skinning_pass.h>
+#include <engine/graphic/bone_palette_buffer.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+#include <engine/utils/filesystem.h>
+
+#include <algorithm>
+
+using namespace entt::literals;
+
+bool IsComputeSkinningSupported()
+{
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+SkinningPass::SkinningPass()
+{
+    m_Shader = std::make_unique<ComputeShader>(FileSystem::getPath("resources/shaders/skinning.comp").c_str());
+
+    m_Uniforms.sourceBase = m_Shader->GetUniform("sourceBase"_hs);
+    m_Uniforms.sourceStride = m_Shader->GetUniform("sourceStride"_hs);
+    m_Uniforms.wideBoneIds = m_Shader->GetUniform("wideBoneIds"_hs);
+    m_Uniforms.outputBase = m_Shader->GetUniform("outputBase"_hs);
+    m_Uniforms.vertexCount = m_Shader->GetUniform("vertexCount"_hs);
+    m_Uniforms.boneOffset = m_Shader->GetUniform("boneOffset"_hs);
+
+    m_Shader->use();
+    m_Shader->setInt(m_Shader->GetUniform("bonePalette"_hs), BonePaletteBuffer::TEXTURE_UNIT);
+}
+
+SkinningPass::~SkinningPass()
+{
+    for (auto &[key, output] : m_Outputs)
+        GeometryArena::Get().FreeVertices(VertexFormat::Static, output.geometry.baseVertex, output.geometry.vertexCount);
+
+    GLStateCache::Get().ForgetProgram(m_Shader->ID);
+    glDeleteProgram(m_Shader->ID);
+}
+
+void SkinningPass::BeginFrame()
+{
+    m_Frame++;
+    m_SkinnedVertices = 0;
+    m_Dispatched = false;
+}
+
+const GeometryAllocation *SkinningPass::Skin(std::uint32_t owner, const Mesh &mesh, int boneOffset, std::size_t lod)
+{
+    const GeometryAllocation &source = mesh.GetGeometry();
+    if (source.format == VertexFormat::Static || !source.IsValid() || boneOffset < 0)
+        return nullptr;
+
+    GeometryArena &arena = GeometryArena::Get();
+    std::uint64_t key = ((std::uint64_t)owner << 32) | mesh.GetSortId();
+
+    Output &output = m_Outputs[key];
+    if (!output.geometry.IsValid())
+    {
+        // Growing the pool copies it, and the copy must see what earlier dispatches wrote
+        if (m_Dispatched)
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        GLint base = arena.AllocateVertices(VertexFormat::Static, source.vertexCount);
+        if (base < 0)
+        {
+            m_Outputs.erase(key);
+            return nullptr;
+        }
+
+        output.geometry = source;
+        output.geometry.format = VertexFormat::Static;
+        output.geometry.baseVertex = base;
+
+        for (const MeshLod &level : mesh.GetLods())
+        {
+            GeometryAllocation geometry = level.geometry;
+            geometry.format = VertexFormat::Static;
+            geometry.baseVertex = base;
+            output.lods.push_back(geometry);
+        }
+    }
+
+    const GeometryAllocation *result =
+        lod == 0 || output.lods.empty() ? &output.geometry : &output.lods[std::min(lod, output.lods.size()) - 1];
+
+    if (output.frame == m_Frame)
+        return result;
+    output.frame = m_Frame;
+
+    const GLsizei sourceStride = GetVertexStride(source.format);
+
+    m_Shader->use();
+    m_Shader->setInt(m_Uniforms.sourceBase, source.baseVertex);
+    m_Shader->setInt(m_Uniforms.sourceStride, sourceStride / 4);
+    m_Shader->setBool(m_Uniforms.wideBoneIds, source.format == VertexFormat::Skinned16);
+    m_Shader->setInt(m_Uniforms.outputBase, output.geometry.baseVertex);
+    m_Shader->setInt(m_Uniforms.vertexCount, (int)source.vertexCount);
+    m_Shader->setInt(m_Uniforms.boneOffset, boneOffset);
+
+    GLStateCache &cache = GLStateCache::Get();
+    cache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, arena.GetVertexBuffer(source.format));
+    cache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, arena.GetVertexBuffer(VertexFormat::Static));
+
+    glDispatchCompute((source.vertexCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+    m_SkinnedVertices += source.vertexCount;
+    RenderStats::Get().verticesSkinned += source.vertexCount;
+    m_Dispatched = true;
+    return result;
+}
+
+void SkinningPass::Flush()
+{
+    if (m_Dispatched)
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+    for (auto it = m_Outputs.begin(); it != m_Outputs.end();)
+    {
+        if (m_Frame - it->second.frame < RELEASE_AFTER_FRAMES)
+        {
+            ++it;
+            continue;
+        }
+
+        GeometryArena::Get().FreeVertices(VertexFormat::Static, it->second.geometry.baseVertex,
+                                          it->second.geometry.vertexCount);
+        it = m_Outputs.erase(it);
+    }
+}
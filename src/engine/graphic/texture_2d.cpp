@@ -0,0 +1,147 @@
+#include <engine/graphic/texture_2d.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/texture_cache.h>
+#include <engine/graphic/texture_cooker.h>
+#include <engine/graphic/upload_queue.h>
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+void ImageData::Free::operator()(unsigned char *pixels) const
+{
+    stbi_image_free(pixels);
+}
+
+std::size_t ImageData::GetSize() const
+{
+    if (!IsCompressed())
+        return (std::size_t)width * height * components;
+
+    std::size_t size = 0;
+    for (const Level &level : levels)
+        size += level.size;
+    return size;
+}
+
+Texture2D::Texture2D(const std::string &path, bool gamma)
+{
+    acquire(path, nullptr, gamma);
+}
+
+Texture2D::Texture2D(const std::string &path, ImageData &image, bool gamma)
+{
+    acquire(path, &image, gamma);
+}
+
+Texture2D::~Texture2D()
+{
+    TextureCache::Get().Release(m_Key);
+}
+
+void Texture2D::acquire(const std::string &path, ImageData *image, bool gamma)
+{
+    m_Key = TextureCache::MakeKey(path, TextureUsage::Color, gamma);
+    CachedTexture texture = TextureCache::Get().Acquire(m_Key, path, TextureUsage::Color, gamma, image);
+    m_Id = texture.id;
+    m_Width = texture.width;
+    m_Height = texture.height;
+    m_GpuBytes = texture.bytes;
+}
+
+ImageData Texture2D::Decode(const std::string &path)
+{
+    ImageData image;
+    image.pixels.reset(stbi_load(path.c_str(), &image.width, &image.height, &image.components, 0));
+    if (!image.pixels)
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        image.width = image.height = image.components = 0;
+    }
+    return image;
+}
+
+std::size_t Texture2D::UploadLevels(GLuint id, const ImageData &image, std::size_t first, std::size_t last, bool gamma)
+{
+    GLenum internalFormat = gamma ? TextureCooker::GetSrgbFormat(image.compressedFormat) : image.compressedFormat;
+    GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, id);
+
+    // The levels are stored one after another in the cooked file, so the whole range goes
+    // through the pixel buffer in one copy
+    const unsigned char *begin = image.levels[first].data;
+    const unsigned char *end = image.levels[last - 1].data + image.levels[last - 1].size;
+    UploadQueue &uploads = UploadQueue::Get();
+    std::uintptr_t base = (std::uintptr_t)uploads.StagePixels(begin, (std::size_t)(end - begin));
+
+    std::size_t size = 0;
+    for (std::size_t i = first; i < last; i++)
+    {
+        const ImageData::Level &level = image.levels[i];
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, internalFormat, level.width, level.height, 0,
+                               (GLsizei)level.size, (const void *)(base + (level.data - begin)));
+        size += level.size;
+    }
+    uploads.EndStaging();
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)first);
+    return size;
+}
+
+GLuint Texture2D::Create(const ImageData &image, bool gamma, std::size_t *bytes, std::size_t firstLevel)
+{
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+
+    std::size_t size = 0;
+    if (image.IsCompressed())
+    {
+        firstLevel = std::min(firstLevel, image.levels.size() - 1);
+        size = UploadLevels(textureID, image, firstLevel, image.levels.size(), gamma);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else if (image.pixels)
+    {
+        GLenum format = GL_RGBA;
+        GLenum internalFormat = gamma ? GL_SRGB8_ALPHA8 : GL_RGBA;
+        if (image.components == 1)
+            format = internalFormat = GL_RED;
+        else if (image.components == 2)
+            format = internalFormat = GL_RG;
+        else if (image.components == 3)
+        {
+            format = GL_RGB;
+            internalFormat = gamma ? GL_SRGB8 : GL_RGB;
+        }
+
+        GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, textureID);
+
+        // Rows are tightly packed, which the default alignment of 4 gets wrong for odd RGB widths
+        UploadQueue &uploads = UploadQueue::Get();
+        const void *pixels = uploads.StagePixels(image.pixels.get(), image.GetSize());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        uploads.EndStaging();
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // Drivers pad RGB to four bytes; the mip chain adds a third
+        std::size_t texelBytes = image.components <= 2 ? image.components : 4;
+        size = (std::size_t)image.width * image.height * texelBytes * 4 / 3;
+    }
+
+    if (bytes)
+        *bytes = size;
+    return textureID;
+}
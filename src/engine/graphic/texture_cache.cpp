@@ -0,0 +1,305 @@
+#include <engine/graphic/texture_cache.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/upload_queue.h>
+#include <engine/core/asset_cooker.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+TextureCache &TextureCache::Get()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+TextureKey TextureCache::MakeKey(const std::string &path, TextureUsage usage, bool gamma)
+{
+    std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+
+    // A missing file has no contents to hash, but its path still names it
+    std::uint64_t hash = AssetCooker::HashFile(normalized);
+    if (!hash)
+        hash = AssetCooker::HashBytes(normalized.data(), normalized.size());
+
+    const std::uint8_t settings[2] = {(std::uint8_t)usage, (std::uint8_t)gamma};
+    return AssetCooker::HashBytes(settings, sizeof(settings), hash);
+}
+
+bool TextureCache::Contains(TextureKey key) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Entries.find(key) != m_Entries.end();
+}
+
+CachedTexture TextureCache::Acquire(TextureKey key, const std::string &path, TextureUsage usage, bool gamma,
+                                    ImageData *image, bool streamed)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Entries.find(key);
+        if (it != m_Entries.end())
+        {
+            it->second.references++;
+            if (!streamed)
+                it->second.tail = 0;
+            return it->second.texture;
+        }
+    }
+
+    // Only the main thread inserts, so nothing can add the key while this uploads
+    ImageData loaded;
+    if (!image || (!image->pixels && !image->IsCompressed()))
+    {
+        loaded = TextureCooker::Load(path, usage);
+        image = &loaded;
+    }
+
+    Entry entry;
+    std::size_t first = 0;
+    if (streamed && image->levels.size() > 1)
+    {
+        entry.streamed = true;
+        entry.path = path;
+        entry.usage = usage;
+        entry.gamma = gamma;
+        entry.format = image->compressedFormat;
+        entry.levels = image->levels;
+        for (ImageData::Level &level : entry.levels)
+            level.data = nullptr;
+
+        while (first + 1 < entry.levels.size() &&
+               std::max(entry.levels[first].width, entry.levels[first].height) > STREAM_TAIL_SIZE)
+            first++;
+        entry.resident = entry.tail = entry.target = entry.requested = first;
+        entry.requestFrame = m_Frame;
+    }
+
+    entry.texture.id = Texture2D::Create(*image, gamma, &entry.texture.bytes, first);
+    entry.texture.width = image->width;
+    entry.texture.height = image->height;
+    entry.references = 1;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Bytes += entry.texture.bytes;
+    return m_Entries.emplace(key, std::move(entry)).first->second.texture;
+}
+
+void TextureCache::Release(TextureKey key)
+{
+    GLuint id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Entries.find(key);
+        if (it == m_Entries.end() || --it->second.references > 0)
+            return;
+
+        id = it->second.texture.id;
+        m_Bytes -= it->second.texture.bytes;
+        m_PendingBytes -= it->second.pendingBytes;
+        m_Entries.erase(it);
+    }
+
+    GLStateCache::Get().ForgetTexture(id);
+    glDeleteTextures(1, &id);
+}
+
+void TextureCache::Clear()
+{
+    // A stream still reading would queue an upload for a texture that is gone
+    JobSystem::Get().Wait(m_Streams);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const auto &[key, entry] : m_Entries)
+    {
+        GLStateCache::Get().ForgetTexture(entry.texture.id);
+        glDeleteTextures(1, &entry.texture.id);
+    }
+    m_Entries.clear();
+    m_Bytes = 0;
+    m_PendingBytes = 0;
+}
+
+void TextureCache::Request(TextureKey key, float pixels)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end() || !it->second.streamed || pixels <= 0.0f)
+        return;
+
+    // The level with about one texel per covered pixel; magnified textures need the top level
+    Entry &entry = it->second;
+    float ratio = (float)std::max(entry.texture.width, entry.texture.height) / pixels;
+    std::size_t level = ratio > 1.0f ? (std::size_t)std::log2(ratio) : 0;
+    level = std::min(level, entry.levels.size() - 1);
+
+    if (entry.requestFrame != m_Frame)
+    {
+        entry.requestFrame = m_Frame;
+        entry.requested = level;
+    }
+    else
+        entry.requested = std::min(entry.requested, level);
+}
+
+void TextureCache::Update()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    std::size_t demand = 0;
+    std::vector<Entry *> droppable;
+    for (auto &[key, entry] : m_Entries)
+    {
+        if (!entry.streamed)
+            continue;
+
+        if (entry.requestFrame == m_Frame)
+            entry.target = entry.requested;
+        else if (m_Frame - entry.requestFrame > STREAM_IDLE_FRAMES)
+            entry.target = entry.tail;
+        entry.target = std::min(entry.target, entry.tail);
+
+        if (entry.pendingBytes)
+            continue;
+        if (entry.target < entry.resident)
+            demand += getRangeBytes(entry, entry.target, entry.resident);
+        if (entry.resident < entry.tail)
+            droppable.push_back(&entry);
+    }
+
+    // Levels finer than any recent request go first to make room for ones that are needed;
+    // needed levels go only when resident textures alone exceed the budget, least recently
+    // requested first
+    std::sort(droppable.begin(), droppable.end(), [](const Entry *a, const Entry *b)
+              {
+        bool unneededA = a->resident < a->target, unneededB = b->resident < b->target;
+        if (unneededA != unneededB)
+            return unneededA;
+        return a->requestFrame < b->requestFrame; });
+
+    for (Entry *entry : droppable)
+    {
+        while (entry->resident < entry->tail)
+        {
+            bool unneeded = entry->resident < entry->target;
+            if (unneeded ? m_Bytes + m_PendingBytes + demand <= m_Budget : m_Bytes <= m_Budget)
+                break;
+            dropLevels(*entry, entry->resident + 1);
+        }
+    }
+
+    // Each texture streams as much of its request as still fits
+    for (auto &[key, entry] : m_Entries)
+    {
+        if (!entry.streamed || entry.pendingBytes || entry.target >= entry.resident)
+            continue;
+
+        std::size_t first = entry.target;
+        while (first < entry.resident &&
+               m_Bytes + m_PendingBytes + getRangeBytes(entry, first, entry.resident) > m_Budget)
+            first++;
+        if (first < entry.resident)
+            stream(key, entry, first);
+    }
+
+    m_Frame++;
+}
+
+std::size_t TextureCache::getRangeBytes(const Entry &entry, std::size_t first, std::size_t last)
+{
+    std::size_t size = 0;
+    for (std::size_t i = first; i < last; i++)
+        size += entry.levels[i].size;
+    return size;
+}
+
+void TextureCache::stream(TextureKey key, Entry &entry, std::size_t first)
+{
+    const std::size_t last = entry.resident;
+    entry.pendingBytes = getRangeBytes(entry, first, last);
+    m_PendingBytes += entry.pendingBytes;
+
+    JobSystem::Get().ScheduleBackground([key, first, last, path = entry.path, usage = entry.usage, format = entry.format,
+                                         levelCount = entry.levels.size(), bytes = entry.pendingBytes]()
+                                        {
+        auto levels = std::make_shared<StreamedLevels>();
+
+        // The file may have been cooked again since the texture was created; a chain that no
+        // longer matches is left alone and the texture keeps what it has
+        ImageData image = TextureCooker::Load(path, usage);
+        std::size_t size = 0;
+        for (std::size_t i = first; i < last && i < image.levels.size(); i++)
+            size += image.levels[i].size;
+
+        if (image.compressedFormat == format && image.levels.size() == levelCount && size == bytes)
+        {
+            // Levels are stored in order, so one copy takes the range with its alignment padding
+            const unsigned char *begin = image.levels[first].data;
+            const unsigned char *end = image.levels[last - 1].data + image.levels[last - 1].size;
+
+            // Copying faults the pages in here rather than during the upload on the main thread
+            levels->storage.assign(begin, end);
+            levels->image.compressedFormat = format;
+            levels->image.width = image.width;
+            levels->image.height = image.height;
+            levels->image.levels = image.levels;
+            for (std::size_t i = 0; i < levelCount; i++)
+            {
+                ImageData::Level &level = levels->image.levels[i];
+                level.data = i >= first && i < last ? levels->storage.data() + (image.levels[i].data - begin) : nullptr;
+            }
+        }
+
+        UploadQueue::Get().Push([key, first, last, levels](std::size_t &uploaded)
+                                {
+            TextureCache::Get().finishStream(key, first, last, *levels);
+            uploaded += levels->storage.size();
+            return true; }); }, &m_Streams);
+}
+
+void TextureCache::finishStream(TextureKey key, std::size_t first, std::size_t last, const StreamedLevels &levels)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end() || !it->second.pendingBytes)
+        return;
+
+    Entry &entry = it->second;
+    m_PendingBytes -= entry.pendingBytes;
+    entry.pendingBytes = 0;
+    if (levels.storage.empty() || entry.resident != last)
+        return;
+
+    std::size_t size = Texture2D::UploadLevels(entry.texture.id, levels.image, first, last, entry.gamma);
+    entry.resident = first;
+    entry.texture.bytes += size;
+    m_Bytes += size;
+}
+
+void TextureCache::dropLevels(Entry &entry, std::size_t base)
+{
+    GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, entry.texture.id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)base);
+
+    // Redefining a level as empty frees its storage; nothing samples above the base level
+    GLenum format = entry.gamma ? TextureCooker::GetSrgbFormat(entry.format) : entry.format;
+    for (std::size_t i = entry.resident; i < base; i++)
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, format, 0, 0, 0, 0, nullptr);
+
+    std::size_t size = getRangeBytes(entry, entry.resident, base);
+    entry.texture.bytes -= size;
+    m_Bytes -= size;
+    entry.resident = base;
+}
+
+std::size_t TextureCache::GetBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Bytes;
+}
+
+std::size_t TextureCache::GetCount() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Entries.size();
+}
@@ -0,0 +1,351 @@
+#include <engine/graphic/texture_cooker.h>
+#include <engine/core/asset_cooker.h>
+
+extern "C"
+{
+#include <image_DXT.h>
+}
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+static float SrgbToLinear(float value)
+{
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSrgb(float value)
+{
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+// One BC4 block from a channel of the 4x4 texels at (blockX, blockY); edge blocks repeat the
+// last row and column. Endpoints are the block's extremes in eight-value mode.
+static void EncodeBC4Block(const unsigned char *pixels, int width, int height, int components, int channel,
+                           int blockX, int blockY, unsigned char *out)
+{
+    unsigned char values[16];
+    int low = 255, high = 0;
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            int px = std::min(blockX + x, width - 1);
+            int py = std::min(blockY + y, height - 1);
+            unsigned char value = pixels[((std::size_t)py * width + px) * components + channel];
+            values[y * 4 + x] = value;
+            low = std::min(low, (int)value);
+            high = std::max(high, (int)value);
+        }
+    }
+
+    // red0 > red1 selects eight values: index 0 is red0, 1 is red1, 2-7 step from red0 to red1
+    out[0] = (unsigned char)high;
+    out[1] = (unsigned char)low;
+
+    std::uint64_t indices = 0;
+    if (high > low)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            int step = (int)std::lround((values[i] - low) * 7.0f / (high - low));
+            std::uint64_t index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+            indices |= index << (3 * i);
+        }
+    }
+
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+ImageData TextureCooker::Load(const std::string &path, TextureUsage usage)
+{
+    std::uint64_t hash = AssetCooker::HashFile(path);
+    std::uint64_t settingsHash = AssetCooker::HashBytes(&usage, sizeof(usage));
+    std::string cookedPath = AssetCooker::GetCookedPath(hash, settingsHash, ".tex");
+
+    ImageData image;
+    if (hash && readCooked(cookedPath, hash, settingsHash, image))
+        return image;
+
+    image = Texture2D::Decode(path);
+    if (!hash || !image.pixels || !cook(image, usage, cookedPath, hash, settingsHash))
+        return image;
+
+    ImageData cooked;
+    if (readCooked(cookedPath, hash, settingsHash, cooked))
+        return cooked;
+    return image;
+}
+
+TextureUsage TextureCooker::GetUsage(const std::string &textureType)
+{
+    if (textureType == "texture_diffuse")
+        return TextureUsage::Color;
+    if (textureType == "texture_normal")
+        return TextureUsage::Normal;
+    return TextureUsage::Data;
+}
+
+GLenum TextureCooker::GetSrgbFormat(GLenum format)
+{
+    if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+        return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+    if (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+        return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+    return format;
+}
+
+std::size_t TextureCooker::GetBlockBytes(GLenum format)
+{
+    switch (format)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RED_RGTC1:
+        return 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RG_RGTC2:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+std::size_t TextureCooker::GetLevelSize(GLenum format, int width, int height)
+{
+    return (std::size_t)((width + 3) / 4) * ((height + 3) / 4) * GetBlockBytes(format);
+}
+
+GLenum TextureCooker::chooseFormat(const ImageData &image, TextureUsage usage)
+{
+    if (usage == TextureUsage::Normal && image.components >= 3)
+        return GL_COMPRESSED_RG_RGTC2;
+
+    switch (image.components)
+    {
+    case 1:
+        return GL_COMPRESSED_RED_RGTC1;
+    case 2:
+        return GL_COMPRESSED_RG_RGTC2;
+    case 3:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    default:
+        break;
+    }
+
+    // Alpha that is opaque everywhere does not need the bigger format
+    const unsigned char *pixels = image.pixels.get();
+    const std::size_t texels = (std::size_t)image.width * image.height;
+    for (std::size_t i = 0; i < texels; i++)
+    {
+        if (pixels[i * 4 + 3] != 255)
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+    return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+std::vector<TextureCooker::Level> TextureCooker::buildMips(const ImageData &image, TextureUsage usage)
+{
+    const int components = image.components;
+    // Alpha is linear even in colour textures
+    const int colorChannels = usage != TextureUsage::Color ? 0 : (components % 2 == 0 ? components - 1 : components);
+    const bool normals = usage == TextureUsage::Normal && components >= 3;
+
+    int width = image.width;
+    int height = image.height;
+    std::vector<float> texels((std::size_t)width * height * components);
+    for (std::size_t i = 0; i < texels.size(); i++)
+    {
+        float value = image.pixels.get()[i] / 255.0f;
+        texels[i] = (int)(i % components) < colorChannels ? SrgbToLinear(value) : value;
+    }
+
+    std::vector<Level> levels;
+    while (true)
+    {
+        Level &level = levels.emplace_back();
+        level.width = width;
+        level.height = height;
+        level.data.resize(texels.size());
+        for (std::size_t i = 0; i < texels.size(); i++)
+        {
+            float value = (int)(i % components) < colorChannels ? LinearToSrgb(texels[i]) : texels[i];
+            level.data[i] = (unsigned char)std::lround(glm::clamp(value, 0.0f, 1.0f) * 255.0f);
+        }
+
+        if ((width == 1 && height == 1) || levels.size() == MAX_LEVELS)
+            break;
+
+        // Box filter over each 2x2 footprint, clamped at odd edges. Each level is filtered from
+        // the previous one at full precision, never from its 8-bit copy.
+        const int nextWidth = std::max(1, width / 2);
+        const int nextHeight = std::max(1, height / 2);
+        std::vector<float> next((std::size_t)nextWidth * nextHeight * components);
+        for (int y = 0; y < nextHeight; y++)
+        {
+            const int y0 = std::min(2 * y, height - 1);
+            const int y1 = std::min(2 * y + 1, height - 1);
+            for (int x = 0; x < nextWidth; x++)
+            {
+                const int x0 = std::min(2 * x, width - 1);
+                const int x1 = std::min(2 * x + 1, width - 1);
+                const float *a = &texels[((std::size_t)y0 * width + x0) * components];
+                const float *b = &texels[((std::size_t)y0 * width + x1) * components];
+                const float *c = &texels[((std::size_t)y1 * width + x0) * components];
+                const float *d = &texels[((std::size_t)y1 * width + x1) * components];
+
+                float *result = &next[((std::size_t)y * nextWidth + x) * components];
+                for (int channel = 0; channel < components; channel++)
+                    result[channel] = 0.25f * (a[channel] + b[channel] + c[channel] + d[channel]);
+
+                // Averaged normals shorten; put them back on the unit sphere
+                if (normals)
+                {
+                    glm::vec3 normal = glm::vec3(result[0], result[1], result[2]) * 2.0f - 1.0f;
+                    float length = glm::length(normal);
+                    if (length > 0.0f)
+                        normal /= length;
+                    normal = normal * 0.5f + 0.5f;
+                    result[0] = normal.x;
+                    result[1] = normal.y;
+                    result[2] = normal.z;
+                }
+            }
+        }
+
+        texels.swap(next);
+        width = nextWidth;
+        height = nextHeight;
+    }
+
+    return levels;
+}
+
+std::vector<unsigned char> TextureCooker::compress(const Level &level, int components, GLenum format)
+{
+    std::vector<unsigned char> result;
+
+    if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+    {
+        int size = 0;
+        unsigned char *blocks = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+                                    ? convert_image_to_DXT1(level.data.data(), level.width, level.height, components, &size)
+                                    : convert_image_to_DXT5(level.data.data(), level.width, level.height, components, &size);
+        if (blocks)
+        {
+            result.assign(blocks, blocks + size);
+            std::free(blocks);
+        }
+        return result;
+    }
+
+    // BC5 is a BC4 block for red followed by one for green
+    const int channels = format == GL_COMPRESSED_RG_RGTC2 ? 2 : 1;
+    result.resize(GetLevelSize(format, level.width, level.height));
+    unsigned char *out = result.data();
+    for (int y = 0; y < level.height; y += 4)
+    {
+        for (int x = 0; x < level.width; x += 4)
+        {
+            for (int channel = 0; channel < channels; channel++, out += 8)
+                EncodeBC4Block(level.data.data(), level.width, level.height, components,
+                               std::min(channel, components - 1), x, y, out);
+        }
+    }
+    return result;
+}
+
+// Layout after the header: format, size, level count, each level's size, then the levels' blocks
+// one after another, largest first
+bool TextureCooker::cook(const ImageData &image, TextureUsage usage, const std::string &cookedPath,
+                         std::uint64_t sourceHash, std::uint64_t settingsHash)
+{
+    const GLenum format = chooseFormat(image, usage);
+    std::vector<Level> levels = buildMips(image, usage);
+
+    std::vector<std::vector<unsigned char>> blocks;
+    for (const Level &level : levels)
+    {
+        blocks.push_back(compress(level, image.components, format));
+        if (blocks.back().size() != GetLevelSize(format, level.width, level.height))
+        {
+            std::cout << "[TextureCooker] Failed to compress " << cookedPath << std::endl;
+            return false;
+        }
+    }
+
+    CookedWriter writer;
+    AssetCooker::WriteHeader(writer, COOKED_MAGIC, sourceHash, settingsHash);
+    writer.Write((std::uint32_t)format);
+    writer.Write((std::int32_t)image.width);
+    writer.Write((std::int32_t)image.height);
+    writer.Write((std::uint32_t)levels.size());
+    for (std::size_t i = 0; i < levels.size(); i++)
+    {
+        writer.Write((std::int32_t)levels[i].width);
+        writer.Write((std::int32_t)levels[i].height);
+        writer.Write((std::uint64_t)blocks[i].size());
+    }
+    for (const std::vector<unsigned char> &level : blocks)
+        writer.WriteArray(level.data(), level.size());
+
+    if (!writer.Save(cookedPath))
+        return false;
+
+    std::cout << "[TextureCooker] Cooked " << cookedPath << " (" << image.width << "x" << image.height << ", "
+              << levels.size() << " levels, " << writer.GetData().size() << " bytes)" << std::endl;
+    return true;
+}
+
+bool TextureCooker::readCooked(const std::string &cookedPath, std::uint64_t sourceHash, std::uint64_t settingsHash,
+                               ImageData &image)
+{
+    MappedFile file;
+    CookedReader reader;
+    if (!AssetCooker::Open(cookedPath, COOKED_MAGIC, sourceHash, settingsHash, file, reader))
+        return false;
+
+    const GLenum format = reader.Read<std::uint32_t>();
+    const int width = reader.Read<std::int32_t>();
+    const int height = reader.Read<std::int32_t>();
+    const std::uint32_t levelCount = reader.Read<std::uint32_t>();
+    if (!GetBlockBytes(format) || width <= 0 || height <= 0 || levelCount == 0 || levelCount > MAX_LEVELS)
+    {
+        std::cout << "[TextureCooker] " << cookedPath << " is damaged, cooking again" << std::endl;
+        return false;
+    }
+
+    std::vector<ImageData::Level> levels(levelCount);
+    for (ImageData::Level &level : levels)
+    {
+        level.width = reader.Read<std::int32_t>();
+        level.height = reader.Read<std::int32_t>();
+        level.size = (std::size_t)reader.Read<std::uint64_t>();
+        if (level.width <= 0 || level.height <= 0 || level.size != GetLevelSize(format, level.width, level.height))
+        {
+            std::cout << "[TextureCooker] " << cookedPath << " is damaged, cooking again" << std::endl;
+            return false;
+        }
+    }
+    for (ImageData::Level &level : levels)
+        level.data = reader.ReadArray(level.size);
+
+    if (!reader.IsValid())
+    {
+        std::cout << "[TextureCooker] " << cookedPath << " is truncated, cooking again" << std::endl;
+        return false;
+    }
+
+    image = ImageData{};
+    image.width = width;
+    image.height = height;
+    image.components = format == GL_COMPRESSED_RED_RGTC1 ? 1 : format == GL_COMPRESSED_RG_RGTC2 ? 2 : format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 3 : 4;
+    image.compressedFormat = format;
+    image.levels = std::move(levels);
+    image.cooked = std::move(file);
+    return true;
+}
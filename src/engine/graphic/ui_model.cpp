@@ -1,12 +1,18 @@
 #include "engine/graphic/ui_model.h"
+#include "engine/graphic/gl_state_cache.h"
+#include "engine/graphic/render_stats.h"
 
 #include <iostream>
 
+using namespace entt::literals;
+
 UIModel::UIModel(UIType type) : m_Type(type) {
     InitQuad();
 }
 
 UIModel::~UIModel() {
+    GLStateCache::Get().ForgetVertexArray(VAO);
+    GLStateCache::Get().ForgetBuffer(VBO);
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
 }
@@ -30,28 +36,34 @@ void UIModel::InitQuad() {
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLStateCache &cache = GLStateCache::Get();
+    cache.BindVertexArray(VAO);
+    cache.BindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     
-    glBindVertexArray(0);
+    cache.BindVertexArray(0);
 }
 
 void UIModel::Draw(Shader& shader, const glm::vec4& color) {
     if (m_Type == UIType::Transparent) return;
 
-    shader.setVec4("spriteColor", color);
+    if (m_UniformProgram != shader.ID) {
+        m_SpriteColor = shader.GetUniform("spriteColor"_hs);
+        m_HasTexture = shader.GetUniform("hasTexture"_hs);
+        m_UniformProgram = shader.ID;
+    }
+
+    shader.setVec4(m_SpriteColor, color);
 
-    shader.setInt("hasTexture", (m_Type == UIType::Texture)); 
+    shader.setInt(m_HasTexture, (m_Type == UIType::Texture)); 
     if (m_Type == UIType::Texture) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, m_TextureID);
+        GLStateCache::Get().BindTexture(0, GL_TEXTURE_2D, m_TextureID);
     }
 
-    glBindVertexArray(VAO);
+    GLStateCache::Get().BindVertexArray(VAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    RenderStats::Get().drawCalls++;
 }
\ No newline at end of file
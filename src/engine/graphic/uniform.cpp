@@ -0,0 +1,106 @@
+#include <engine/graphic/uniform.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/material.h>
+#include <engine/graphic/render_stats.h>
+#include <engine/graphic/uniform_buffer.h>
+
+#include <vector>
+
+void UniformTable::Reflect(GLuint program)
+{
+    m_Uniforms.clear();
+
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+
+        std::string name(buffer.data(), length);
+        GLint location = glGetUniformLocation(program, name.c_str());
+
+        // Members of uniform blocks have no location
+        if (location < 0)
+            continue;
+
+        std::size_t bracket = name.find('[');
+        if (bracket == std::string::npos || name.back() != ']')
+        {
+            Add(name, {location, type, size});
+
+            GLint unit = GetSamplerUnit(name);
+            if (unit >= 0)
+            {
+                GLStateCache::Get().UseProgram(program);
+                glUniform1i(location, unit);
+            }
+            continue;
+        }
+
+        // Arrays are reported as "name[0]"; register the base name and every element
+        std::string base = name.substr(0, bracket);
+        Add(base, {location, type, size});
+        Add(name, {location, type, size});
+
+        for (GLint element = 1; element < size; element++)
+        {
+            std::string elementName = base + "[" + std::to_string(element) + "]";
+            GLint elementLocation = glGetUniformLocation(program, elementName.c_str());
+            if (elementLocation >= 0)
+                Add(elementName, {elementLocation, type, 1});
+        }
+    }
+
+    GLint blockCount = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+
+    for (GLint i = 0; i < blockCount; i++)
+    {
+        GLint nameLength = 0;
+        glGetActiveUniformBlockiv(program, (GLuint)i, GL_UNIFORM_BLOCK_NAME_LENGTH, &nameLength);
+
+        std::vector<GLchar> blockName(nameLength > 0 ? nameLength : 1);
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(program, (GLuint)i, (GLsizei)blockName.size(), &length, blockName.data());
+
+        GLint binding = GetUniformBlockBinding(std::string(blockName.data(), length));
+        if (binding >= 0)
+            glUniformBlockBinding(program, (GLuint)i, (GLuint)binding);
+    }
+}
+
+UniformHandle UniformTable::Find(entt::id_type id) const
+{
+    RenderStats::Get().uniformLookups++;
+
+    auto it = m_Uniforms.find(id);
+    if (it == m_Uniforms.end())
+        return UniformHandle{};
+    return UniformHandle{it->second.location};
+}
+
+UniformHandle UniformTable::Find(const std::string &name) const
+{
+    return Find(entt::hashed_string::value(name.c_str(), name.size()));
+}
+
+const UniformInfo *UniformTable::GetInfo(entt::id_type id) const
+{
+    auto it = m_Uniforms.find(id);
+    if (it == m_Uniforms.end())
+        return nullptr;
+    return &it->second;
+}
+
+void UniformTable::Add(const std::string &name, const UniformInfo &info)
+{
+    m_Uniforms[entt::hashed_string::value(name.c_str(), name.size())] = info;
+}
@@ -0,0 +1,82 @@
+#include <engine/graphic/uniform_buffer.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+
+#include <algorithm>
+#include <cstring>
+
+GLint GetUniformBlockBinding(const std::string &blockName)
+{
+    if (blockName == "FrameConstants")
+        return FRAME_CONSTANTS_BINDING;
+    if (blockName == "MaterialParams")
+        return MATERIAL_PARAMS_BINDING;
+    if (blockName == "ShadowData")
+        return SHADOW_DATA_BINDING;
+    return -1;
+}
+
+UniformBuffer::UniformBuffer(GLsizeiptr size, GLuint binding)
+    : m_Binding(binding), m_Size(size), m_Shadow(size)
+{
+    glGenBuffers(1, &m_ID);
+    GLStateCache::Get().BindBuffer(GL_UNIFORM_BUFFER, m_ID);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+
+    GLStateCache::Get().BindBufferBase(GL_UNIFORM_BUFFER, m_Binding, m_ID);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    GLStateCache::Get().ForgetBuffer(m_ID);
+    glDeleteBuffers(1, &m_ID);
+}
+
+void UniformBuffer::Update(const void *data, GLsizeiptr size, GLintptr offset)
+{
+    GLStateCache::Get().BindBuffer(GL_UNIFORM_BUFFER, m_ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    RenderStats::Get().bytesUploaded += (unsigned int)size;
+
+    if (offset >= 0 && offset + size <= m_Size)
+        std::memcpy(m_Shadow.data() + offset, data, size);
+}
+
+GLsizeiptr UniformBuffer::Patch(const void *data)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+
+    if (!m_ShadowValid)
+    {
+        m_ShadowValid = true;
+        Update(data, m_Size);
+        return m_Size;
+    }
+
+    const GLsizeiptr row = 16;
+    GLsizeiptr uploaded = 0;
+    GLsizeiptr runStart = -1;
+
+    for (GLsizeiptr offset = 0; offset < m_Size; offset += row)
+    {
+        GLsizeiptr length = std::min(row, m_Size - offset);
+        bool changed = std::memcmp(bytes + offset, m_Shadow.data() + offset, length) != 0;
+
+        if (changed && runStart < 0)
+            runStart = offset;
+        else if (!changed && runStart >= 0)
+        {
+            Update(bytes + runStart, offset - runStart, runStart);
+            uploaded += offset - runStart;
+            runStart = -1;
+        }
+    }
+
+    if (runStart >= 0)
+    {
+        Update(bytes + runStart, m_Size - runStart, runStart);
+        uploaded += m_Size - runStart;
+    }
+
+    return uploaded;
+}
@@ -0,0 +1,110 @@
+#include <engine/graphic/upload_queue.h>
+#include <engine/graphic/gl_state_cache.h>
+#include <engine/graphic/render_stats.h>
+
+#include <cstring>
+
+UploadQueue &UploadQueue::Get()
+{
+    static UploadQueue queue;
+    return queue;
+}
+
+void UploadQueue::Push(Task task)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Tasks.push_back(std::move(task));
+}
+
+void UploadQueue::Process()
+{
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    std::size_t bytes = 0;
+
+    // At least one step always runs, so an oversized step cannot stall the queue
+    do
+    {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Tasks.empty())
+                return;
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+
+        // Only this thread pops, so an unfinished task goes back to the front in order
+        if (!task(bytes))
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.push_front(std::move(task));
+        }
+    } while (bytes < m_ByteBudget &&
+             std::chrono::duration<double, std::milli>(Clock::now() - start).count() < m_TimeBudget);
+}
+
+void UploadQueue::Clear()
+{
+    std::deque<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        tasks.swap(m_Tasks);
+    }
+    // Dropped tasks may free GL objects, so this runs before the pixel buffer goes too
+    tasks.clear();
+
+    if (m_PixelBuffer)
+    {
+        GLStateCache::Get().ForgetBuffer(m_PixelBuffer);
+        glDeleteBuffers(1, &m_PixelBuffer);
+        m_PixelBuffer = 0;
+    }
+}
+
+void UploadQueue::SetBudget(double milliseconds, std::size_t bytes)
+{
+    m_TimeBudget = milliseconds;
+    m_ByteBudget = bytes;
+}
+
+std::size_t UploadQueue::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Tasks.size();
+}
+
+const void *UploadQueue::StagePixels(const void *pixels, std::size_t bytes)
+{
+    GLStateCache &cache = GLStateCache::Get();
+    if (!m_PixelBuffer)
+        glGenBuffers(1, &m_PixelBuffer);
+    cache.BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer);
+
+    // Orphaning hands the driver fresh storage, so this never waits for the previous transfer;
+    // the texture upload itself then runs as a DMA out of the buffer
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STREAM_DRAW);
+    void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mapped)
+    {
+        cache.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return pixels;
+    }
+
+    std::memcpy(mapped, pixels, bytes);
+    if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+    {
+        cache.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return pixels;
+    }
+
+    RenderStats::Get().bytesUploaded += bytes;
+    return nullptr;
+}
+
+void UploadQueue::EndStaging()
+{
+    GLStateCache::Get().BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
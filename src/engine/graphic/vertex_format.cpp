@@ -0,0 +1,200 @@
+#include <engine/graphic/vertex_format.h>
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+static const VertexFormatDescriptor s_Descriptors[VERTEX_FORMAT_COUNT] = {
+    {sizeof(StaticVertex),
+     4,
+     {{
+         {0, 3, GL_FLOAT, GL_FALSE, false, offsetof(StaticVertex, position)},
+         {1, 2, GL_SHORT, GL_TRUE, false, offsetof(StaticVertex, normal)},
+         {2, 2, GL_HALF_FLOAT, GL_FALSE, false, offsetof(StaticVertex, texCoords)},
+         {3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, false, offsetof(StaticVertex, tangent)},
+     }}},
+    {sizeof(SkinnedVertex),
+     6,
+     {{
+         {0, 3, GL_FLOAT, GL_FALSE, false, offsetof(SkinnedVertex, base.position)},
+         {1, 2, GL_SHORT, GL_TRUE, false, offsetof(SkinnedVertex, base.normal)},
+         {2, 2, GL_HALF_FLOAT, GL_FALSE, false, offsetof(SkinnedVertex, base.texCoords)},
+         {3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, false, offsetof(SkinnedVertex, base.tangent)},
+         {5, 4, GL_UNSIGNED_BYTE, GL_FALSE, true, offsetof(SkinnedVertex, boneIds)},
+         {6, 4, GL_UNSIGNED_BYTE, GL_TRUE, false, offsetof(SkinnedVertex, weights)},
+     }}},
+    {sizeof(Skinned16Vertex),
+     6,
+     {{
+         {0, 3, GL_FLOAT, GL_FALSE, false, offsetof(Skinned16Vertex, base.position)},
+         {1, 2, GL_SHORT, GL_TRUE, false, offsetof(Skinned16Vertex, base.normal)},
+         {2, 2, GL_HALF_FLOAT, GL_FALSE, false, offsetof(Skinned16Vertex, base.texCoords)},
+         {3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, false, offsetof(Skinned16Vertex, base.tangent)},
+         {5, 4, GL_UNSIGNED_SHORT, GL_FALSE, true, offsetof(Skinned16Vertex, boneIds)},
+         {6, 4, GL_UNSIGNED_BYTE, GL_TRUE, false, offsetof(Skinned16Vertex, weights)},
+     }}},
+};
+
+const VertexFormatDescriptor &GetVertexFormatDescriptor(VertexFormat format)
+{
+    return s_Descriptors[(std::size_t)format];
+}
+
+GLsizei GetVertexStride(VertexFormat format)
+{
+    return GetVertexFormatDescriptor(format).stride;
+}
+
+VertexFormat ChooseVertexFormat(const std::vector<Vertex> &vertices)
+{
+    bool skinned = false;
+    int maxBone = 0;
+    for (const Vertex &vertex : vertices)
+    {
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            if (vertex.m_BoneIDs[i] < 0 || vertex.m_Weights[i] <= 0.0f)
+                continue;
+            skinned = true;
+            maxBone = std::max(maxBone, vertex.m_BoneIDs[i]);
+        }
+    }
+
+    if (!skinned)
+        return VertexFormat::Static;
+    return maxBone < 256 ? VertexFormat::Skinned : VertexFormat::Skinned16;
+}
+
+static std::int16_t PackSnorm16(float value)
+{
+    return (std::int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+static void PackOctahedral(const glm::vec3 &normal, std::int16_t out[2])
+{
+    glm::vec3 n = normal / std::max(std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z), 1e-8f);
+    glm::vec2 encoded(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        encoded.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        encoded.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    out[0] = PackSnorm16(encoded.x);
+    out[1] = PackSnorm16(encoded.y);
+}
+
+static std::uint32_t PackTangent(const Vertex &vertex)
+{
+    glm::vec3 tangent = vertex.Tangent;
+    float length = glm::length(tangent);
+    tangent = length > 1e-8f ? tangent / length : glm::vec3(1.0f, 0.0f, 0.0f);
+
+    // w stores the bitangent sign; -2 and 1 decode to -1/+1 under both GL normalisation rules
+    float handedness = glm::dot(glm::cross(vertex.Normal, tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+
+    auto pack10 = [](float value)
+    { return (std::uint32_t)((int)std::lround(std::clamp(value, -1.0f, 1.0f) * 511.0f) & 0x3FF); };
+
+    std::uint32_t w = handedness < 0.0f ? 0x2u : 0x1u;
+    return pack10(tangent.x) | (pack10(tangent.y) << 10) | (pack10(tangent.z) << 20) | (w << 30);
+}
+
+static StaticVertex PackStatic(const Vertex &vertex)
+{
+    StaticVertex packed;
+    packed.position = vertex.Position;
+    PackOctahedral(vertex.Normal, packed.normal);
+    packed.tangent = PackTangent(vertex);
+    packed.texCoords[0] = glm::packHalf1x16(vertex.TexCoords.x);
+    packed.texCoords[1] = glm::packHalf1x16(vertex.TexCoords.y);
+    return packed;
+}
+
+// Quantises weights so they always sum to exactly 255; the rounding error goes to the largest weight
+template <typename BoneId>
+static void PackSkin(const Vertex &vertex, BoneId boneIds[MAX_BONE_INFLUENCE], std::uint8_t weights[MAX_BONE_INFLUENCE])
+{
+    float total = 0.0f;
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+    {
+        if (vertex.m_BoneIDs[i] >= 0 && vertex.m_Weights[i] > 0.0f)
+            total += vertex.m_Weights[i];
+    }
+
+    int sum = 0;
+    int largest = 0;
+    for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+    {
+        bool used = total > 0.0f && vertex.m_BoneIDs[i] >= 0 && vertex.m_Weights[i] > 0.0f;
+        boneIds[i] = used ? (BoneId)vertex.m_BoneIDs[i] : 0;
+        weights[i] = used ? (std::uint8_t)std::lround(vertex.m_Weights[i] / total * 255.0f) : 0;
+        sum += weights[i];
+        if (weights[i] > weights[largest])
+            largest = i;
+    }
+
+    if (sum > 0)
+        weights[largest] = (std::uint8_t)(weights[largest] + 255 - sum);
+}
+
+std::vector<unsigned char> PackVertices(VertexFormat format, const std::vector<Vertex> &vertices)
+{
+    const GLsizei stride = GetVertexStride(format);
+    std::vector<unsigned char> bytes(vertices.size() * stride);
+
+    for (std::size_t i = 0; i < vertices.size(); i++)
+    {
+        unsigned char *dst = bytes.data() + i * stride;
+        switch (format)
+        {
+        case VertexFormat::Static:
+        {
+            StaticVertex packed = PackStatic(vertices[i]);
+            std::memcpy(dst, &packed, sizeof(packed));
+            break;
+        }
+        case VertexFormat::Skinned:
+        {
+            SkinnedVertex packed;
+            packed.base = PackStatic(vertices[i]);
+            PackSkin(vertices[i], packed.boneIds, packed.weights);
+            std::memcpy(dst, &packed, sizeof(packed));
+            break;
+        }
+        case VertexFormat::Skinned16:
+        default:
+        {
+            Skinned16Vertex packed;
+            packed.base = PackStatic(vertices[i]);
+            PackSkin(vertices[i], packed.boneIds, packed.weights);
+            std::memcpy(dst, &packed, sizeof(packed));
+            break;
+        }
+        }
+    }
+
+    return bytes;
+}
+
+void SetupVertexAttributes(VertexFormat format)
+{
+    const VertexFormatDescriptor &descriptor = GetVertexFormatDescriptor(format);
+
+    for (std::uint32_t i = 0; i < descriptor.attributeCount; i++)
+    {
+        const VertexAttribute &attribute = descriptor.attributes[i];
+        glEnableVertexAttribArray(attribute.location);
+        if (attribute.integer)
+            glVertexAttribIPointer(attribute.location, attribute.size, attribute.type, descriptor.stride,
+                                   (void *)(std::uintptr_t)attribute.offset);
+        else
+            glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized,
+                                  descriptor.stride, (void *)(std::uintptr_t)attribute.offset);
+    }
+
+    // Formats without skin data read the current generic values; zero weights mean unskinned
+    glVertexAttrib4f(6, 0.0f, 0.0f, 0.0f, 0.0f);
+}